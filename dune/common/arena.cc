@@ -0,0 +1,61 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#include <algorithm>
+#include <cstddef>
+
+#include <dune/common/arena.hh>
+
+namespace Dune {
+
+  namespace {
+
+    // alignment of the chunks
+    constexpr std::size_t chunkAlignment = 64;
+
+  } // end anonymous namespace
+
+  void ArenaResource::release ()
+  {
+    for (const Chunk& chunk : chunks_)
+      upstream_->deallocate(chunk.data, chunk.size, chunkAlignment);
+    chunks_.clear();
+    current_ = 0;
+    offset_ = 0;
+  }
+
+  std::size_t ArenaResource::capacity () const
+  {
+    std::size_t size = 0;
+    for (const Chunk& chunk : chunks_)
+      size += chunk.size;
+    return size;
+  }
+
+  void* ArenaResource::allocateFromNextChunk (std::size_t bytes, std::size_t alignment)
+  {
+    // the remainder of the current chunk is left unused, continue with the
+    // first of the following chunks which is large enough
+    const std::size_t required = bytes + std::max(alignment, chunkAlignment) - chunkAlignment;
+    std::size_t next = (current_ < chunks_.size()) ? current_ + 1 : chunks_.size();
+    while (next < chunks_.size() && chunks_[next].size < required)
+      ++next;
+
+    if (next == chunks_.size()) {
+      const std::size_t size = std::max(nextSize_, required);
+      chunks_.reserve(chunks_.size() + 1);
+      chunks_.push_back({ upstream_->allocate(size, chunkAlignment), size });
+      nextSize_ = 2*size;
+    }
+
+    current_ = next;
+    offset_ = 0;
+    return do_allocate(bytes, alignment);
+  }
+
+  ArenaResource& ArenaResource::threadLocal ()
+  {
+    thread_local ArenaResource arena;
+    return arena;
+  }
+
+} // end namespace Dune
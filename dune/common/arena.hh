@@ -0,0 +1,189 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_ARENA_HH
+#define DUNE_COMMON_ARENA_HH
+
+/** \file
+ * \brief A monotonic memory resource for short-lived temporaries
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  /** \brief A monotonic memory resource which can be rewound
+   *
+   * Memory is handed out from large chunks by incrementing an offset,
+   * deallocation does nothing.  The state of the arena can be saved by
+   * mark() and restored by rewind(), which makes all memory allocated in
+   * between available again without returning it to the upstream resource.
+   * Hence, after the first iteration of a loop, temporaries allocated
+   * within a rewound scope cost a pointer increment only.
+   *
+   * Usually, the arena is used through ArenaScope and a std::pmr container,
+   * e.g. pmr::DynamicVector:
+   * \code
+   * for (const auto& element : elements) {
+   *   Dune::ArenaScope scope;
+   *   Dune::pmr::DynamicVector<double> r(n, scope.allocator<double>());
+   *   ...
+   * }
+   * \endcode
+   *
+   * An arena is not thread-safe, every thread uses its own one, see
+   * threadLocal().
+   */
+  class ArenaResource : public std::pmr::memory_resource
+  {
+  public:
+    //! the state of an arena, see mark() and rewind()
+    struct Marker
+    {
+      std::size_t chunk;
+      std::size_t offset;
+    };
+
+    /** \brief Create an empty arena
+     *
+     * \param initialSize  size in bytes of the first chunk, the size of
+     *                     every further chunk is doubled
+     * \param upstream     resource providing the chunks
+     */
+    explicit ArenaResource (std::size_t initialSize = 65536,
+                            std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream_(upstream), nextSize_(initialSize > 0 ? initialSize : 1)
+    {}
+
+    //! return all chunks to the upstream resource
+    ~ArenaResource ()
+    {
+      release();
+    }
+
+    ArenaResource (const ArenaResource&) = delete;
+    ArenaResource& operator= (const ArenaResource&) = delete;
+
+    //! the current state of the arena
+    Marker mark () const
+    {
+      return { current_, offset_ };
+    }
+
+    /** \brief Restore a state returned by mark()
+     *
+     * All memory allocated after the call of mark() is reused by subsequent
+     * allocations, objects living in it must have been destroyed.
+     */
+    void rewind (const Marker& marker)
+    {
+      current_ = marker.chunk;
+      offset_ = marker.offset;
+    }
+
+    //! make the whole memory of the arena available again
+    void reset ()
+    {
+      rewind({ 0, 0 });
+    }
+
+    //! return all chunks to the upstream resource
+    void release ();
+
+    //! the total size in bytes of the chunks held by the arena
+    std::size_t capacity () const;
+
+    //! the arena of the calling thread
+    static ArenaResource& threadLocal ();
+
+  protected:
+    void* do_allocate (std::size_t bytes, std::size_t alignment) override
+    {
+      if (current_ < chunks_.size()) {
+        const Chunk& chunk = chunks_[current_];
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.data);
+        const std::uintptr_t p = (base + offset_ + alignment - 1) & ~std::uintptr_t(alignment - 1);
+        if (p + bytes <= base + chunk.size) {
+          offset_ = p + bytes - base;
+          return reinterpret_cast<void*>(p);
+        }
+      }
+      return allocateFromNextChunk(bytes, alignment);
+    }
+
+    void do_deallocate (void*, std::size_t, std::size_t) override
+    {}
+
+    bool do_is_equal (const std::pmr::memory_resource& other) const noexcept override
+    {
+      return this == &other;
+    }
+
+  private:
+    struct Chunk
+    {
+      void* data;
+      std::size_t size;
+    };
+
+    void* allocateFromNextChunk (std::size_t bytes, std::size_t alignment);
+
+    std::pmr::memory_resource* upstream_;
+    std::size_t nextSize_;
+    std::vector<Chunk> chunks_;
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0;
+  };
+
+  /** \brief Rewind an arena at the end of a scope
+   *
+   * All memory allocated from the arena during the lifetime of the scope
+   * is reused after the scope has been destroyed.  Containers using the
+   * arena have to be declared after the scope object, so they are
+   * destroyed first.  Scopes can be nested.
+   */
+  class ArenaScope
+  {
+  public:
+    explicit ArenaScope (ArenaResource& arena = ArenaResource::threadLocal())
+      : arena_(arena), marker_(arena.mark())
+    {}
+
+    ~ArenaScope ()
+    {
+      arena_.rewind(marker_);
+    }
+
+    ArenaScope (const ArenaScope&) = delete;
+    ArenaScope& operator= (const ArenaScope&) = delete;
+
+    //! the arena of this scope
+    ArenaResource& resource () const
+    {
+      return arena_;
+    }
+
+    //! an allocator allocating from the arena of this scope
+    template<class T>
+    std::pmr::polymorphic_allocator<T> allocator () const
+    {
+      return std::pmr::polymorphic_allocator<T>(&arena_);
+    }
+
+  private:
+    ArenaResource& arena_;
+    ArenaResource::Marker marker_;
+  };
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_ARENA_HH
@@ -0,0 +1,627 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_BLOCKVECTOR_HH
+#define DUNE_COMMON_BLOCKVECTOR_HH
+
+/** \file
+ * \brief A vector of a dynamic number of blocks, e.g., of FieldVectors
+ *
+ * BlockVector<B> holds the unknowns of systems with several unknowns per
+ * node, e.g. BlockVector<FieldVector<double,3> > for three unknowns.  Its
+ * arithmetic and norms are defined recursively by those of the blocks, so
+ * that blocks may themselves be blocked:
+ * \code
+ * Dune::BlockVector<Dune::FieldVector<double,3> > u(n), v(n);
+ * u.axpy(0.5, v);                 // u[i].axpy(0.5, v[i]) for all i
+ * auto d = u.dot(v);              // sum of Dune::dot(u[i], v[i])
+ * \endcode
+ *
+ * If the blocks are FieldVectors of arithmetic entries, the blocks lie
+ * contiguously in memory without gaps, and the kernels run over the
+ * flattened array of entries instead of recursing.  The element-wise
+ * operations give the same results as the recursion.  The reductions
+ * keep Impl::flatLanes() interleaved partial sums, so that they vectorize,
+ * and differ from the recursion by rounding only.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/dotproduct.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  template<class B, class A> class BlockVector;
+
+  template<class B, class A>
+  struct FieldTraits< BlockVector<B,A> >
+  {
+    typedef typename FieldTraits<B>::field_type field_type;
+    typedef typename FieldTraits<B>::real_type real_type;
+  };
+
+  namespace Impl {
+
+    //! the block level of B, 0 for scalars
+    template<class B, class = void>
+    struct BlockLevel : std::integral_constant<int, 0> {};
+
+    template<class B>
+    struct BlockLevel<B, std::void_t<decltype(B::blocklevel)> >
+      : std::integral_constant<int, B::blocklevel> {};
+
+    // the norms of a block, given by those of the entries for scalar blocks
+
+    template<class B>
+    typename FieldTraits<B>::real_type blockOneNorm (const B& b)
+    {
+      if constexpr (IsNumber<B>::value) {
+        using std::abs;
+        return abs(b);
+      }
+      else
+        return b.one_norm();
+    }
+
+    template<class B>
+    typename FieldTraits<B>::real_type blockOneNormReal (const B& b)
+    {
+      if constexpr (IsNumber<B>::value)
+        return fvmeta::absreal(b);
+      else
+        return b.one_norm_real();
+    }
+
+    template<class B>
+    typename FieldTraits<B>::real_type blockTwoNorm2 (const B& b)
+    {
+      if constexpr (IsNumber<B>::value)
+        return fvmeta::abs2(b);
+      else
+        return b.two_norm2();
+    }
+
+    template<class B>
+    typename FieldTraits<B>::real_type blockInfinityNorm (const B& b)
+    {
+      if constexpr (IsNumber<B>::value) {
+        using std::abs;
+        return abs(b);
+      }
+      else
+        return b.infinity_norm();
+    }
+
+    template<class B>
+    typename FieldTraits<B>::real_type blockInfinityNormReal (const B& b)
+    {
+      if constexpr (IsNumber<B>::value)
+        return fvmeta::absreal(b);
+      else
+        return b.infinity_norm_real();
+    }
+
+    /** \brief Whether arrays of blocks B can be processed as flat arrays of scalars
+     *
+     * This holds for FieldVectors of arithmetic entries without padding.
+     */
+    template<class B>
+    struct IsFlatBlock : std::false_type
+    {
+      typedef B scalar_type;
+      static constexpr std::size_t size = 1;
+    };
+
+    template<class K, int n>
+    struct IsFlatBlock< FieldVector<K,n> >
+      : std::integral_constant<bool, std::is_arithmetic<K>::value
+                                       && std::is_trivially_copyable<FieldVector<K,n> >::value
+                                       && sizeof(FieldVector<K,n>) == n*sizeof(K)>
+    {
+      typedef K scalar_type;
+      static constexpr std::size_t size = n;
+    };
+
+    //! number of interleaved partial results of the flattened reductions, two vector registers of R
+    template<class R>
+    constexpr std::size_t flatLanes ()
+    {
+#if defined(__AVX512F__)
+      constexpr std::size_t bytes = 128;
+#elif defined(__AVX__)
+      constexpr std::size_t bytes = 64;
+#else
+      constexpr std::size_t bytes = 32;
+#endif
+      return sizeof(R) < bytes ? bytes / sizeof(R) : 1;
+    }
+
+    /** \brief the sum of term(i) for i = 0,...,n-1 in flatLanes<R>() interleaved partial sums
+     *
+     * The term is taken by value, so that its captures stay in registers
+     * even if the kernel is not inlined.
+     */
+    template<class R, class F>
+    R flatSum (std::size_t n, F term)
+    {
+      constexpr std::size_t L = flatLanes<R>();
+      R sum[L] = {};
+      std::size_t i = 0;
+      for (; i + L <= n; i += L)
+        for (std::size_t l = 0; l < L; ++l)
+          sum[l] += term(i+l);
+      for (std::size_t l = 0; i + l < n; ++l)
+        sum[l] += term(i+l);
+
+      R result = sum[0];
+      for (std::size_t l = 1; l < L; ++l)
+        result += sum[l];
+      return result;
+    }
+
+    //! the maximum of a(i) >= 0 for i = 0,...,n-1, NaN if one of them is NaN
+    template<class R, class F>
+    R flatMax (std::size_t n, F a)
+    {
+      using std::max;
+      constexpr std::size_t L = flatLanes<R>();
+      R norm[L] = {}, isNaN[L] = {};
+      auto update = [&] (std::size_t i, std::size_t l) {
+        const R ai = a(i);
+        norm[l] = max(ai, norm[l]);
+        isNaN[l] += ai;
+      };
+      std::size_t i = 0;
+      for (; i + L <= n; i += L)
+        for (std::size_t l = 0; l < L; ++l)
+          update(i+l, l);
+      for (std::size_t l = 0; i + l < n; ++l)
+        update(i+l, l);
+
+      R result = norm[0], nan = isNaN[0] + R(1);
+      for (std::size_t l = 1; l < L; ++l) {
+        result = max(norm[l], result);
+        nan += isNaN[l];
+      }
+      if constexpr (HasNaN<R>::value)
+        return result * (nan / nan);
+      else
+        return result;
+    }
+
+  } // end namespace Impl
+
+  /** \brief A vector of a dynamic number of blocks of type B
+   *
+   * \tparam B the type of the blocks, e.g. FieldVector<double,3>, DynamicVector<double>
+   *           or another BlockVector
+   * \tparam A the allocator of the blocks
+   */
+  template<class B, class A = std::allocator<B> >
+  class BlockVector
+  {
+    std::vector<B,A> _data;
+
+    typedef Impl::IsFlatBlock<B> Flat;
+    typedef typename Flat::scalar_type scalar_type;
+
+  public:
+    //===== type definitions and constants
+
+    //! export the type representing the field
+    typedef typename FieldTraits<B>::field_type field_type;
+
+    //! export the type representing the real type of the field
+    typedef typename FieldTraits<B>::real_type real_type;
+
+    //! export the type representing the components
+    typedef B block_type;
+
+    //! export the type representing the components
+    typedef B value_type;
+
+    //! export the allocator type
+    typedef A allocator_type;
+
+    //! The type used for the index access and size operation
+    typedef typename std::vector<B,A>::size_type size_type;
+
+    //! Iterator over the blocks
+    typedef typename std::vector<B,A>::iterator iterator;
+
+    //! ConstIterator over the blocks
+    typedef typename std::vector<B,A>::const_iterator const_iterator;
+
+    //! The number of block levels we contain
+    enum {
+      //! The number of block levels we contain
+      blocklevel = Impl::BlockLevel<B>::value + 1
+    };
+
+    //===== constructors
+
+    //! Constructor making an empty vector
+    explicit BlockVector (const allocator_type& a = allocator_type())
+      : _data(a)
+    {}
+
+    //! Constructor making a vector of n value-initialized blocks
+    explicit BlockVector (size_type n, const allocator_type& a = allocator_type())
+      : _data(n, a)
+    {}
+
+    //! Constructor making a vector of n copies of the block b
+    BlockVector (size_type n, const B& b, const allocator_type& a = allocator_type())
+      : _data(n, b, a)
+    {}
+
+    //! Construct from a std::initializer_list of blocks
+    BlockVector (std::initializer_list<B> const& l)
+      : _data(l)
+    {}
+
+    //===== assignment from scalar
+
+    //! Assignment of a scalar to all entries
+    BlockVector& operator= (const field_type& k)
+    {
+      if constexpr (Flat::value)
+        std::fill_n(flat(), flatSize(), scalar_type(k));
+      else
+        for (auto& b : _data)
+          b = k;
+      return *this;
+    }
+
+    //===== access to the blocks
+
+    //! random access to the blocks
+    B& operator[] (size_type i)
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _data[i];
+    }
+
+    //! random access to the blocks
+    const B& operator[] (size_type i) const
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _data[i];
+    }
+
+    //! begin iterator
+    iterator begin () { return _data.begin(); }
+
+    //! end iterator
+    iterator end () { return _data.end(); }
+
+    //! begin ConstIterator
+    const_iterator begin () const { return _data.begin(); }
+
+    //! end ConstIterator
+    const_iterator end () const { return _data.end(); }
+
+    //! return pointer to the array of blocks
+    B* data () noexcept { return _data.data(); }
+
+    //! return pointer to the array of blocks
+    const B* data () const noexcept { return _data.data(); }
+
+    //===== sizes
+
+    //! number of blocks in the vector
+    size_type size () const { return _data.size(); }
+
+    //! number of blocks in the vector
+    size_type N () const { return _data.size(); }
+
+    //! dimension of the vector space, i.e., the number of scalar entries
+    size_type dim () const
+    {
+      if constexpr (Flat::value)
+        return flatSize();
+      else if constexpr (IsNumber<B>::value)
+        return size();
+      else {
+        size_type d = 0;
+        for (const auto& b : _data)
+          d += b.dim();
+        return d;
+      }
+    }
+
+    //! change the number of blocks, new blocks are value-initialized
+    void resize (size_type n) { _data.resize(n); }
+
+    //! reserve memory for n blocks
+    void reserve (size_type n) { _data.reserve(n); }
+
+    //! number of blocks for which memory has been allocated
+    size_type capacity () const { return _data.capacity(); }
+
+    //! the allocator used for the storage
+    allocator_type get_allocator () const { return _data.get_allocator(); }
+
+    //===== vector space arithmetic
+
+    //! vector space addition
+    template<class B2, class A2>
+    BlockVector& operator+= (const BlockVector<B2,A2>& x)
+    {
+      DUNE_ASSERT_BOUNDS(x.size() == size());
+      if constexpr (isFlatWith<B2>())
+        flatFor([&, y = x.flat()] (auto* z, std::size_t m) { z[m] += y[m]; });
+      else
+        for (size_type i = 0; i < size(); ++i)
+          _data[i] += x[i];
+      return *this;
+    }
+
+    //! vector space subtraction
+    template<class B2, class A2>
+    BlockVector& operator-= (const BlockVector<B2,A2>& x)
+    {
+      DUNE_ASSERT_BOUNDS(x.size() == size());
+      if constexpr (isFlatWith<B2>())
+        flatFor([&, y = x.flat()] (auto* z, std::size_t m) { z[m] -= y[m]; });
+      else
+        for (size_type i = 0; i < size(); ++i)
+          _data[i] -= x[i];
+      return *this;
+    }
+
+    //! vector space multiplication with scalar
+    BlockVector& operator*= (const field_type& k)
+    {
+      if constexpr (Flat::value)
+        flatFor([k = scalar_type(k)] (auto* z, std::size_t m) { z[m] *= k; });
+      else
+        for (auto& b : _data)
+          b *= k;
+      return *this;
+    }
+
+    //! vector space division by scalar
+    BlockVector& operator/= (const field_type& k)
+    {
+      if constexpr (Flat::value)
+        flatFor([k = scalar_type(k)] (auto* z, std::size_t m) { z[m] /= k; });
+      else
+        for (auto& b : _data)
+          b /= k;
+      return *this;
+    }
+
+    //! vector space axpy operation ( *this += a x )
+    template<class B2, class A2>
+    BlockVector& axpy (const field_type& a, const BlockVector<B2,A2>& x)
+    {
+      DUNE_ASSERT_BOUNDS(x.size() == size());
+      if constexpr (isFlatWith<B2>())
+        flatFor([&, a = scalar_type(a), y = x.flat()] (auto* z, std::size_t m) { z[m] += a*y[m]; });
+      else
+        for (size_type i = 0; i < size(); ++i)
+          if constexpr (IsNumber<B>::value)
+            _data[i] += a * x[i];
+          else
+            _data[i].axpy(a, x[i]);
+      return *this;
+    }
+
+    //! Binary vector comparison, true if all blocks agree
+    template<class B2, class A2>
+    bool operator== (const BlockVector<B2,A2>& x) const
+    {
+      if (x.size() != size())
+        return false;
+      for (size_type i = 0; i < size(); ++i)
+        if (_data[i] != x[i])
+          return false;
+      return true;
+    }
+
+    //! Binary vector incomparison
+    template<class B2, class A2>
+    bool operator!= (const BlockVector<B2,A2>& x) const
+    {
+      return !operator==(x);
+    }
+
+    //===== scalar products
+
+    //! indefinite vector dot product x^T y, the sum of the products of the blocks
+    template<class B2, class A2>
+    auto operator* (const BlockVector<B2,A2>& x) const
+    {
+      typedef typename PromotionTraits<field_type, typename BlockVector<B2,A2>::field_type>::PromotedType PromotedType;
+      DUNE_ASSERT_BOUNDS(x.size() == size());
+      if constexpr (isFlatWith<B2>())
+        return Impl::flatSum<PromotedType>(flatSize(), [y = x.flat(), z = flat()] (std::size_t m) {
+            return PromotedType(z[m]*y[m]);
+          });
+      else {
+        PromotedType result(0);
+        for (size_type i = 0; i < size(); ++i)
+          result += _data[i] * x[i];
+        return result;
+      }
+    }
+
+    //! vector dot product x^H y, the sum of Dune::dot of the blocks
+    template<class B2, class A2>
+    auto dot (const BlockVector<B2,A2>& x) const
+    {
+      typedef typename PromotionTraits<field_type, typename BlockVector<B2,A2>::field_type>::PromotedType PromotedType;
+      DUNE_ASSERT_BOUNDS(x.size() == size());
+      if constexpr (isFlatWith<B2>())
+        return Impl::flatSum<PromotedType>(flatSize(), [y = x.flat(), z = flat()] (std::size_t m) {
+            return PromotedType(z[m]*y[m]);
+          });
+      else {
+        PromotedType result(0);
+        for (size_type i = 0; i < size(); ++i)
+          result += Dune::dot(_data[i], x[i]);
+        return result;
+      }
+    }
+
+    //===== norms
+
+    //! one norm (sum over absolute values of entries)
+    real_type one_norm () const
+    {
+      if constexpr (Flat::value)
+        return Impl::flatSum<real_type>(flatSize(), [z = flat()] (std::size_t m) {
+            using std::abs;
+            return real_type(abs(z[m]));
+          });
+      else {
+        real_type result(0);
+        for (const auto& b : _data)
+          result += Impl::blockOneNorm(b);
+        return result;
+      }
+    }
+
+    //! simplified one norm (uses Manhattan norm for complex values)
+    real_type one_norm_real () const
+    {
+      if constexpr (Flat::value)
+        return one_norm();
+      else {
+        real_type result(0);
+        for (const auto& b : _data)
+          result += Impl::blockOneNormReal(b);
+        return result;
+      }
+    }
+
+    //! two norm sqrt(sum over squared values of entries)
+    real_type two_norm () const
+    {
+      using std::sqrt;
+      return sqrt(two_norm2());
+    }
+
+    //! square of two norm (sum over squared values of entries), need for block recursion
+    real_type two_norm2 () const
+    {
+      if constexpr (Flat::value)
+        return Impl::flatSum<real_type>(flatSize(), [z = flat()] (std::size_t m) {
+            return real_type(z[m]*z[m]);
+          });
+      else {
+        real_type result(0);
+        for (const auto& b : _data)
+          result += Impl::blockTwoNorm2(b);
+        return result;
+      }
+    }
+
+    //! infinity norm (maximum of absolute values of entries)
+    real_type infinity_norm () const
+    {
+      if constexpr (Flat::value)
+        return Impl::flatMax<real_type>(flatSize(), [z = flat()] (std::size_t m) {
+            using std::abs;
+            return real_type(abs(z[m]));
+          });
+      else
+        return blockMax([] (const B& b) { return Impl::blockInfinityNorm(b); });
+    }
+
+    //! simplified infinity norm (uses Manhattan norm for complex values)
+    real_type infinity_norm_real () const
+    {
+      if constexpr (Flat::value)
+        return infinity_norm();
+      else
+        return blockMax([] (const B& b) { return Impl::blockInfinityNormReal(b); });
+    }
+
+  private:
+    template<class, class> friend class BlockVector;
+
+    // whether the kernels with a BlockVector of blocks B2 run over the flattened arrays
+    template<class B2>
+    static constexpr bool isFlatWith ()
+    {
+      return Flat::value && std::is_same<B, B2>::value;
+    }
+
+    // the entries of all blocks, one after another
+    scalar_type* flat ()
+    {
+      return reinterpret_cast<scalar_type*>(_data.data());
+    }
+
+    const scalar_type* flat () const
+    {
+      return reinterpret_cast<const scalar_type*>(_data.data());
+    }
+
+    size_type flatSize () const
+    {
+      return Flat::size * size();
+    }
+
+    // f(z, m) for all entries m of the flattened array z
+    template<class F>
+    void flatFor (F&& f)
+    {
+      scalar_type* z = flat();
+      const size_type n = flatSize();
+      for (size_type m = 0; m < n; ++m)
+        f(z, m);
+    }
+
+    // the maximum of the norms of the blocks, NaN if one of them is NaN
+    template<class Norm>
+    real_type blockMax (Norm&& norm) const
+    {
+      using std::max;
+      real_type result(0), isNaN(1);
+      for (const auto& b : _data) {
+        const real_type a = norm(b);
+        result = max(a, result);
+        isNaN += a;
+      }
+      if constexpr (HasNaN<real_type>::value)
+        return result * (isNaN / isNaN);
+      else
+        return result;
+    }
+  };
+
+  /** \brief Write a BlockVector to an output stream, one block per line
+   *  \relates BlockVector
+   */
+  template<class B, class A>
+  std::ostream& operator<< (std::ostream& s, const BlockVector<B,A>& v)
+  {
+    for (const auto& b : v)
+      s << b << std::endl;
+    return s;
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_BLOCKVECTOR_HH
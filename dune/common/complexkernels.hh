@@ -0,0 +1,187 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_COMPLEXKERNELS_HH
+#define DUNE_COMMON_COMPLEXKERNELS_HH
+
+/** \file
+ * \brief Kernels of DenseVector for complex entries on real and imaginary parts
+ *
+ * The arithmetic operators of std::complex handle infinities and NaNs as
+ * required by Annex G of C99, which puts a branch and a library call into
+ * every product, and std::abs of a complex number calls hypot.  Both
+ * prevent vectorization.  The kernels in this file split the entries into
+ * their real and imaginary parts and work on these with fused multiply-adds
+ * if the target has them.  Partial sums are kept in several interleaved
+ * lanes, each of which adds one term per entry, so that the loops are not
+ * bound by the latency of the additions and vectorize.
+ *
+ * The results differ from the plain loops only by rounding, except for
+ * products of infinite and NaN entries, where the results are NaN instead
+ * of the infinities recovered by Annex G.
+ *
+ * The absolute value used by one_norm() is selected by a tag from
+ * namespace ComplexAbs:
+ * \code
+ * auto n = x.one_norm<Dune::ComplexAbs::Fast>();
+ * \endcode
+ */
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  //! Tags selecting the computation of absolute values of complex numbers
+  namespace ComplexAbs {
+
+    //! |z| by std::abs, i.e., by hypot, which avoids intermediate overflow and underflow
+    struct Hypot {};
+
+    /** \brief |z| by sqrt(re^2 + im^2), which vectorizes
+     *
+     * The squares overflow for |z| above the square root of the largest
+     * floating point number and underflow below the square root of the
+     * smallest normal one.
+     */
+    struct Fast {};
+
+  } // end namespace ComplexAbs
+
+  //! Whether T is one of the tags in namespace ComplexAbs
+  template<class T>
+  struct IsComplexAbsMethod : std::false_type {};
+
+  template<>
+  struct IsComplexAbsMethod<ComplexAbs::Hypot> : std::true_type {};
+
+  template<>
+  struct IsComplexAbsMethod<ComplexAbs::Fast> : std::true_type {};
+
+  namespace Impl {
+
+    //! whether T is std::complex of a floating point type
+    template<class T>
+    struct IsComplexFloat : std::false_type {};
+
+    template<class K>
+    struct IsComplexFloat<std::complex<K> > : std::is_floating_point<K> {};
+
+    //! number of interleaved partial sums of the complex kernels
+    constexpr std::size_t complexLanes = 4;
+
+    //! a*b + c, fused if the target has a fast fused multiply-add
+    template<class K>
+    K mulAdd (const K& a, const K& b, const K& c)
+    {
+#if defined(FP_FAST_FMA) || defined(__FMA__)
+      using std::fma;
+      return fma(a, b, c);
+#else
+      return a*b + c;
+#endif
+    }
+
+    template<class K, std::size_t L>
+    K sumLanes (const K (&lanes)[L])
+    {
+      K result = lanes[0];
+      for (std::size_t l = 1; l < L; ++l)
+        result += lanes[l];
+      return result;
+    }
+
+    //! the dot product conj(x)*y of the first n entries
+    template<class K, class X, class Y>
+    std::complex<K> complexDot (const X& x, const Y& y, std::size_t n)
+    {
+      constexpr std::size_t L = complexLanes;
+      K re[L] = {}, im[L] = {};
+
+      auto accumulate = [&] (std::size_t i, std::size_t l) {
+        const K ar = x[i].real(), ai = x[i].imag();
+        const K br = y[i].real(), bi = y[i].imag();
+        re[l] += mulAdd(ar, br, ai*bi);
+        im[l] += mulAdd(ar, bi, -ai*br);
+      };
+
+      std::size_t i = 0;
+      for (; i + L <= n; i += L)
+        for (std::size_t l = 0; l < L; ++l)
+          accumulate(i+l, l);
+      for (std::size_t l = 0; i + l < n; ++l)
+        accumulate(i+l, l);
+
+      return std::complex<K>(sumLanes(re), sumLanes(im));
+    }
+
+    //! the sum of the squared absolute values of the first n entries
+    template<class K, class X>
+    K complexAbs2Sum (const X& x, std::size_t n)
+    {
+      constexpr std::size_t L = complexLanes;
+      K sum[L] = {};
+
+      auto accumulate = [&] (std::size_t i, std::size_t l) {
+        const K r = x[i].real(), c = x[i].imag();
+        sum[l] += mulAdd(r, r, c*c);
+      };
+
+      std::size_t i = 0;
+      for (; i + L <= n; i += L)
+        for (std::size_t l = 0; l < L; ++l)
+          accumulate(i+l, l);
+      for (std::size_t l = 0; i + l < n; ++l)
+        accumulate(i+l, l);
+
+      return sumLanes(sum);
+    }
+
+    //! the sum of the absolute values sqrt(re^2 + im^2) of the first n entries
+    template<class K, class X>
+    K complexAbsSum (const X& x, std::size_t n)
+    {
+      constexpr std::size_t L = complexLanes;
+      K sum[L] = {};
+
+      auto accumulate = [&] (std::size_t i, std::size_t l) {
+        using std::sqrt;
+        const K r = x[i].real(), c = x[i].imag();
+        sum[l] += sqrt(mulAdd(r, r, c*c));
+      };
+
+      std::size_t i = 0;
+      for (; i + L <= n; i += L)
+        for (std::size_t l = 0; l < L; ++l)
+          accumulate(i+l, l);
+      for (std::size_t l = 0; i + l < n; ++l)
+        accumulate(i+l, l);
+
+      return sumLanes(sum);
+    }
+
+    //! y += a*x on the first n entries
+    template<class K, class Y, class X>
+    void complexAxpy (Y& y, const std::complex<K>& a, const X& x, std::size_t n)
+    {
+      const K ar = a.real(), ai = a.imag();
+      for (std::size_t i = 0; i < n; ++i) {
+        const K xr = x[i].real(), xi = x[i].imag();
+        const K yr = y[i].real(), yi = y[i].imag();
+        y[i] = std::complex<K>(mulAdd(ar, xr, mulAdd(-ai, xi, yr)),
+                               mulAdd(ar, xi, mulAdd(ai, xr, yi)));
+      }
+    }
+
+  } // end namespace Impl
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_COMPLEXKERNELS_HH
@@ -0,0 +1,447 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_COMPONENTVIEW_HH
+#define DUNE_COMMON_COMPONENTVIEW_HH
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/blockvector.hh>
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densevector.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/iteratorfacades.hh>
+#include <dune/common/promotiontraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+   * \brief Views of one component of all blocks of an array of FieldVectors
+   *
+   * \code
+   * std::vector<Dune::FieldVector<double,3> > points = ...;
+   * auto x = Dune::component(points, 0);                  // all x coordinates
+   * auto [xmin, xmax] = std::minmax_element(x.begin(), x.end());
+   * Dune::component(points, 2) *= 0.5;                    // scale all z coordinates
+   * double length = Dune::component(points, 1).two_norm();
+   * \endcode
+   *
+   * The entries of a component lie STRIDE entries apart in memory.  The
+   * norms and dot products of the views are computed in
+   * Impl::flatLanes() interleaved partial sums, as are those of the flat
+   * BlockVectors, so that the strided loads are vectorized by gathers or
+   * shuffles, and differ from the sequential summation of DenseVector by
+   * rounding only.
+   */
+
+  /** \brief Random-access iterator over every STRIDE-th entry of an array
+   *
+   * The iterator points to the block containing the entry, so that also
+   * the end iterator of a component stays within the array.
+   *
+   * \tparam T      the type of the entries, const T for read-only access
+   * \tparam STRIDE the distance between consecutive entries
+   */
+  template<class T, int STRIDE>
+  class StridedIterator :
+    public RandomAccessIteratorFacade<StridedIterator<T,STRIDE>, T, T&, std::ptrdiff_t>
+  {
+    friend class StridedIterator<typename std::remove_const<T>::type, STRIDE>;
+    friend class StridedIterator<const typename std::remove_const<T>::type, STRIDE>;
+
+    typedef StridedIterator<typename std::remove_const<T>::type, STRIDE> MutableIterator;
+    typedef StridedIterator<const typename std::remove_const<T>::type, STRIDE> ConstIterator;
+
+  public:
+    /**
+     * @brief The type of the difference between two positions.
+     */
+    typedef std::ptrdiff_t DifferenceType;
+
+    StridedIterator ()
+      : block_(nullptr), component_(0)
+    {}
+
+    //! iterator to entry component of the block starting at block
+    StridedIterator (T* block, std::size_t component)
+      : block_(block), component_(component)
+    {}
+
+    StridedIterator (const MutableIterator& other)
+      : block_(other.block_), component_(other.component_)
+    {}
+
+    bool equals (const MutableIterator& other) const
+    {
+      return block_ == other.block_ && component_ == other.component_;
+    }
+
+    bool equals (const ConstIterator& other) const
+    {
+      return block_ == other.block_ && component_ == other.component_;
+    }
+
+    T& dereference () const
+    {
+      return block_[component_];
+    }
+
+    void increment ()
+    {
+      block_ += STRIDE;
+    }
+
+    void decrement ()
+    {
+      block_ -= STRIDE;
+    }
+
+    T& elementAt (DifferenceType n) const
+    {
+      return block_[n*STRIDE + component_];
+    }
+
+    void advance (DifferenceType n)
+    {
+      block_ += n*STRIDE;
+    }
+
+    DifferenceType distanceTo (const MutableIterator& other) const
+    {
+      assert(other.component_ == component_);
+      return (other.block_ - block_) / STRIDE;
+    }
+
+    DifferenceType distanceTo (const ConstIterator& other) const
+    {
+      assert(other.component_ == component_);
+      return (other.block_ - block_) / STRIDE;
+    }
+
+  private:
+    T* block_;
+    std::size_t component_;
+  };
+
+  template< class K, int STRIDE > class ComponentView;
+
+  template< class K, int STRIDE >
+  struct DenseMatVecTraits< ComponentView<K,STRIDE> >
+  {
+    typedef ComponentView<K,STRIDE> derived_type;
+    typedef K* container_type;
+    typedef K value_type;
+    typedef std::size_t size_type;
+  };
+
+  template< class K, int STRIDE >
+  struct FieldTraits< ComponentView<K,STRIDE> >
+  {
+    typedef typename FieldTraits<K>::field_type field_type;
+    typedef typename FieldTraits<K>::real_type real_type;
+  };
+
+  /** \brief A view of entry component of n consecutive blocks of STRIDE entries of type K
+   *
+   * The view implements the DenseVector interface.  Reading and writing its
+   * entries reads and writes the blocks, and assigning to the view copies
+   * entries into the blocks.  Copies of the view view the same blocks.
+   * Arithmetic producing a new vector, e.g. `x + y`, returns an owning
+   * DynamicVector<K>.  The iterators are StridedIterators, which are
+   * accepted by the standard algorithms.
+   *
+   * \tparam K      the type of the entries, const K for read-only views
+   * \tparam STRIDE the number of entries of a block
+   */
+  template< class K, int STRIDE >
+  class ComponentView :
+    public DenseVector< ComponentView<K,STRIDE> >
+  {
+    typedef DenseVector< ComponentView<K,STRIDE> > Base;
+    typedef typename std::remove_const<K>::type field_value_type;
+
+    // the norms of arithmetic entries are computed in interleaved partial sums
+    static constexpr bool flat = std::is_arithmetic<field_value_type>::value;
+
+  public:
+    typedef typename Base::size_type size_type;
+    typedef typename Base::value_type value_type;
+    typedef typename Base::field_type field_type;
+    typedef typename FieldTraits<K>::real_type real_type;
+
+    //! the owning vector type of the results of the arithmetic
+    typedef DynamicVector<field_value_type> vector_type;
+
+    //! Iterator class for sequential access
+    typedef StridedIterator<K,STRIDE> Iterator;
+    //! typedef for stl compliant access
+    typedef Iterator iterator;
+    //! ConstIterator class for sequential access
+    typedef StridedIterator<const K,STRIDE> ConstIterator;
+    //! typedef for stl compliant access
+    typedef ConstIterator const_iterator;
+
+    //! Constructor of an empty view
+    ComponentView () noexcept
+      : _blocks(nullptr), _size(0), _component(0)
+    {}
+
+    /** \brief Constructor viewing the entries blocks[component], blocks[component + STRIDE], ...
+     *
+     * \param blocks    the first entry of the first block
+     * \param n         the number of blocks
+     * \param component the viewed entry of each block
+     */
+    ComponentView (K* blocks, size_type n, size_type component) noexcept
+      : _blocks(blocks), _size(n), _component(component)
+    {
+      assert(component < STRIDE);
+    }
+
+    //! Constructor of a read-only view from a mutable one
+    template<class K1,
+             std::enable_if_t<!std::is_same<K1, K>::value && std::is_convertible<K1*, K*>::value, int> = 0>
+    ComponentView (const ComponentView<K1,STRIDE>& other) noexcept
+      : _blocks(other.blocks()), _size(other.size()), _component(other.component())
+    {}
+
+    //! Copy constructor, the copy views the same entries
+    ComponentView (const ComponentView&) = default;
+
+    //! copy the entries of other into the viewed entries
+    ComponentView& operator= (const ComponentView& other)
+    {
+      assert(other.size() == size());
+      // entries that are read later are not overwritten before, if the
+      // copy runs backwards when other lies in front of this view
+      if (std::less<const K*>()(other.entries(), entries()))
+        for (size_type i = size(); i-- > 0;)
+          (*this)[i] = other[i];
+      else
+        for (size_type i = 0; i < size(); ++i)
+          (*this)[i] = other[i];
+      return *this;
+    }
+
+    using Base::operator=;
+
+    //===== access to components
+
+    size_type size () const noexcept { return _size; }
+
+    K & operator[](size_type i)
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _blocks[i*STRIDE + _component];
+    }
+    const K & operator[](size_type i) const
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _blocks[i*STRIDE + _component];
+    }
+
+    //! return pointer to the first entry of the first block
+    K* blocks () const noexcept
+    {
+      return _blocks;
+    }
+
+    //! the viewed entry of each block
+    size_type component () const noexcept
+    {
+      return _component;
+    }
+
+    //===== iterators
+
+    Iterator begin () { return Iterator(_blocks, _component); }
+    Iterator end () { return Iterator(_blocks + _size*STRIDE, _component); }
+    ConstIterator begin () const { return ConstIterator(_blocks, _component); }
+    ConstIterator end () const { return ConstIterator(_blocks + _size*STRIDE, _component); }
+
+    //===== arithmetic with owning results
+
+    //! Binary vector addition
+    template <class Other>
+    vector_type operator+ (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z += b;
+      return z;
+    }
+
+    //! Binary vector subtraction
+    template <class Other>
+    vector_type operator- (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z -= b;
+      return z;
+    }
+
+    //! Vector negation
+    vector_type operator- () const
+    {
+      return -vector_type(*this);
+    }
+
+    //===== reductions
+
+    //! indefinite vector dot product \f$\left (x^T \cdot y \right)\f$
+    template<class K1, int STRIDE1>
+    auto operator* (const ComponentView<K1,STRIDE1>& x) const
+    {
+      typedef typename PromotionTraits<field_type, typename FieldTraits<K1>::field_type>::PromotedType PromotedType;
+      if constexpr (flat && std::is_arithmetic<std::remove_const_t<K1> >::value) {
+        assert(x.size() == size());
+        return Impl::flatSum<PromotedType>(size(), [y = x.blocks() + x.component(), z = entries()] (std::size_t i) {
+            return PromotedType(z[i*STRIDE]*y[i*STRIDE1]);
+          });
+      }
+      else
+        return Base::operator*(x);
+    }
+
+    //! vector dot product \f$\left (x^H \cdot y \right)\f$
+    template<class K1, int STRIDE1>
+    auto dot (const ComponentView<K1,STRIDE1>& x) const
+    {
+      if constexpr (flat && std::is_arithmetic<std::remove_const_t<K1> >::value)
+        return *this * x;
+      else
+        return Base::dot(x);
+    }
+
+    using Base::operator*;
+    using Base::dot;
+    using Base::one_norm;
+    using Base::two_norm;
+    using Base::two_norm2;
+
+    //! one norm (sum over absolute values of entries)
+    real_type one_norm () const
+    {
+      using std::abs;
+      if constexpr (flat)
+        return Impl::flatSum<real_type>(size(), [z = entries()] (std::size_t i) {
+            return real_type(abs(z[i*STRIDE]));
+          });
+      else
+        return Base::one_norm();
+    }
+
+    //! simplified one norm (uses Manhattan norm for complex values)
+    real_type one_norm_real () const
+    {
+      if constexpr (flat)
+        return one_norm();
+      else
+        return Base::one_norm_real();
+    }
+
+    //! square of two norm (sum over squared values of entries), need for block recursion
+    real_type two_norm2 () const
+    {
+      if constexpr (flat)
+        return Impl::flatSum<real_type>(size(), [z = entries()] (std::size_t i) {
+            return real_type(z[i*STRIDE]*z[i*STRIDE]);
+          });
+      else
+        return Base::two_norm2();
+    }
+
+    //! two norm sqrt(sum over squared values of entries)
+    real_type two_norm () const
+    {
+      using std::sqrt;
+      return sqrt(two_norm2());
+    }
+
+    //! infinity norm (maximum of absolute values of entries)
+    real_type infinity_norm () const
+    {
+      using std::abs;
+      if constexpr (flat)
+        return Impl::flatMax<real_type>(size(), [z = entries()] (std::size_t i) {
+            return real_type(abs(z[i*STRIDE]));
+          });
+      else
+        return Base::infinity_norm();
+    }
+
+    //! simplified infinity norm (uses Manhattan norm for complex values)
+    real_type infinity_norm_real () const
+    {
+      if constexpr (flat)
+        return infinity_norm();
+      else
+        return Base::infinity_norm_real();
+    }
+
+  private:
+    // the viewed entry of the first block, for the kernels
+    const K* entries () const
+    {
+      return _size > 0 ? _blocks + _component : _blocks;
+    }
+
+    K* _blocks;
+    size_type _size;
+    size_type _component;
+  };
+
+  /** \brief View of entry i of all blocks of v
+   *  \relates ComponentView
+   */
+  template<class K, int n, class A>
+  ComponentView<K,n> component (std::vector<FieldVector<K,n>,A>& v, std::size_t i)
+  {
+    static_assert(sizeof(FieldVector<K,n>) == n*sizeof(K), "blocks with padding have no component views");
+    return ComponentView<K,n>(reinterpret_cast<K*>(v.data()), v.size(), i);
+  }
+
+  /** \brief Read-only view of entry i of all blocks of v
+   *  \relates ComponentView
+   */
+  template<class K, int n, class A>
+  ComponentView<const K,n> component (const std::vector<FieldVector<K,n>,A>& v, std::size_t i)
+  {
+    static_assert(sizeof(FieldVector<K,n>) == n*sizeof(K), "blocks with padding have no component views");
+    return ComponentView<const K,n>(reinterpret_cast<const K*>(v.data()), v.size(), i);
+  }
+
+  /** \brief View of entry i of all blocks of v
+   *  \relates ComponentView
+   */
+  template<class K, int n, class A>
+  ComponentView<K,n> component (BlockVector<FieldVector<K,n>,A>& v, std::size_t i)
+  {
+    static_assert(sizeof(FieldVector<K,n>) == n*sizeof(K), "blocks with padding have no component views");
+    return ComponentView<K,n>(reinterpret_cast<K*>(v.data()), v.size(), i);
+  }
+
+  /** \brief Read-only view of entry i of all blocks of v
+   *  \relates ComponentView
+   */
+  template<class K, int n, class A>
+  ComponentView<const K,n> component (const BlockVector<FieldVector<K,n>,A>& v, std::size_t i)
+  {
+    static_assert(sizeof(FieldVector<K,n>) == n*sizeof(K), "blocks with padding have no component views");
+    return ComponentView<const K,n>(reinterpret_cast<const K*>(v.data()), v.size(), i);
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_COMPONENTVIEW_HH
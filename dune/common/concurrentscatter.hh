@@ -0,0 +1,334 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_CONCURRENTSCATTER_HH
+#define DUNE_COMMON_CONCURRENTSCATTER_HH
+
+/** \file
+ * \brief Scatter-add of element contributions into a shared global array
+ * by several threads
+ *
+ * parallelScatterAdd(strategy, global, n, indices, local) adds local(e)[k]
+ * to global[indices(e)[k]] for all elements e in [0,n) in parallel, e.g.
+ * \code
+ * std::vector<Dune::FieldVector<double,3> > r(numDofs);
+ * auto dofs = [&] (std::size_t e) { return mesh.dofs(e); };     // std::array<int,4>
+ * auto residual = [&] (std::size_t e) { return localResidual(e); }; // FieldVector<FieldVector<double,3>,4>
+ * Dune::ElementColoring coloring(numElements, r.size(), dofs);   // once per mesh
+ * Dune::parallelScatterAdd(coloring, r, numElements, dofs, residual);
+ * \endcode
+ * Elements sharing an index write to the same block, which the strategies
+ * resolve differently:
+ *  - ConcurrentScatter::Atomic adds every entry by an atomic
+ *    compare-and-swap loop.  It needs no memory and no setup, and wins if
+ *    the contributions are few compared to the global array, or the
+ *    conflicts are rare.
+ *  - ConcurrentScatter::PrivateBuffers lets every thread add into a private
+ *    copy of the global array, which are summed up in parallel afterwards.
+ *    The adds are plain, but the memory and the final reduction grow with
+ *    the number of threads times the global size; it wins if every block
+ *    receives many contributions.
+ *  - An ElementColoring groups the elements into colors of elements without
+ *    common indices, which are processed one after the other, each in
+ *    parallel with plain adds.  The coloring is computed once, and wins if
+ *    it is reused for many assemblies.
+ *
+ * The order of the additions depends on the scheduling of the threads, so
+ * floating point results may differ between runs by rounding.
+ */
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densevector.hh>
+#include <dune/common/gatherscatter.hh>
+#include <dune/common/parallelfor.hh>
+#include <dune/common/unused.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  //! Tags selecting the strategy of parallelScatterAdd(), see also ElementColoring
+  namespace ConcurrentScatter {
+
+    //! Add the entries by atomic compare-and-swap loops
+    struct Atomic {};
+
+    //! Add into a private copy of the global array per thread, and sum them up at the end
+    struct PrivateBuffers {};
+
+  } // end namespace ConcurrentScatter
+
+  /** \brief x += a as an atomic operation, for arithmetic, complex and DenseVector types
+   *
+   * Floating point numbers are added by a compare-and-swap loop, integers
+   * by an atomic fetch-and-add, and complex numbers and vectors entry by
+   * entry.  The operations are relaxed: they order nothing but the
+   * updates of x, which are visible to other threads after the parallel
+   * algorithm has finished.
+   */
+  template<class K, std::enable_if_t<std::is_arithmetic<K>::value, int> = 0>
+  void atomicAdd (K& x, const K& a)
+  {
+    if constexpr (std::is_integral<K>::value)
+      __atomic_fetch_add(&x, a, __ATOMIC_RELAXED);
+    else {
+      K expected, desired;
+      __atomic_load(&x, &expected, __ATOMIC_RELAXED);
+      do
+        desired = expected + a;
+      while (!__atomic_compare_exchange(&x, &expected, &desired, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+  }
+
+  template<class K>
+  void atomicAdd (std::complex<K>& x, const std::complex<K>& a)
+  {
+    K* parts = reinterpret_cast<K*>(&x);
+    atomicAdd(parts[0], a.real());
+    atomicAdd(parts[1], a.imag());
+  }
+
+  template<class V, class W>
+  void atomicAdd (DenseVector<V>& x, const DenseVector<W>& a)
+  {
+    DUNE_ASSERT_BOUNDS(x.size() == a.size());
+    for (std::size_t i = 0; i < x.size(); ++i)
+      atomicAdd(x[i], a[i]);
+  }
+
+  /** \brief global[indices[k]] += local[k] for all k, as atomic operations
+   *
+   * \see scatterAdd()
+   */
+  template<class Global, class Indices, class Local>
+  void atomicScatterAdd (Global& global, const Indices& indices, const Local& local)
+  {
+    auto* blocks = std::data(global);
+    const auto* index = std::data(indices);
+    const auto* values = std::data(local);
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= std::size(local));
+    for (std::size_t k = 0; k < std::size(indices); ++k) {
+      DUNE_ASSERT_BOUNDS(std::size_t(index[k]) < std::size(global));
+      atomicAdd(blocks[index[k]], values[k]);
+    }
+  }
+
+  /** \brief A private copy of a global array of blocks B per thread
+   *
+   * scatterAdd() adds into the copy of the calling thread, which is
+   * allocated and zeroed by that thread on its first use, and reduceInto()
+   * adds all copies to the global array and zeroes them again, so the
+   * buffers can be reused for the next assembly.
+   */
+  template<class B, class A = std::allocator<B> >
+  class ScatterBuffers
+  {
+  public:
+    /** \brief Buffers for a global array of size blocks
+     *
+     * \param threads the number of threads, all parallelThreadIndex() must be smaller
+     */
+    explicit ScatterBuffers (std::size_t size, std::size_t threads = parallelConcurrency())
+      : size_(size), buffers_(threads)
+    {}
+
+    //! the number of blocks of the global array
+    std::size_t size () const
+    {
+      return size_;
+    }
+
+    //! buffer[indices[k]] += local[k] for all k, for the buffer of the calling thread
+    template<class Indices, class Local>
+    void scatterAdd (const Indices& indices, const Local& local)
+    {
+      const std::size_t t = parallelThreadIndex();
+      DUNE_ASSERT_BOUNDS(t < buffers_.size());
+      if (!buffers_[t])
+        buffers_[t] = std::make_unique<std::vector<B,A> >(size_, B(0));
+      Dune::scatterAdd(*buffers_[t], indices, local);
+    }
+
+    /** \brief global[i] += the sum of all buffers at i, then zero the buffers
+     *
+     * The blocks are processed in parallel, and the buffers are added in
+     * the order of the thread indices.
+     */
+    template<class Global>
+    void reduceInto (Global& global, const ParallelOptions& options = {})
+    {
+      DUNE_ASSERT_BOUNDS(std::size(global) == size_);
+      std::vector<B*> used;
+      for (auto& buffer : buffers_)
+        if (buffer)
+          used.push_back(buffer->data());
+      if (used.empty())
+        return;
+
+      auto* blocks = std::data(global);
+      parallelForChunks(std::size_t(0), size_, [&] (std::size_t first, std::size_t last) {
+          for (B* buffer : used)
+            for (std::size_t i = first; i < last; ++i) {
+              blocks[i] += buffer[i];
+              buffer[i] = B(0);
+            }
+        }, options);
+    }
+
+  private:
+    std::size_t size_;
+    std::vector<std::unique_ptr<std::vector<B,A> > > buffers_;
+  };
+
+  /** \brief A partition of elements into colors, such that no two elements of a color share an index
+   *
+   * The elements are colored greedily in their order, every element gets
+   * the smallest color not used by an element sharing an index with it.
+   * The used colors are tracked by a bit mask per index for 64 colors at
+   * a time; elements finding all of them used are colored in another pass
+   * with the next 64 colors.  Within a color the elements are sorted.
+   */
+  class ElementColoring
+  {
+  public:
+    /** \brief Color the elements [0,n)
+     *
+     * \param n       the number of elements
+     * \param size    the number of indices, all indices are smaller
+     * \param indices indices(e) is the contiguous range of indices of element e
+     */
+    template<class Indices>
+    ElementColoring (std::size_t n, std::size_t size, Indices indices)
+    {
+      std::vector<std::size_t> color(n);
+      std::vector<std::size_t> pending(n), next;
+      for (std::size_t e = 0; e < n; ++e)
+        pending[e] = e;
+
+      std::vector<std::uint64_t> used(size);
+      std::size_t colors = 0;
+      while (!pending.empty()) {
+        std::fill(used.begin(), used.end(), 0);
+        next.clear();
+        std::size_t passColors = 0;
+        for (std::size_t e : pending) {
+          const auto& ie = indices(e);
+          std::uint64_t mask = 0;
+          for (std::size_t k = 0; k < std::size(ie); ++k) {
+            DUNE_ASSERT_BOUNDS(std::size_t(std::data(ie)[k]) < size);
+            mask |= used[std::data(ie)[k]];
+          }
+          if (~mask == 0) {
+            next.push_back(e);
+            continue;
+          }
+          const std::size_t c = __builtin_ctzll(~mask);
+          for (std::size_t k = 0; k < std::size(ie); ++k)
+            used[std::data(ie)[k]] |= std::uint64_t(1) << c;
+          color[e] = colors + c;
+          passColors = std::max(passColors, c+1);
+        }
+        colors += passColors;
+        pending.swap(next);
+      }
+
+      // sort the elements by color, keeping their order within a color
+      offsets_.assign(colors + 1, 0);
+      for (std::size_t e = 0; e < n; ++e)
+        ++offsets_[color[e] + 1];
+      std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+      elements_.resize(n);
+      std::vector<std::size_t> position(offsets_.begin(), offsets_.end() - 1);
+      for (std::size_t e = 0; e < n; ++e)
+        elements_[position[color[e]]++] = e;
+    }
+
+    //! the number of colors
+    std::size_t colors () const
+    {
+      return offsets_.size() - 1;
+    }
+
+    //! the first of the sorted elements of color c
+    const std::size_t* colorBegin (std::size_t c) const
+    {
+      return elements_.data() + offsets_[c];
+    }
+
+    //! behind the last of the sorted elements of color c
+    const std::size_t* colorEnd (std::size_t c) const
+    {
+      return elements_.data() + offsets_[c+1];
+    }
+
+  private:
+    std::vector<std::size_t> offsets_;
+    std::vector<std::size_t> elements_;
+  };
+
+  /** \brief global[indices(e)[k]] += local(e)[k] for all elements e in [0,n), by atomic adds
+   *
+   * \param global  contiguous range of blocks
+   * \param indices indices(e) is the contiguous range of indices of element e
+   * \param local   local(e) is the contiguous range of blocks of element e
+   */
+  template<class Global, class Indices, class Local>
+  void parallelScatterAdd (ConcurrentScatter::Atomic, Global& global, std::size_t n,
+                           Indices indices, Local local, const ParallelOptions& options = {})
+  {
+    parallelFor(std::size_t(0), n, [&] (std::size_t e) {
+        atomicScatterAdd(global, indices(e), local(e));
+      }, options);
+  }
+
+  /** \brief global[indices(e)[k]] += local(e)[k] for all elements e in [0,n), by private buffers
+   *
+   * The buffers are allocated for this call; ScatterBuffers can be used
+   * directly to keep them for several assemblies.
+   */
+  template<class Global, class Indices, class Local>
+  void parallelScatterAdd (ConcurrentScatter::PrivateBuffers, Global& global, std::size_t n,
+                           Indices indices, Local local, const ParallelOptions& options = {})
+  {
+    typedef std::remove_pointer_t<decltype(std::data(global))> B;
+    ScatterBuffers<B> buffers(std::size(global));
+    parallelFor(std::size_t(0), n, [&] (std::size_t e) {
+        buffers.scatterAdd(indices(e), local(e));
+      }, options);
+    buffers.reduceInto(global, options);
+  }
+
+  /** \brief global[indices(e)[k]] += local(e)[k] for all elements e in [0,n), color by color
+   *
+   * \param coloring a coloring of the elements [0,n) by their indices
+   */
+  template<class Global, class Indices, class Local>
+  void parallelScatterAdd (const ElementColoring& coloring, Global& global, std::size_t n,
+                           Indices indices, Local local, const ParallelOptions& options = {})
+  {
+    DUNE_UNUSED_PARAMETER(n);
+    DUNE_ASSERT_BOUNDS(coloring.colors() == 0 || std::size_t(coloring.colorEnd(coloring.colors()-1)
+                                                             - coloring.colorBegin(0)) == n);
+    for (std::size_t c = 0; c < coloring.colors(); ++c)
+      parallelFor(coloring.colorBegin(c), coloring.colorEnd(c), [&] (std::size_t e) {
+          Dune::scatterAdd(global, indices(e), local(e));
+        }, options);
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_CONCURRENTSCATTER_HH
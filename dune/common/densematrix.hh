@@ -0,0 +1,857 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_DENSEMATRIX_HH
+#define DUNE_DENSEMATRIX_HH
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densevector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/math.hh>
+#include <dune/common/matvectraits.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/unused.hh>
+
+namespace Dune {
+
+  template<typename M> class DenseMatrix;
+
+  template<typename M>
+  struct FieldTraits< DenseMatrix<M> >
+  {
+    typedef typename FieldTraits< typename DenseMatVecTraits<M>::value_type >::field_type field_type;
+    typedef typename FieldTraits< typename DenseMatVecTraits<M>::value_type >::real_type real_type;
+  };
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+   * \brief Implements the dense matrix interface, with an exchangeable storage class
+   *
+   * The products with vectors and matrices are computed by kernels whose
+   * loops are unrolled completely for small static sizes, like those of
+   * FieldMatrix.  The products A^T x and A B accumulate the result vector
+   * or the current row of the result in a local array, which the compiler
+   * keeps in registers, and update it with whole rows of A or B, which
+   * vectorizes.
+   *
+   * The kernels add the products of each result entry in the order of the
+   * index, like the plain loops do.  The results are therefore identical
+   * to those of the plain loops and do not depend on the blocking.
+   */
+
+  // complete unrolling of the loops of the kernels below for small static sizes
+#if defined(__GNUC__)
+#define DUNE_DENSEMATRIX_UNROLL _Pragma("GCC unroll 16")
+#else
+#define DUNE_DENSEMATRIX_UNROLL
+#endif
+
+  /** \brief Error thrown if operations of a DenseMatrix fail, e.g., for singular matrices */
+  class FMatrixError : public MathError {};
+
+  namespace Impl {
+
+    /** \brief The numbers of rows and columns of matrices of type M, if known at compile time, 0 otherwise
+     *
+     * Matrix implementations with sizes fixed at compile time specialize
+     * this trait.  The kernels of DenseMatrix are unrolled for them.
+     */
+    template<class M>
+    struct DenseMatrixStaticSize
+    {
+      static constexpr std::size_t rows = 0;
+      static constexpr std::size_t cols = 0;
+    };
+
+    /** \brief Compute t_i = sum_j A[i][j] x[j] for all rows i and call store(i, t_i)
+     *
+     * \tparam T     the type of the sums t_i
+     * \tparam COLS  the static number of columns, or 0
+     */
+    template<class T, std::size_t COLS, class M, class X, class Store>
+    void matrixRowProducts (const M& A, const X& x, std::size_t rows, std::size_t cols, Store&& store)
+    {
+      const std::size_t m = (COLS > 0) ? COLS : cols;
+      for (std::size_t i = 0; i < rows; ++i) {
+        T t(0);
+        DUNE_DENSEMATRIX_UNROLL
+        for (std::size_t j = 0; j < m; ++j)
+          t += A[i][j] * x[j];
+        store(i, t);
+      }
+    }
+
+    /** \brief Compute y[j] += entry(A[i][j]) * coeff(i) for all rows i and columns j
+     *
+     * For a static number of columns, y is accumulated in a local copy,
+     * which is kept in registers while the rows of A are added.
+     */
+    template<std::size_t COLS, class M, class Y, class Coeff, class Entry>
+    void matrixColumnUpdates (const M& A, Y& y, std::size_t rows, std::size_t cols, Coeff&& coeff, Entry&& entry)
+    {
+      if constexpr (COLS > 0) {
+        std::array<std::decay_t<decltype(y[0])>, COLS> acc;
+        DUNE_DENSEMATRIX_UNROLL
+        for (std::size_t j = 0; j < COLS; ++j)
+          acc[j] = y[j];
+        DUNE_DENSEMATRIX_UNROLL
+        for (std::size_t i = 0; i < rows; ++i) {
+          const auto c = coeff(i);
+          DUNE_DENSEMATRIX_UNROLL
+          for (std::size_t j = 0; j < COLS; ++j)
+            acc[j] += entry(A[i][j]) * c;
+        }
+        DUNE_DENSEMATRIX_UNROLL
+        for (std::size_t j = 0; j < COLS; ++j)
+          y[j] = acc[j];
+      }
+      else
+        for (std::size_t i = 0; i < rows; ++i) {
+          const auto c = coeff(i);
+          for (std::size_t j = 0; j < cols; ++j)
+            y[j] += entry(A[i][j]) * c;
+        }
+    }
+
+    /** \brief Compute C = A B
+     *
+     * Each row of C is the sum of the rows of B scaled by the entries of a
+     * row of A.  For a static number of columns, the row of C is accumulated
+     * in a local array, which is kept in registers.  C must not be the same
+     * object as A or B.
+     */
+    template<std::size_t INNER, std::size_t COLS, class MA, class MB, class MC>
+    void matrixProduct (const MA& A, const MB& B, MC& C, std::size_t rows, std::size_t inner, std::size_t cols)
+    {
+      typedef std::decay_t<decltype(C[0][0])> T;
+      const std::size_t l = (INNER > 0) ? INNER : inner;
+      for (std::size_t i = 0; i < rows; ++i) {
+        if constexpr (COLS > 0) {
+          std::array<T, COLS> c;
+          c.fill(T(0));
+          DUNE_DENSEMATRIX_UNROLL
+          for (std::size_t k = 0; k < l; ++k) {
+            const auto a = A[i][k];
+            DUNE_DENSEMATRIX_UNROLL
+            for (std::size_t j = 0; j < COLS; ++j)
+              c[j] += a * B[k][j];
+          }
+          DUNE_DENSEMATRIX_UNROLL
+          for (std::size_t j = 0; j < COLS; ++j)
+            C[i][j] = c[j];
+        }
+        else {
+          for (std::size_t j = 0; j < cols; ++j)
+            C[i][j] = T(0);
+          for (std::size_t k = 0; k < l; ++k) {
+            const auto a = A[i][k];
+            for (std::size_t j = 0; j < cols; ++j)
+              C[i][j] += a * B[k][j];
+          }
+        }
+      }
+    }
+
+    //! determinant of a 2x2 matrix
+    template<class M>
+    auto determinant2 (const M& A)
+    {
+      return A[0][0]*A[1][1] - A[0][1]*A[1][0];
+    }
+
+    //! determinant of a 3x3 matrix, expanded along the first row
+    template<class M>
+    auto determinant3 (const M& A)
+    {
+      return A[0][0] * (A[1][1]*A[2][2] - A[1][2]*A[2][1])
+             - A[0][1] * (A[1][0]*A[2][2] - A[1][2]*A[2][0])
+             + A[0][2] * (A[1][0]*A[2][1] - A[1][1]*A[2][0]);
+    }
+
+    //! inverse of a 2x2 matrix by the adjugate, returns the determinant
+    template<class M, class Inverse>
+    auto invert2 (const M& A, Inverse& inverse)
+    {
+      const auto det = determinant2(A);
+      const auto detInv = decltype(det)(1) / det;
+      // A may be the same object as inverse
+      const auto i00 =  A[1][1] * detInv;
+      const auto i01 = -A[0][1] * detInv;
+      const auto i10 = -A[1][0] * detInv;
+      const auto i11 =  A[0][0] * detInv;
+      inverse[0][0] = i00;
+      inverse[0][1] = i01;
+      inverse[1][0] = i10;
+      inverse[1][1] = i11;
+      return det;
+    }
+
+    //! inverse of a 3x3 matrix by the adjugate, returns the determinant
+    template<class M, class Inverse>
+    auto invert3 (const M& A, Inverse& inverse)
+    {
+      // cofactors of the first column, reused for the determinant
+      const auto c00 = A[1][1]*A[2][2] - A[1][2]*A[2][1];
+      const auto c10 = A[1][2]*A[2][0] - A[1][0]*A[2][2];
+      const auto c20 = A[1][0]*A[2][1] - A[1][1]*A[2][0];
+      const auto det = A[0][0]*c00 + A[0][1]*c10 + A[0][2]*c20;
+      const auto detInv = decltype(det)(1) / det;
+
+      const auto i01 = (A[0][2]*A[2][1] - A[0][1]*A[2][2]) * detInv;
+      const auto i02 = (A[0][1]*A[1][2] - A[0][2]*A[1][1]) * detInv;
+      const auto i11 = (A[0][0]*A[2][2] - A[0][2]*A[2][0]) * detInv;
+      const auto i12 = (A[0][2]*A[1][0] - A[0][0]*A[1][2]) * detInv;
+      const auto i21 = (A[0][1]*A[2][0] - A[0][0]*A[2][1]) * detInv;
+      const auto i22 = (A[0][0]*A[1][1] - A[0][1]*A[1][0]) * detInv;
+
+      // A may be the same object as inverse
+      inverse[0][0] = c00 * detInv;
+      inverse[1][0] = c10 * detInv;
+      inverse[2][0] = c20 * detInv;
+      inverse[0][1] = i01;
+      inverse[0][2] = i02;
+      inverse[1][1] = i11;
+      inverse[1][2] = i12;
+      inverse[2][1] = i21;
+      inverse[2][2] = i22;
+      return det;
+    }
+
+  } // end namespace Impl
+
+  /** \brief A dense n x m matrix.
+
+     Matrices represent linear maps from a vector space V to a vector space W.
+     This class represents such a linear map by storing a two-dimensional
+     %array of numbers of a given field type K. The number of rows and
+     columns is given by the implementation class.
+
+     \tparam MAT the implementation class of the matrix, e.g., FieldMatrix
+   */
+  template<typename MAT>
+  class DenseMatrix
+  {
+    typedef DenseMatVecTraits<MAT> Traits;
+
+    // Curiously recurring template pattern
+    MAT & asImp() { return static_cast<MAT&>(*this); }
+    const MAT & asImp() const { return static_cast<const MAT&>(*this); }
+
+    typedef Impl::DenseMatrixStaticSize<MAT> StaticSize;
+
+  protected:
+    // construction allowed to derived classes only
+    constexpr DenseMatrix() = default;
+    // copying only allowed by derived classes
+    DenseMatrix(const DenseMatrix&) = default;
+    DenseMatrix& operator=(const DenseMatrix&) = default;
+
+  public:
+    //===== type definitions and constants
+
+    //! type of derived matrix class
+    typedef typename Traits::derived_type derived_type;
+
+    //! export the type representing the field
+    typedef typename Traits::value_type value_type;
+
+    //! export the type representing the field
+    typedef typename Traits::value_type field_type;
+
+    //! export the type representing the components
+    typedef typename Traits::value_type block_type;
+
+    //! The type used for the index access and size operation
+    typedef typename Traits::size_type size_type;
+
+    //! The type used to represent a row (must fulfill the Dune::DenseVector interface)
+    typedef typename Traits::row_type row_type;
+
+    //! The type used to represent a reference to a row (usually row_type &)
+    typedef typename Traits::row_reference row_reference;
+
+    //! The type used to represent a reference to a constant row (usually const row_type &)
+    typedef typename Traits::const_row_reference const_row_reference;
+
+    //! We are at the leaf of the block recursion
+    enum {
+      //! The number of block levels we contain. This is 1.
+      blocklevel = 1
+    };
+
+    //===== access to components
+
+    //! random access to the rows
+    row_reference operator[] ( size_type i )
+    {
+      return asImp()[i];
+    }
+
+    const_row_reference operator[] ( size_type i ) const
+    {
+      return asImp()[i];
+    }
+
+    //! size method (number of rows)
+    size_type size() const
+    {
+      return rows();
+    }
+
+    //===== iterator interface to rows of the matrix
+
+    //! Iterator class for sequential access
+    typedef DenseIterator<DenseMatrix,row_type,row_reference> Iterator;
+    //! typedef for stl compliant access
+    typedef Iterator iterator;
+    //! rename the iterators for easier access
+    typedef Iterator RowIterator;
+
+    //! begin iterator
+    Iterator begin ()
+    {
+      return Iterator(*this,0);
+    }
+
+    //! end iterator
+    Iterator end ()
+    {
+      return Iterator(*this,rows());
+    }
+
+    //! Iterator class for sequential access
+    typedef DenseIterator<const DenseMatrix,const row_type,const_row_reference> ConstIterator;
+    //! typedef for stl compliant access
+    typedef ConstIterator const_iterator;
+    //! rename the iterators for easier access
+    typedef ConstIterator ConstRowIterator;
+
+    //! begin iterator
+    ConstIterator begin () const
+    {
+      return ConstIterator(*this,0);
+    }
+
+    //! end iterator
+    ConstIterator end () const
+    {
+      return ConstIterator(*this,rows());
+    }
+
+    //===== assignment
+
+    //! Assignment of a scalar to all entries
+    derived_type& operator= (const value_type& k)
+    {
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] = k;
+      return asImp();
+    }
+
+    //! Assignment of a matrix of the same size
+    template<class Other>
+    derived_type& operator= (const DenseMatrix<Other>& other)
+    {
+      DUNE_ASSERT_BOUNDS(other.N() == N() && other.M() == M());
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] = other[i];
+      return asImp();
+    }
+
+    //===== vector space arithmetic
+
+    //! vector space addition
+    template <class Other>
+    derived_type &operator+= (const DenseMatrix<Other>& x)
+    {
+      DUNE_ASSERT_BOUNDS(rows() == x.rows());
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] += x[i];
+      return asImp();
+    }
+
+    //! vector space subtraction
+    template <class Other>
+    derived_type &operator-= (const DenseMatrix<Other>& x)
+    {
+      DUNE_ASSERT_BOUNDS(rows() == x.rows());
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] -= x[i];
+      return asImp();
+    }
+
+    //! vector space multiplication with scalar
+    derived_type &operator*= (const field_type& k)
+    {
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] *= k;
+      return asImp();
+    }
+
+    //! vector space division by scalar
+    derived_type &operator/= (const field_type& k)
+    {
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i] /= k;
+      return asImp();
+    }
+
+    //! vector space axpy operation (*this += a x)
+    template <class Other>
+    derived_type &axpy (const field_type &a, const DenseMatrix<Other> &x)
+    {
+      DUNE_ASSERT_BOUNDS(rows() == x.rows());
+      for (size_type i = 0; i < rows(); ++i)
+        (*this)[i].axpy(a, x[i]);
+      return asImp();
+    }
+
+    //! Binary matrix comparison
+    template <class Other>
+    bool operator== (const DenseMatrix<Other>& x) const
+    {
+      for (size_type i = 0; i < rows(); ++i)
+        if ((*this)[i] != x[i])
+          return false;
+      return true;
+    }
+
+    //! Binary matrix incomparison
+    template <class Other>
+    bool operator!= (const DenseMatrix<Other>& x) const
+    {
+      return !operator==(x);
+    }
+
+    //===== linear maps
+
+    //! y = A x
+    template<class X, class Y>
+    void mv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS((void*)(&x) != (void*)(&y));
+      DUNE_ASSERT_BOUNDS(x.N() == M());
+      DUNE_ASSERT_BOUNDS(y.N() == N());
+      rowProducts<Y>(x, [&](size_type i, const auto& t) { y[i] = t; });
+    }
+
+    //! y = A^T x
+    template< class X, class Y >
+    void mtv ( const X &x, Y &y ) const
+    {
+      DUNE_ASSERT_BOUNDS((void*)(&x) != (void*)(&y));
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      y = typename FieldTraits<Y>::field_type(0);
+      columnUpdates(y, [&](size_type i) { return x[i]; }, [](const value_type& a) -> const value_type& { return a; });
+    }
+
+    //! y += A x
+    template<class X, class Y>
+    void umv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == M());
+      DUNE_ASSERT_BOUNDS(y.N() == N());
+      rowProducts<Y>(x, [&](size_type i, const auto& t) { y[i] += t; });
+    }
+
+    //! y += A^T x
+    template<class X, class Y>
+    void umtv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return x[i]; }, [](const value_type& a) -> const value_type& { return a; });
+    }
+
+    //! y += A^H x
+    template<class X, class Y>
+    void umhv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return x[i]; }, [](const value_type& a) { return conjugateComplex(a); });
+    }
+
+    //! y -= A x
+    template<class X, class Y>
+    void mmv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == M());
+      DUNE_ASSERT_BOUNDS(y.N() == N());
+      rowProducts<Y>(x, [&](size_type i, const auto& t) { y[i] -= t; });
+    }
+
+    //! y -= A^T x
+    template<class X, class Y>
+    void mmtv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return -x[i]; }, [](const value_type& a) -> const value_type& { return a; });
+    }
+
+    //! y -= A^H x
+    template<class X, class Y>
+    void mmhv (const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return -x[i]; }, [](const value_type& a) { return conjugateComplex(a); });
+    }
+
+    //! y += alpha A x
+    template<class X, class Y>
+    void usmv (const typename FieldTraits<Y>::field_type & alpha,
+               const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == M());
+      DUNE_ASSERT_BOUNDS(y.N() == N());
+      rowProducts<Y>(x, [&](size_type i, const auto& t) { y[i] += alpha * t; });
+    }
+
+    //! y += alpha A^T x
+    template<class X, class Y>
+    void usmtv (const typename FieldTraits<Y>::field_type & alpha,
+                const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return alpha * x[i]; }, [](const value_type& a) -> const value_type& { return a; });
+    }
+
+    //! y += alpha A^H x
+    template<class X, class Y>
+    void usmhv (const typename FieldTraits<Y>::field_type & alpha,
+                const X& x, Y& y) const
+    {
+      DUNE_ASSERT_BOUNDS(x.N() == N());
+      DUNE_ASSERT_BOUNDS(y.N() == M());
+      columnUpdates(y, [&](size_type i) { return alpha * x[i]; }, [](const value_type& a) { return conjugateComplex(a); });
+    }
+
+    //===== norms
+
+    //! frobenius norm: sqrt(sum over squared values of entries)
+    typename FieldTraits<value_type>::real_type frobenius_norm () const
+    {
+      return fvmeta::sqrt(frobenius_norm2());
+    }
+
+    //! square of frobenius norm, need for block recursion
+    typename FieldTraits<value_type>::real_type frobenius_norm2 () const
+    {
+      typename FieldTraits<value_type>::real_type sum = 0;
+      for (size_type i = 0; i < rows(); ++i)
+        sum += (*this)[i].two_norm2();
+      return sum;
+    }
+
+    //! infinity norm (row sum norm, how to generalize for blocks?)
+    typename FieldTraits<value_type>::real_type infinity_norm () const
+    {
+      using std::max;
+      typename FieldTraits<value_type>::real_type norm = 0;
+      for (size_type i = 0; i < rows(); ++i)
+        norm = max(norm, (*this)[i].one_norm());
+      return norm;
+    }
+
+    //! simplified infinity norm (uses Manhattan norm for complex values)
+    typename FieldTraits<value_type>::real_type infinity_norm_real () const
+    {
+      using std::max;
+      typename FieldTraits<value_type>::real_type norm = 0;
+      for (size_type i = 0; i < rows(); ++i)
+        norm = max(norm, (*this)[i].one_norm_real());
+      return norm;
+    }
+
+    //===== solve
+
+    /** \brief Solve system A x = b
+     *
+     * Matrices of static size 1, 2 or 3 are solved by Cramer's rule, all
+     * others by an LU decomposition with partial pivoting.
+     *
+     * \exception FMatrixError if the matrix is singular
+     */
+    template <class V1, class V2>
+    void solve (V1& x, const V2& b) const
+    {
+      DUNE_ASSERT_BOUNDS(rows() == cols());
+      DUNE_ASSERT_BOUNDS(x.N() == rows() && b.N() == rows());
+      constexpr std::size_t n = StaticSize::rows;
+      if constexpr (n == 1) {
+        if ((*this)[0][0] == field_type(0))
+          DUNE_THROW(FMatrixError, "matrix is singular");
+        x[0] = b[0] / (*this)[0][0];
+      }
+      else if constexpr (n == 2 || n == 3) {
+        const auto& A = *this;
+        const field_type det = determinant();
+        if (det == field_type(0))
+          DUNE_THROW(FMatrixError, "matrix is singular");
+        const field_type detInv = field_type(1) / det;
+        if constexpr (n == 2) {
+          x[0] = detInv * (A[1][1]*b[0] - A[0][1]*b[1]);
+          x[1] = detInv * (A[0][0]*b[1] - A[1][0]*b[0]);
+        }
+        else {
+          // the determinants with b in place of column j
+          std::array<field_type, 3> y;
+          for (std::size_t j = 0; j < 3; ++j) {
+            derived_type Aj = asImp();
+            for (std::size_t i = 0; i < 3; ++i)
+              Aj[i][j] = b[i];
+            y[j] = detInv * Impl::determinant3(Aj);
+          }
+          for (std::size_t j = 0; j < 3; ++j)
+            x[j] = y[j];
+        }
+      }
+      else {
+        derived_type lu = asImp();
+        std::vector<size_type> pivot(rows());
+        lu.luDecomposition(pivot);
+        // forward substitution with the row permutation, then backward substitution
+        for (size_type i = 0; i < rows(); ++i)
+          x[i] = b[pivot[i]];
+        for (size_type i = 0; i < rows(); ++i)
+          for (size_type j = 0; j < i; ++j)
+            x[i] -= lu[i][j] * x[j];
+        for (size_type i = rows(); i-- > 0;) {
+          for (size_type j = i+1; j < rows(); ++j)
+            x[i] -= lu[i][j] * x[j];
+          x[i] /= lu[i][i];
+        }
+      }
+    }
+
+    /** \brief Compute inverse
+     *
+     * Matrices of static size 1, 2 or 3 are inverted by closed formulas,
+     * all others by an LU decomposition with partial pivoting, followed by
+     * forward and backward substitution for the columns of the identity.
+     *
+     * \exception FMatrixError if the matrix is singular
+     */
+    void invert ()
+    {
+      DUNE_ASSERT_BOUNDS(rows() == cols());
+      constexpr std::size_t n = StaticSize::rows;
+      if constexpr (n == 1) {
+        if ((*this)[0][0] == field_type(0))
+          DUNE_THROW(FMatrixError, "matrix is singular");
+        (*this)[0][0] = field_type(1) / (*this)[0][0];
+      }
+      else if constexpr (n == 2 || n == 3) {
+        if (determinant() == field_type(0))
+          DUNE_THROW(FMatrixError, "matrix is singular");
+        if constexpr (n == 2)
+          Impl::invert2(*this, *this);
+        else
+          Impl::invert3(*this, *this);
+      }
+      else {
+        derived_type lu = asImp();
+        std::vector<size_type> pivot(rows());
+        lu.luDecomposition(pivot);
+        // solve for the columns of the permuted identity
+        auto& inverse = *this;
+        for (size_type c = 0; c < rows(); ++c) {
+          for (size_type i = 0; i < rows(); ++i) {
+            field_type xi = (pivot[i] == c) ? field_type(1) : field_type(0);
+            for (size_type j = 0; j < i; ++j)
+              xi -= lu[i][j] * inverse[j][c];
+            inverse[i][c] = xi;
+          }
+          for (size_type i = rows(); i-- > 0;) {
+            field_type xi = inverse[i][c];
+            for (size_type j = i+1; j < rows(); ++j)
+              xi -= lu[i][j] * inverse[j][c];
+            inverse[i][c] = xi / lu[i][i];
+          }
+        }
+      }
+    }
+
+    /** \brief calculates the determinant of this matrix
+     *
+     * Matrices of static size 1, 2 or 3 use the closed formulas, all others
+     * an LU decomposition with partial pivoting.
+     */
+    field_type determinant () const
+    {
+      DUNE_ASSERT_BOUNDS(rows() == cols());
+      constexpr std::size_t n = StaticSize::rows;
+      if constexpr (n == 1)
+        return (*this)[0][0];
+      else if constexpr (n == 2)
+        return Impl::determinant2(*this);
+      else if constexpr (n == 3)
+        return Impl::determinant3(*this);
+      else {
+        derived_type lu = asImp();
+        std::vector<size_type> pivot(rows());
+        field_type det(1);
+        try {
+          det = lu.luDecomposition(pivot);
+        }
+        catch (const FMatrixError&) {
+          return field_type(0);
+        }
+        for (size_type i = 0; i < rows(); ++i)
+          det *= lu[i][i];
+        return det;
+      }
+    }
+
+    //! Multiplies M from the left to this matrix
+    template<typename M2>
+    MAT& leftmultiply (const DenseMatrix<M2>& M)
+    {
+      DUNE_ASSERT_BOUNDS(M.rows() == M.cols());
+      DUNE_ASSERT_BOUNDS(M.rows() == rows());
+      const derived_type C(asImp());
+      Impl::matrixProduct<StaticSize::rows, StaticSize::cols>(M, C, *this, rows(), rows(), cols());
+      return asImp();
+    }
+
+    //! Multiplies M from the right to this matrix
+    template<typename M2>
+    MAT& rightmultiply (const DenseMatrix<M2>& M)
+    {
+      DUNE_ASSERT_BOUNDS(M.rows() == M.cols());
+      DUNE_ASSERT_BOUNDS(M.cols() == cols());
+      const derived_type C(asImp());
+      Impl::matrixProduct<StaticSize::cols, StaticSize::cols>(C, M, *this, rows(), cols(), cols());
+      return asImp();
+    }
+
+    //===== sizes
+
+    //! number of rows
+    size_type N () const
+    {
+      return rows();
+    }
+
+    //! number of columns
+    size_type M () const
+    {
+      return cols();
+    }
+
+    //! number of rows
+    size_type rows() const
+    {
+      return asImp().mat_rows();
+    }
+
+    //! number of columns
+    size_type cols() const
+    {
+      return asImp().mat_cols();
+    }
+
+    //===== query
+
+    //! return true when (i,j) is in pattern
+    bool exists (size_type i, size_type j) const
+    {
+      DUNE_UNUSED_PARAMETER(i);
+      DUNE_UNUSED_PARAMETER(j);
+      DUNE_ASSERT_BOUNDS(i < rows());
+      DUNE_ASSERT_BOUNDS(j < cols());
+      return true;
+    }
+
+  protected:
+    /** \brief In-place LU decomposition with partial pivoting
+     *
+     * Afterwards the strict lower triangle holds L, whose diagonal is one,
+     * and the upper triangle holds U, such that L U is the matrix with rows
+     * pivot[0], pivot[1], ... of the original one.
+     *
+     * \returns the sign of the permutation
+     * \exception FMatrixError if the matrix is singular
+     */
+    field_type luDecomposition (std::vector<size_type>& pivot)
+    {
+      using std::abs;
+      auto& A = *this;
+      field_type sign(1);
+      for (size_type i = 0; i < rows(); ++i)
+        pivot[i] = i;
+      for (size_type k = 0; k < rows(); ++k) {
+        size_type p = k;
+        auto pivmax = abs(A[k][k]);
+        for (size_type i = k+1; i < rows(); ++i)
+          if (abs(A[i][k]) > pivmax) {
+            pivmax = abs(A[i][k]);
+            p = i;
+          }
+        if (pivmax == decltype(pivmax)(0))
+          DUNE_THROW(FMatrixError, "matrix is singular");
+        if (p != k) {
+          std::swap(A[p], A[k]);
+          std::swap(pivot[p], pivot[k]);
+          sign = -sign;
+        }
+        for (size_type i = k+1; i < rows(); ++i) {
+          const field_type factor = A[i][k] / A[k][k];
+          A[i][k] = factor;
+          for (size_type j = k+1; j < cols(); ++j)
+            A[i][j] -= factor * A[k][j];
+        }
+      }
+      return sign;
+    }
+
+  private:
+    // the products of the rows with x, passed to store(i, t_i)
+    template<class Y, class X, class Store>
+    void rowProducts (const X& x, Store&& store) const
+    {
+      typedef std::decay_t<decltype(std::declval<Y&>()[0])> T;
+      Impl::matrixRowProducts<T, StaticSize::cols>(*this, x, rows(), cols(), store);
+    }
+
+    // y[j] += entry(A[i][j]) * coeff(i)
+    template<class Y, class Coeff, class Entry>
+    void columnUpdates (Y& y, Coeff&& coeff, Entry&& entry) const
+    {
+      Impl::matrixColumnUpdates<StaticSize::cols>(*this, y, rows(), cols(), coeff, entry);
+    }
+  };
+
+  /** \brief Sends the matrix to an output stream
+   *  \relates DenseMatrix
+   */
+  template<typename MAT>
+  std::ostream& operator<< (std::ostream& s, const DenseMatrix<MAT>& a)
+  {
+    for (typename DenseMatrix<MAT>::size_type i=0; i<a.rows(); i++)
+      s << a[i] << std::endl;
+    return s;
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#undef DUNE_DENSEMATRIX_UNROLL
+
+#endif
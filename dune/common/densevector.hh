@@ -4,8 +4,10 @@
 #define DUNE_DENSEVECTOR_HH
 
 #include <algorithm>
+#include <cstddef>
 #include <limits>
 #include <type_traits>
+#include <utility>
 
 #include "genericiterator.hh"
 #include "ftraits.hh"
@@ -13,6 +15,8 @@
 #include "promotiontraits.hh"
 #include "dotproduct.hh"
 #include "boundschecking.hh"
+#include "summation.hh"
+#include "complexkernels.hh"
 
 namespace Dune {
 
@@ -117,8 +121,117 @@ namespace Dune {
       return Sqrt<K>::sqrt(k);
     }
 
+    /**
+       \private
+       \memberof Dune::DenseVector
+
+       Reduction of the result of an entry comparison to a single bool.  Entry
+       types with lane-wise comparisons, like LoopSIMD, provide an overload
+       found by argument-dependent lookup.
+     */
+    inline bool allTrue (bool b)
+    {
+      return b;
+    }
+
   }
 
+  namespace Impl {
+
+    /** \brief The number of entries of vectors of type V, if known at compile time, 0 otherwise
+     *
+     * Vector implementations with a size fixed at compile time specialize
+     * this trait.  The loops of DenseVector over such vectors are unrolled
+     * at compile time if they have at most maxUnrolledSize entries.
+     */
+    template<class V>
+    struct DenseVectorStaticSize
+      : public std::integral_constant<std::size_t, 0> {};
+
+    //! maximal static size for which the loops of DenseVector are unrolled
+    constexpr std::size_t maxUnrolledSize = 16;
+
+    template<class F, std::size_t... i>
+    void unrolledFor (std::index_sequence<i...>, F&& f)
+    {
+      (f(i), ...);
+    }
+
+    template<class F, std::size_t... i>
+    bool unrolledAll (std::index_sequence<i...>, F&& f)
+    {
+      return (f(i) && ...);
+    }
+
+    //! call f(i) for i = 0,...,n-1, unrolled if V has a small static size
+    template<class V, class Size, class F>
+    void denseFor (Size n, F&& f)
+    {
+      constexpr std::size_t N = DenseVectorStaticSize<V>::value;
+      if constexpr (N > 0 && N <= maxUnrolledSize)
+        unrolledFor(std::make_index_sequence<N>{}, f);
+      else
+        for (Size i = 0; i < n; ++i)
+          f(i);
+    }
+
+    //! whether f(i) holds for all i = 0,...,n-1, stops at the first i for which it does not
+    template<class V, class Size, class F>
+    bool denseAll (Size n, F&& f)
+    {
+      constexpr std::size_t N = DenseVectorStaticSize<V>::value;
+      if constexpr (N > 0 && N <= maxUnrolledSize)
+        return unrolledAll(std::make_index_sequence<N>{}, f);
+      else {
+        for (Size i = 0; i < n; ++i)
+          if (!f(i))
+            return false;
+        return true;
+      }
+    }
+
+    /** \brief Whether the entries of vectors V are vectors of arithmetic scalars that lie contiguously in memory
+     *
+     * Vector implementations with such a layout, e.g. nested FieldVectors,
+     * specialize this trait and export the scalar_type and the total number
+     * of scalars size, at most maxUnrolledSize.  The element-wise
+     * operations of DenseVector then run over the flattened scalars
+     * instead of recursing into the entries.
+     */
+    template<class V>
+    struct DenseVectorFlatStorage : public std::false_type {};
+
+    /** \brief z[k] = f(z[k]) for all flattened scalars of z
+     *
+     * All scalars are loaded before the first one is stored, so that the
+     * compiler may vectorize the unrolled loops without checking for aliasing.
+     */
+    template<class V, class F>
+    void flatTransform (V& z, F f)
+    {
+      typedef typename DenseVectorFlatStorage<V>::scalar_type K;
+      constexpr std::size_t N = DenseVectorFlatStorage<V>::size;
+      K* zp = reinterpret_cast<K*>(z.data());
+      K zs[N];
+      unrolledFor(std::make_index_sequence<N>{}, [&](std::size_t k) { zs[k] = zp[k]; });
+      unrolledFor(std::make_index_sequence<N>{}, [&](std::size_t k) { zp[k] = f(zs[k]); });
+    }
+
+    //! z[k] = f(z[k], x[k]) for all flattened scalars of z and x
+    template<class V, class F>
+    void flatTransform (V& z, const V& x, F f)
+    {
+      typedef typename DenseVectorFlatStorage<V>::scalar_type K;
+      constexpr std::size_t N = DenseVectorFlatStorage<V>::size;
+      K* zp = reinterpret_cast<K*>(z.data());
+      const K* xp = reinterpret_cast<const K*>(x.data());
+      K zs[N], xs[N];
+      unrolledFor(std::make_index_sequence<N>{}, [&](std::size_t k) { zs[k] = zp[k]; xs[k] = xp[k]; });
+      unrolledFor(std::make_index_sequence<N>{}, [&](std::size_t k) { zp[k] = f(zs[k], xs[k]); });
+    }
+
+  } // end namespace Impl
+
   /*! \brief Generic iterator class for dense vector and matrix implementations
 
      provides sequential access to DenseVector, FieldVector and FieldMatrix
@@ -232,6 +345,13 @@ namespace Dune {
     V & asImp() { return static_cast<V&>(*this); }
     const V & asImp() const { return static_cast<const V&>(*this); }
 
+    // whether the element-wise operations with a vector of type Other run over the flattened scalars
+    template<class Other>
+    static constexpr bool isFlatWith ()
+    {
+      return Impl::DenseVectorFlatStorage<V>::value && std::is_same<Other, V>::value;
+    }
+
   protected:
     // construction allowed to derived classes only
     constexpr DenseVector() = default;
@@ -266,8 +386,7 @@ namespace Dune {
     //! Assignment operator for scalar
     inline derived_type& operator= (const value_type& k)
     {
-      for (size_type i=0; i<size(); i++)
-        asImp()[i] = k;
+      Impl::denseFor<V>(size(), [&](size_type i) { asImp()[i] = k; });
       return asImp();
     }
 
@@ -276,6 +395,9 @@ namespace Dune {
     //! Assignment operator for other DenseVector of same type
     DenseVector& operator=(const DenseVector&) = default;
 
+    //! Move assignment operator for other DenseVector of same type
+    DenseVector& operator=(DenseVector&&) = default;
+
   public:
 
     //! Assignment operator for other DenseVector of different type
@@ -285,8 +407,7 @@ namespace Dune {
     derived_type& operator= (const DenseVector<W>& other)
     {
       assert(other.size() == size());
-      for (size_type i=0; i<size(); i++)
-        asImp()[i] = other[i];
+      Impl::denseFor<V>(size(), [&](size_type i) { asImp()[i] = other[i]; });
       return asImp();
     }
 
@@ -339,8 +460,9 @@ namespace Dune {
       return asImp().size();
     }
 
-    //! Iterator class for sequential access
-    typedef DenseIterator<DenseVector,value_type> Iterator;
+    //! Iterator class for sequential access, read-only for vectors of const entries
+    typedef DenseIterator<std::conditional_t<std::is_const<value_type>::value, const DenseVector, DenseVector>,
+                          value_type> Iterator;
     //! typedef for stl compliant access
     typedef Iterator iterator;
 
@@ -420,8 +542,10 @@ namespace Dune {
     derived_type& operator+= (const DenseVector<Other>& x)
     {
       DUNE_ASSERT_BOUNDS(x.size() == size());
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] += x[i];
+      if constexpr (isFlatWith<Other>())
+        Impl::flatTransform(asImp(), static_cast<const V&>(x), [](auto z, auto y) { return z + y; });
+      else
+        Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] += x[i]; });
       return asImp();
     }
 
@@ -430,39 +554,109 @@ namespace Dune {
     derived_type& operator-= (const DenseVector<Other>& x)
     {
       DUNE_ASSERT_BOUNDS(x.size() == size());
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] -= x[i];
+      if constexpr (isFlatWith<Other>())
+        Impl::flatTransform(asImp(), static_cast<const V&>(x), [](auto z, auto y) { return z - y; });
+      else
+        Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] -= x[i]; });
       return asImp();
     }
 
-    //! Binary vector addition
+    /** \brief Binary vector addition
+     *
+     * The overloads for temporaries compute the result in the storage of the
+     * temporary, so that no entries are copied.  This matters for entries
+     * owning memory, e.g. multiprecision numbers.
+     */
     template <class Other>
-    derived_type operator+ (const DenseVector<Other>& b) const
+    derived_type operator+ (const DenseVector<Other>& b) const &
     {
       derived_type z = asImp();
-      return (z+=b);
+      z += b;
+      return z;
+    }
+
+    //! Binary vector addition, reusing the storage of this temporary
+    template <class Other>
+    derived_type operator+ (const DenseVector<Other>& b) &&
+    {
+      asImp() += b;
+      return std::move(asImp());
+    }
+
+    //! Binary vector addition, reusing the storage of the temporary b
+    template <class Other,
+              std::enable_if_t<std::is_same<Other, derived_type>::value, int> = 0>
+    derived_type operator+ (Other&& b) const &
+    {
+      DUNE_ASSERT_BOUNDS(b.size() == size());
+      Impl::denseFor<V>(size(), [&](size_type i) { b[i] = (*this)[i] + std::move(b[i]); });
+      return std::move(b);
+    }
+
+    //! Binary vector addition, reusing the storage of this temporary
+    template <class Other,
+              std::enable_if_t<std::is_same<Other, derived_type>::value, int> = 0>
+    derived_type operator+ (Other&& b) &&
+    {
+      asImp() += b;
+      return std::move(asImp());
     }
 
     //! Binary vector subtraction
     template <class Other>
-    derived_type operator- (const DenseVector<Other>& b) const
+    derived_type operator- (const DenseVector<Other>& b) const &
     {
       derived_type z = asImp();
-      return (z-=b);
+      z -= b;
+      return z;
+    }
+
+    //! Binary vector subtraction, reusing the storage of this temporary
+    template <class Other>
+    derived_type operator- (const DenseVector<Other>& b) &&
+    {
+      asImp() -= b;
+      return std::move(asImp());
+    }
+
+    //! Binary vector subtraction, reusing the storage of the temporary b
+    template <class Other,
+              std::enable_if_t<std::is_same<Other, derived_type>::value, int> = 0>
+    derived_type operator- (Other&& b) const &
+    {
+      DUNE_ASSERT_BOUNDS(b.size() == size());
+      Impl::denseFor<V>(size(), [&](size_type i) { b[i] = (*this)[i] - std::move(b[i]); });
+      return std::move(b);
+    }
+
+    //! Binary vector subtraction, reusing the storage of this temporary
+    template <class Other,
+              std::enable_if_t<std::is_same<Other, derived_type>::value, int> = 0>
+    derived_type operator- (Other&& b) &&
+    {
+      asImp() -= b;
+      return std::move(asImp());
     }
 
     //! Vector negation
-    derived_type operator- () const
+    derived_type operator- () const &
     {
-      V result;
+      // copy first, so that vectors of dynamic size have the right size
+      V result = asImp();
       typedef typename decltype(result)::size_type size_type;
 
-      for (size_type i = 0; i < size(); ++i)
-        result[i] = -asImp()[i];
+      Impl::denseFor<V>(size(), [&](size_type i) { result[i] = -result[i]; });
 
       return result;
     }
 
+    //! Vector negation, reusing the storage of this temporary
+    derived_type operator- () &&
+    {
+      Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] = -std::move((*this)[i]); });
+      return std::move(asImp());
+    }
+
     //! \brief vector space add scalar to all comps
     /**
        we use enable_if to avoid an ambiguity, if the
@@ -480,8 +674,7 @@ namespace Dune {
     operator+= (const ValueType& kk)
     {
       const value_type& k = kk;
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] += k;
+      Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] += k; });
       return asImp();
     }
 
@@ -502,8 +695,7 @@ namespace Dune {
     operator-= (const ValueType& kk)
     {
       const value_type& k = kk;
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] -= k;
+      Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] -= k; });
       return asImp();
     }
 
@@ -524,8 +716,10 @@ namespace Dune {
     operator*= (const FieldType& kk)
     {
       const field_type& k = kk;
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] *= k;
+      if constexpr (isFlatWith<V>())
+        Impl::flatTransform(asImp(), [k = field_type(k)](auto z) { return z * k; });
+      else
+        Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] *= k; });
       return asImp();
     }
 
@@ -546,21 +740,22 @@ namespace Dune {
     operator/= (const FieldType& kk)
     {
       const field_type& k = kk;
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] /= k;
+      if constexpr (isFlatWith<V>())
+        Impl::flatTransform(asImp(), [k = field_type(k)](auto z) { return z / k; });
+      else
+        Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] /= k; });
       return asImp();
     }
 
-    //! Binary vector comparison
+    //! Binary vector comparison, true if all entries (and all their SIMD lanes) agree
     template <class Other>
     bool operator== (const DenseVector<Other>& x) const
     {
       DUNE_ASSERT_BOUNDS(x.size() == size());
-      for (size_type i=0; i<size(); i++)
-        if ((*this)[i]!=x[i])
-          return false;
-
-      return true;
+      return Impl::denseAll<V>(size(), [&](size_type i) {
+          using fvmeta::allTrue;
+          return allTrue(!((*this)[i]!=x[i]));
+        });
     }
 
     //! Binary vector incomparison
@@ -576,8 +771,14 @@ namespace Dune {
     derived_type& axpy (const field_type& a, const DenseVector<Other>& x)
     {
       DUNE_ASSERT_BOUNDS(x.size() == size());
-      for (size_type i=0; i<size(); i++)
-        (*this)[i] += a*x[i];
+      if constexpr (Impl::IsComplexFloat<value_type>::value
+                    && std::is_same<field_type, value_type>::value
+                    && std::is_same<typename DenseVector<Other>::value_type, value_type>::value)
+        Impl::complexAxpy(*this, a, x, size());
+      else if constexpr (isFlatWith<Other>())
+        Impl::flatTransform(asImp(), static_cast<const V&>(x), [a = field_type(a)](auto z, auto y) { return z + a*y; });
+      else
+        Impl::denseFor<V>(size(), [&](size_type i) { (*this)[i] += a*x[i]; });
       return asImp();
     }
 
@@ -593,9 +794,7 @@ namespace Dune {
       typedef typename PromotionTraits<field_type, typename DenseVector<Other>::field_type>::PromotedType PromotedType;
       PromotedType result(0);
       assert(x.size() == size());
-      for (size_type i=0; i<size(); i++) {
-        result += PromotedType((*this)[i]*x[i]);
-      }
+      Impl::denseFor<V>(size(), [&](size_type i) { result += PromotedType((*this)[i]*x[i]); });
       return result;
     }
 
@@ -606,15 +805,22 @@ namespace Dune {
      * @param x other vector
      * @return
      */
-    template<class Other>
+    template<class Method = Summation::Naive, class Other,
+             std::enable_if_t<IsSummationMethod<Method>::value, int> = 0>
     typename PromotionTraits<field_type,typename DenseVector<Other>::field_type>::PromotedType dot(const DenseVector<Other>& x) const {
       typedef typename PromotionTraits<field_type, typename DenseVector<Other>::field_type>::PromotedType PromotedType;
-      PromotedType result(0);
       assert(x.size() == size());
-      for (size_type i=0; i<size(); i++) {
-        result += Dune::dot((*this)[i],x[i]);
+      if constexpr (std::is_same<Method, Summation::Naive>::value
+                    && Impl::IsComplexFloat<value_type>::value
+                    && std::is_same<typename DenseVector<Other>::value_type, value_type>::value)
+        return Impl::complexDot<typename FieldTraits<value_type>::real_type>(*this, x, size());
+      else if constexpr (std::is_same<Method, Summation::Naive>::value) {
+        PromotedType result(0);
+        Impl::denseFor<V>(size(), [&](size_type i) { result += Dune::dot((*this)[i],x[i]); });
+        return result;
       }
-      return result;
+      else
+        return Impl::SummedDot<PromotedType, Method, DenseVector, DenseVector<Other> >::apply(*this, x);
     }
 
     //===== norms
@@ -623,37 +829,64 @@ namespace Dune {
     typename FieldTraits<value_type>::real_type one_norm() const {
       using std::abs;
       typename FieldTraits<value_type>::real_type result( 0 );
-      for (size_type i=0; i<size(); i++)
-        result += abs((*this)[i]);
+      Impl::denseFor<V>(size(), [&](size_type i) { result += abs((*this)[i]); });
       return result;
     }
 
+    //! one norm using a given absolute value of complex entries, see ComplexAbs
+    template<class Method,
+             std::enable_if_t<IsComplexAbsMethod<Method>::value, int> = 0>
+    typename FieldTraits<value_type>::real_type one_norm() const {
+      if constexpr (std::is_same<Method, ComplexAbs::Fast>::value && Impl::IsComplexFloat<value_type>::value)
+        return Impl::complexAbsSum<typename FieldTraits<value_type>::real_type>(*this, size());
+      else
+        return one_norm();
+    }
+
 
     //! simplified one norm (uses Manhattan norm for complex values)
     typename FieldTraits<value_type>::real_type one_norm_real () const
     {
       typename FieldTraits<value_type>::real_type result( 0 );
-      for (size_type i=0; i<size(); i++)
-        result += fvmeta::absreal((*this)[i]);
+      Impl::denseFor<V>(size(), [&](size_type i) { result += fvmeta::absreal((*this)[i]); });
       return result;
     }
 
     //! two norm sqrt(sum over squared values of entries)
     typename FieldTraits<value_type>::real_type two_norm () const
     {
-      typename FieldTraits<value_type>::real_type result( 0 );
-      for (size_type i=0; i<size(); i++)
-        result += fvmeta::abs2((*this)[i]);
-      return fvmeta::sqrt(result);
+      return fvmeta::sqrt(two_norm2());
+    }
+
+    //! two norm using a given summation method, see Summation
+    template<class Method,
+             std::enable_if_t<IsSummationMethod<Method>::value, int> = 0>
+    typename FieldTraits<value_type>::real_type two_norm () const
+    {
+      return fvmeta::sqrt(two_norm2<Method>());
     }
 
     //! square of two norm (sum over squared values of entries), need for block recursion
     typename FieldTraits<value_type>::real_type two_norm2 () const
     {
-      typename FieldTraits<value_type>::real_type result( 0 );
-      for (size_type i=0; i<size(); i++)
-        result += fvmeta::abs2((*this)[i]);
-      return result;
+      typedef typename FieldTraits<value_type>::real_type real_type;
+      if constexpr (Impl::IsComplexFloat<value_type>::value)
+        return Impl::complexAbs2Sum<real_type>(*this, size());
+      else {
+        real_type result( 0 );
+        Impl::denseFor<V>(size(), [&](size_type i) { result += fvmeta::abs2((*this)[i]); });
+        return result;
+      }
+    }
+
+    //! square of two norm using a given summation method, see Summation
+    template<class Method,
+             std::enable_if_t<IsSummationMethod<Method>::value, int> = 0>
+    typename FieldTraits<value_type>::real_type two_norm2 () const
+    {
+      typedef typename FieldTraits<value_type>::real_type real_type;
+      return Impl::SummedAbs2<real_type, Method, DenseVector>::apply(*this,
+        [] (const value_type& v) { return fvmeta::abs2(v); });
     }
 
     //! infinity norm (maximum of absolute values of entries)
@@ -665,10 +898,10 @@ namespace Dune {
       using std::max;
 
       real_type norm = 0;
-      for (auto const &x : *this) {
-        real_type const a = abs(x);
-        norm = max(a, norm);
-      }
+      Impl::denseFor<V>(size(), [&](size_type i) {
+          real_type const a = abs((*this)[i]);
+          norm = max(a, norm);
+        });
       return norm;
     }
 
@@ -680,10 +913,10 @@ namespace Dune {
       using std::max;
 
       real_type norm = 0;
-      for (auto const &x : *this) {
-        real_type const a = fvmeta::absreal(x);
-        norm = max(a, norm);
-      }
+      Impl::denseFor<V>(size(), [&](size_type i) {
+          real_type const a = fvmeta::absreal((*this)[i]);
+          norm = max(a, norm);
+        });
       return norm;
     }
 
@@ -697,11 +930,11 @@ namespace Dune {
 
       real_type norm = 0;
       real_type isNaN = 1;
-      for (auto const &x : *this) {
-        real_type const a = abs(x);
-        norm = max(a, norm);
-        isNaN += a;
-      }
+      Impl::denseFor<V>(size(), [&](size_type i) {
+          real_type const a = abs((*this)[i]);
+          norm = max(a, norm);
+          isNaN += a;
+        });
       return norm * (isNaN / isNaN);
     }
 
@@ -714,11 +947,11 @@ namespace Dune {
 
       real_type norm = 0;
       real_type isNaN = 1;
-      for (auto const &x : *this) {
-        real_type const a = fvmeta::absreal(x);
-        norm = max(a, norm);
-        isNaN += a;
-      }
+      Impl::denseFor<V>(size(), [&](size_type i) {
+          real_type const a = fvmeta::absreal((*this)[i]);
+          norm = max(a, norm);
+          isNaN += a;
+        });
       return norm * (isNaN / isNaN);
     }
 
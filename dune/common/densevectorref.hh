@@ -0,0 +1,253 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_DENSEVECTORREF_HH
+#define DUNE_COMMON_DENSEVECTORREF_HH
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densevector.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/ftraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+   * \brief A dense vector with a run-time size viewing memory owned by
+   * someone else, e.g. a receive buffer or a memory-mapped file
+   *
+   * \code
+   * std::vector<double> buffer = receive();
+   * Dune::DenseVectorRef<double> x(buffer.data(), buffer.size());
+   * x *= 2.0;                                             // scales buffer
+   * Dune::DenseVectorRef<const double> odd(buffer.data() + 1, buffer.size() / 2, 2);
+   * double n = odd.two_norm();
+   * \endcode
+   *
+   * Views of a compile-time size are provided by FieldVectorRef.
+   */
+
+  template< class K > class DenseVectorRef;
+  template< class K, int SIZE > class FieldVectorRef;
+
+  template< class K >
+  struct DenseMatVecTraits< DenseVectorRef<K> >
+  {
+    typedef DenseVectorRef<K> derived_type;
+    typedef K* container_type;
+    typedef K value_type;
+    typedef std::size_t size_type;
+  };
+
+  template< class K >
+  struct FieldTraits< DenseVectorRef<K> >
+  {
+    typedef typename FieldTraits<K>::field_type field_type;
+    typedef typename FieldTraits<K>::real_type real_type;
+  };
+
+  namespace Impl {
+
+    template< class V >
+    struct IsDenseVectorRef : public std::false_type {};
+
+    template< class K >
+    struct IsDenseVectorRef< DenseVectorRef<K> > : public std::true_type {};
+
+    // whether V is a DenseVector with contiguous entries whose data() converts to K*,
+    // the entries of DenseVectorRefs may have a stride
+    template< class V, class K, class = void >
+    struct IsContiguousDenseVector : public std::false_type {};
+
+    template< class V, class K >
+    struct IsContiguousDenseVector< V, K,
+      std::enable_if_t<std::is_convertible<decltype(std::declval<V&>().data()), K*>::value> >
+      : public std::integral_constant<bool,
+          std::is_base_of<DenseVector<std::remove_const_t<V> >, std::remove_const_t<V> >::value
+          && !IsDenseVectorRef<std::remove_const_t<V> >::value> {};
+
+  } // end namespace Impl
+
+  /** \brief A view of n entries of type K, stride entries apart, in memory owned by someone else
+   *
+   * The view implements the DenseVector interface.  Reading and writing its
+   * entries reads and writes the viewed memory, and assigning to the view
+   * copies entries into the viewed memory, whose size cannot change.  Copies
+   * of the view view the same memory.  Arithmetic producing a new vector,
+   * e.g. `x + y`, returns an owning DynamicVector<K>.
+   *
+   * \tparam K the type of the entries, const K for read-only views
+   */
+  template< class K >
+  class DenseVectorRef :
+    public DenseVector< DenseVectorRef<K> >
+  {
+    typedef DenseVector< DenseVectorRef<K> > Base;
+    typedef typename std::remove_const<K>::type field_value_type;
+
+  public:
+    typedef typename Base::size_type size_type;
+    typedef typename Base::value_type value_type;
+
+    //! the owning vector type of the results of the arithmetic
+    typedef DynamicVector<field_value_type> vector_type;
+
+  private:
+    K* _data;
+    size_type _size;
+    size_type _stride;
+
+  public:
+    //! Constructor of an empty view
+    DenseVectorRef () noexcept
+      : _data(nullptr), _size(0), _stride(1)
+    {}
+
+    /** \brief Constructor viewing the entries data[0], data[stride], ..., data[(n-1)*stride]
+     *
+     * \param data   the first entry
+     * \param n      the number of entries
+     * \param stride the distance between consecutive entries, counted in entries
+     */
+    DenseVectorRef (K* data, size_type n, size_type stride = 1) noexcept
+      : _data(data), _size(n), _stride(stride)
+    {
+      assert(stride > 0);
+    }
+
+    //! Constructor viewing all entries of a vector with contiguous storage, e.g. a FieldVector or DynamicVector
+    template<class V, std::enable_if_t<Impl::IsContiguousDenseVector<V,K>::value, int> = 0>
+    DenseVectorRef (V& v) noexcept
+      : _data(v.data()), _size(v.size()), _stride(1)
+    {}
+
+    //! Constructor viewing the entries of a FieldVectorRef
+    template<class K1, int SIZE,
+             std::enable_if_t<std::is_convertible<K1*, K*>::value, int> = 0>
+    DenseVectorRef (const FieldVectorRef<K1,SIZE>& v) noexcept
+      : _data(v.data()), _size(SIZE), _stride(1)
+    {}
+
+    //! Constructor of a read-only view from a mutable one
+    template<class K1,
+             std::enable_if_t<!std::is_same<K1, K>::value && std::is_convertible<K1*, K*>::value, int> = 0>
+    DenseVectorRef (const DenseVectorRef<K1>& other) noexcept
+      : _data(other.data()), _size(other.size()), _stride(other.stride())
+    {}
+
+    //! Copy constructor, the copy views the same entries
+    DenseVectorRef (const DenseVectorRef&) = default;
+
+    //! copy the entries of other into the viewed entries
+    DenseVectorRef& operator= (const DenseVectorRef& other)
+    {
+      return assign(other);
+    }
+
+    //! copy the entries of a view of the same, possibly read-only, entry type into the viewed entries
+    template<class K1,
+             std::enable_if_t<!std::is_same<K1, K>::value
+                              && std::is_same<std::remove_const_t<K1>, std::remove_const_t<K> >::value, int> = 0>
+    DenseVectorRef& operator= (const DenseVectorRef<K1>& other)
+    {
+      return assign(other);
+    }
+
+    using Base::operator=;
+
+    //===== access to components
+
+    size_type size () const noexcept { return _size; }
+
+    K & operator[](size_type i)
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _data[i*_stride];
+    }
+    const K & operator[](size_type i) const
+    {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return _data[i*_stride];
+    }
+
+    /** \brief return pointer to the first viewed entry
+     *
+     * \note The entries are contiguous in memory only if stride() == 1.
+     */
+    K* data() const noexcept
+    {
+      return _data;
+    }
+
+    //! the distance between consecutive entries in memory, counted in entries
+    size_type stride() const noexcept
+    {
+      return _stride;
+    }
+
+    //===== arithmetic with owning results
+
+    //! Binary vector addition
+    template <class Other>
+    vector_type operator+ (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z += b;
+      return z;
+    }
+
+    //! Binary vector subtraction
+    template <class Other>
+    vector_type operator- (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z -= b;
+      return z;
+    }
+
+    //! Vector negation
+    vector_type operator- () const
+    {
+      return -vector_type(*this);
+    }
+
+  private:
+    // copy the entries of other into the viewed entries
+    template<class K1>
+    DenseVectorRef& assign (const DenseVectorRef<K1>& other)
+    {
+      DUNE_ASSERT_BOUNDS(other.size() == size());
+      if (overlaps(other))
+        // through a copy, as the entries of other would be overwritten
+        return *this = vector_type(other);
+      Impl::denseFor<DenseVectorRef>(size(), [&](size_type i) { (*this)[i] = other[i]; });
+      return *this;
+    }
+
+    // whether the memory ranges spanned by the two views intersect
+    template<class K1>
+    bool overlaps (const DenseVectorRef<K1>& other) const
+    {
+      if (size() == 0 || other.size() == 0)
+        return false;
+      const std::less<const K*> less;
+      const K* last = _data + (size()-1)*_stride;
+      const K* otherFirst = other.data();
+      const K* otherLast = otherFirst + (other.size()-1)*other.stride();
+      return !less(last, otherFirst) && !less(otherLast, _data);
+    }
+  };
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_DENSEVECTORREF_HH
@@ -0,0 +1,609 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_DOUBLEDOUBLE_HH
+#define DUNE_COMMON_DOUBLEDOUBLE_HH
+
+/** \file
+ * \brief A floating point type of about 32 decimal digits made of two doubles
+ *
+ * A DoubleDouble represents the unevaluated sum hi + lo of two doubles
+ * with |lo| <= ulp(hi)/2.  The arithmetic is built from the error-free
+ * transformations twoSum() and twoProduct(), which use fused multiply-add
+ * instructions if the target has them, so it runs in hardware at a few
+ * times the cost of double.  The software emulated __float128 (see
+ * AddQuadMathFlags.cmake) is much slower and has a wider exponent range
+ * and 113 instead of 106 bits of mantissa.
+ *
+ * The relative errors of the operations are bounded by small multiples of
+ * 2^-106 (Joldes, Muller and Popescu, "Tight and rigorous error bounds for
+ * basic building blocks of double-word arithmetic", 2017).  The exponent
+ * range is that of double.
+ *
+ * DoubleDouble can be used as the field type of FieldVector and
+ * DynamicVector, e.g. for accurate reductions or the residuals of an
+ * iterative refinement:
+ * \code
+ * Dune::FieldVector<Dune::DoubleDouble,3> x = ...;
+ * Dune::DoubleDouble n = x.two_norm();
+ * \endcode
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include <dune/common/math.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/summation.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  /** \brief A double-word floating point number with 106 bits of mantissa
+   *
+   * See the file documentation for the representation and accuracy.  Mixed
+   * operations with double are cheaper than converting the double first.
+   */
+  class DoubleDouble
+  {
+  public:
+    //! Constructor making a zero
+    constexpr DoubleDouble () noexcept
+      : hi_(0), lo_(0)
+    {}
+
+    //! Conversion from double, which is exact
+    constexpr DoubleDouble (double d) noexcept
+      : hi_(d), lo_(0)
+    {}
+
+    /** \brief Conversion from integers, float and long double
+     *
+     * The value is rounded to 106 bits of mantissa if long double has at
+     * least 64 bits of mantissa, as on x86, and to 53 bits otherwise.
+     */
+    template<class T,
+             std::enable_if_t<std::is_arithmetic<T>::value && !std::is_same<T, double>::value, int> = 0>
+    DoubleDouble (T t) noexcept
+    {
+      const long double l = t;
+      hi_ = double(l);
+      lo_ = double(l - hi_);
+    }
+
+    //! The number hi + lo, normalized by an error-free transformation
+    DoubleDouble (double hi, double lo) noexcept
+    {
+      const auto s = twoSum(hi, lo);
+      hi_ = s.first;
+      lo_ = s.second;
+    }
+
+    //! The value rounded to double
+    explicit operator double () const noexcept
+    {
+      return hi_;
+    }
+
+    //! The value rounded to long double
+    explicit operator long double () const noexcept
+    {
+      return static_cast<long double>(hi_) + lo_;
+    }
+
+    //! The leading part, i.e., the value rounded to double
+    constexpr double hi () const noexcept
+    {
+      return hi_;
+    }
+
+    //! The trailing part, the rounding error of hi()
+    constexpr double lo () const noexcept
+    {
+      return lo_;
+    }
+
+    //! The number with the given parts, which must satisfy |lo| <= ulp(hi)/2
+    static constexpr DoubleDouble fromParts (double hi, double lo) noexcept
+    {
+      DoubleDouble x;
+      x.hi_ = hi;
+      x.lo_ = lo;
+      return x;
+    }
+
+    //===== arithmetic
+
+    //! addition, with a relative error of at most 3*2^-106
+    friend DoubleDouble operator+ (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      const auto s = twoSum(x.hi_, y.hi_);
+      const auto t = twoSum(x.lo_, y.lo_);
+      const auto v = fastTwoSum(s.first, s.second + t.first);
+      return fastTwoSum(v.hi_, t.second + v.lo_);
+    }
+
+    friend DoubleDouble operator+ (const DoubleDouble& x, double y) noexcept
+    {
+      const auto s = twoSum(x.hi_, y);
+      return fastTwoSum(s.first, x.lo_ + s.second);
+    }
+
+    friend DoubleDouble operator+ (double x, const DoubleDouble& y) noexcept
+    {
+      return y + x;
+    }
+
+    friend DoubleDouble operator- (const DoubleDouble& x) noexcept
+    {
+      return fromParts(-x.hi_, -x.lo_);
+    }
+
+    friend DoubleDouble operator+ (const DoubleDouble& x) noexcept
+    {
+      return x;
+    }
+
+    friend DoubleDouble operator- (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return x + (-y);
+    }
+
+    friend DoubleDouble operator- (const DoubleDouble& x, double y) noexcept
+    {
+      return x + (-y);
+    }
+
+    friend DoubleDouble operator- (double x, const DoubleDouble& y) noexcept
+    {
+      return (-y) + x;
+    }
+
+    //! multiplication, with a relative error of at most 5*2^-106
+    friend DoubleDouble operator* (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      const auto c = twoProduct(x.hi_, y.hi_);
+      return fastTwoSum(c.first, c.second + mulAdd(x.lo_, y.hi_, mulAdd(x.hi_, y.lo_, x.lo_*y.lo_)));
+    }
+
+    friend DoubleDouble operator* (const DoubleDouble& x, double y) noexcept
+    {
+      const auto c = twoProduct(x.hi_, y);
+      return fastTwoSum(c.first, mulAdd(x.lo_, y, c.second));
+    }
+
+    friend DoubleDouble operator* (double x, const DoubleDouble& y) noexcept
+    {
+      return y * x;
+    }
+
+    //! division, with a relative error of at most 15*2^-106
+    friend DoubleDouble operator/ (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      const double q = x.hi_ / y.hi_;
+      const DoubleDouble r = y * q;
+      const double delta = (x.hi_ - r.hi_) + (x.lo_ - r.lo_);
+      return fastTwoSum(q, delta / y.hi_);
+    }
+
+    friend DoubleDouble operator/ (const DoubleDouble& x, double y) noexcept
+    {
+      const double q = x.hi_ / y;
+      const auto p = twoProduct(q, y);
+      const double delta = ((x.hi_ - p.first) - p.second) + x.lo_;
+      return fastTwoSum(q, delta / y);
+    }
+
+    friend DoubleDouble operator/ (double x, const DoubleDouble& y) noexcept
+    {
+      return DoubleDouble(x) / y;
+    }
+
+    DoubleDouble& operator+= (const DoubleDouble& y) noexcept { return *this = *this + y; }
+    DoubleDouble& operator-= (const DoubleDouble& y) noexcept { return *this = *this - y; }
+    DoubleDouble& operator*= (const DoubleDouble& y) noexcept { return *this = *this * y; }
+    DoubleDouble& operator/= (const DoubleDouble& y) noexcept { return *this = *this / y; }
+    DoubleDouble& operator+= (double y) noexcept { return *this = *this + y; }
+    DoubleDouble& operator-= (double y) noexcept { return *this = *this - y; }
+    DoubleDouble& operator*= (double y) noexcept { return *this = *this * y; }
+    DoubleDouble& operator/= (double y) noexcept { return *this = *this / y; }
+
+    //===== comparisons, lexicographic in (hi,lo) for normalized numbers
+
+    friend bool operator== (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return x.hi_ == y.hi_ && x.lo_ == y.lo_;
+    }
+
+    friend bool operator!= (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return !(x == y);
+    }
+
+    friend bool operator< (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return x.hi_ < y.hi_ || (x.hi_ == y.hi_ && x.lo_ < y.lo_);
+    }
+
+    friend bool operator> (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return y < x;
+    }
+
+    friend bool operator<= (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return x.hi_ < y.hi_ || (x.hi_ == y.hi_ && x.lo_ <= y.lo_);
+    }
+
+    friend bool operator>= (const DoubleDouble& x, const DoubleDouble& y) noexcept
+    {
+      return y <= x;
+    }
+
+    //===== math functions, found by argument-dependent lookup
+
+    friend DoubleDouble abs (const DoubleDouble& x) noexcept
+    {
+      return (x.hi_ < 0) ? -x : x;
+    }
+
+    //! square root, by one Newton step from the square root of hi
+    friend DoubleDouble sqrt (const DoubleDouble& x) noexcept
+    {
+      if (!(x.hi_ > 0) || x.hi_ == std::numeric_limits<double>::infinity())
+        // zeros, infinity and NaN; NaN for negative numbers
+        return std::sqrt(x.hi_);
+      const double s = std::sqrt(x.hi_);
+      const auto p = twoProduct(s, s);
+      return fastTwoSum(s, (((x.hi_ - p.first) - p.second) + x.lo_) / (2*s));
+    }
+
+    friend bool isnan (const DoubleDouble& x) noexcept
+    {
+      return std::isnan(x.hi_);
+    }
+
+    friend bool isinf (const DoubleDouble& x) noexcept
+    {
+      return std::isinf(x.hi_);
+    }
+
+    friend bool isfinite (const DoubleDouble& x) noexcept
+    {
+      return std::isfinite(x.hi_);
+    }
+
+  private:
+    // the sum a + b as a normalized number, provided that |a| >= |b| or a = 0
+    static DoubleDouble fastTwoSum (double a, double b) noexcept
+    {
+      const double s = a + b;
+      return fromParts(s, b - (s - a));
+    }
+
+    // a*b + c, fused if the target has a fast fused multiply-add
+    static double mulAdd (double a, double b, double c) noexcept
+    {
+#if defined(FP_FAST_FMA) || defined(__FMA__)
+      return std::fma(a, b, c);
+#else
+      return a*b + c;
+#endif
+    }
+
+    double hi_;
+    double lo_;
+  };
+
+  namespace Impl {
+
+    //! 10^n for n >= 0, with a relative error of about n*2^-104
+    inline DoubleDouble doubleDoublePow10 (int n)
+    {
+      DoubleDouble result = 1.0;
+      DoubleDouble factor = 10.0;
+      for (; n > 0; n /= 2) {
+        if (n % 2)
+          result *= factor;
+        factor *= factor;
+      }
+      return result;
+    }
+
+    //! x * 10^n
+    inline DoubleDouble doubleDoubleScale10 (DoubleDouble x, int n)
+    {
+      // split large exponents to keep 10^|n| finite
+      for (; n > 300; n -= 300)
+        x *= doubleDoublePow10(300);
+      for (; n < -300; n += 300)
+        x /= doubleDoublePow10(300);
+      return (n >= 0) ? x * doubleDoublePow10(n) : x / doubleDoublePow10(-n);
+    }
+
+    //! the decimal exponent e of x > 0 with 10^e <= x < 10^(e+1), x is scaled to [1,10)
+    inline int doubleDoubleNormalize10 (DoubleDouble& x)
+    {
+      int exponent = int(std::floor(std::log10(x.hi())));
+      x = doubleDoubleScale10(x, -exponent);
+      // the estimate of the exponent may be off by one
+      if (x >= DoubleDouble(10.0)) {
+        x /= 10.0;
+        ++exponent;
+      }
+      else if (x < DoubleDouble(1.0)) {
+        x *= 10.0;
+        --exponent;
+      }
+      return exponent;
+    }
+
+    /** \brief The first n > 0 decimal digits of x > 0, rounded to nearest
+     *
+     * Digits beyond the 33 significant ones are zero.
+     *
+     * \returns the decimal exponent of the first digit, which is one larger
+     *          than that of x if the rounding carries into a new digit
+     */
+    inline int doubleDoubleDigits (DoubleDouble x, int n, std::string& digits)
+    {
+      int exponent = doubleDoubleNormalize10(x);
+      const int trailingZeros = (n > 33) ? n - 33 : 0;
+      n -= trailingZeros;
+      digits.assign(std::size_t(n), '0');
+      for (int i = 0; i <= n; ++i) {
+        int d = int(std::floor(x.hi()));
+        x -= double(d);
+        if (x < DoubleDouble(0.0)) {
+          x += 1.0;
+          --d;
+        }
+        d = (d < 0) ? 0 : (d > 9) ? 9 : d;
+        if (i < n)
+          digits[std::size_t(i)] = char('0' + d);
+        else if (d > 5 || (d == 5 && (x != DoubleDouble(0.0) || (n > 0 && digits[std::size_t(n-1)] % 2)))) {
+          // round up, ties to even, and propagate the carry
+          int j = n - 1;
+          for (; j >= 0 && digits[std::size_t(j)] == '9'; --j)
+            digits[std::size_t(j)] = '0';
+          if (j >= 0)
+            ++digits[std::size_t(j)];
+          else {
+            digits.insert(digits.begin(), '1');
+            digits.pop_back();
+            ++exponent;
+          }
+        }
+        x *= 10.0;
+      }
+      digits.append(std::size_t(trailingZeros), '0');
+      return exponent;
+    }
+
+  } // end namespace Impl
+
+  /** \brief Write a DoubleDouble in decimal
+   *  \relates DoubleDouble
+   *
+   * The precision and the floatfield flags (fixed, scientific or neither)
+   * of the stream are respected as for double.  Use a precision of 32 to
+   * print all significant digits.
+   */
+  inline std::ostream& operator<< (std::ostream& s, const DoubleDouble& x)
+  {
+    if (!isfinite(x) || x.hi() == 0)
+      return s << x.hi();
+
+    const auto flags = s.flags();
+    const auto floatfield = flags & std::ios_base::floatfield;
+    const bool showpoint = flags & std::ios_base::showpoint;
+    const int precision = int(s.precision());
+    const DoubleDouble a = abs(x);
+
+    std::string result = (x.hi() < 0) ? "-" : (flags & std::ios_base::showpos) ? "+" : "";
+    std::string digits;
+    if (floatfield == std::ios_base::fixed) {
+      // the digits of |x| rounded to a multiple of 10^-precision
+      DoubleDouble scaled = a;
+      const int exponent = Impl::doubleDoubleNormalize10(scaled);
+      const int significant = exponent + 1 + precision;
+      if (significant > 0) {
+        const int e = Impl::doubleDoubleDigits(a, significant, digits);
+        digits.append(std::size_t(e - exponent), '0');
+      }
+      else
+        digits = (Impl::doubleDoubleScale10(a, precision) >= DoubleDouble(0.5)) ? "1" : "0";
+      if (digits.size() < std::size_t(precision + 1))
+        digits.insert(0, std::size_t(precision + 1) - digits.size(), '0');
+
+      const std::size_t point = digits.size() - std::size_t(precision);
+      result += digits.substr(0, point);
+      if (precision > 0 || showpoint)
+        result += ".";
+      result += digits.substr(point);
+      return s << result;
+    }
+
+    const bool scientific = (floatfield == std::ios_base::scientific);
+    const int significant = scientific ? precision + 1 : (precision > 0 ? precision : 1);
+    const int exponent = Impl::doubleDoubleDigits(a, significant, digits);
+    const bool useExponent = scientific || exponent < -4 || exponent >= significant;
+
+    std::string mantissa;
+    if (useExponent)
+      mantissa = digits.substr(0, 1) + "." + digits.substr(1);
+    else if (exponent >= 0)
+      mantissa = digits.substr(0, std::size_t(exponent + 1)) + "." + digits.substr(std::size_t(exponent + 1));
+    else
+      mantissa = "0." + std::string(std::size_t(-exponent - 1), '0') + digits;
+
+    // remove trailing zeros as for %g, and the point if nothing follows
+    if (!scientific && !showpoint)
+      mantissa.erase(mantissa.find_last_not_of('0') + 1);
+    if (mantissa.back() == '.' && !showpoint)
+      mantissa.pop_back();
+    result += mantissa;
+
+    if (useExponent) {
+      const int e = (exponent < 0) ? -exponent : exponent;
+      result += (flags & std::ios_base::uppercase) ? "E" : "e";
+      result += (exponent < 0) ? "-" : "+";
+      result += (e < 10 ? "0" : "") + std::to_string(e);
+    }
+    return s << result;
+  }
+
+  /** \brief Read a DoubleDouble in decimal
+   *  \relates DoubleDouble
+   *
+   * Reads a number in the formats of double with all of its digits.  On
+   * failure, the failbit of the stream is set and x is not changed.
+   */
+  inline std::istream& operator>> (std::istream& s, DoubleDouble& x)
+  {
+    std::string token;
+    if (!(s >> token))
+      return s;
+
+    std::size_t pos = 0;
+    const bool negative = (token[pos] == '-');
+    if (token[pos] == '-' || token[pos] == '+')
+      ++pos;
+
+    DoubleDouble value = 0.0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool afterPoint = false;
+    for (; pos < token.size(); ++pos) {
+      const char c = token[pos];
+      if (c >= '0' && c <= '9') {
+        value = value * 10.0 + double(c - '0');
+        exponent -= afterPoint;
+        hasDigits = true;
+      }
+      else if (c == '.' && !afterPoint)
+        afterPoint = true;
+      else
+        break;
+    }
+
+    if (hasDigits && pos < token.size() && (token[pos] == 'e' || token[pos] == 'E')) {
+      std::size_t parsed = 0;
+      try {
+        exponent += std::stoi(token.substr(pos + 1), &parsed);
+      }
+      catch (...) {
+        parsed = 0;
+      }
+      pos += (parsed > 0) ? parsed + 1 : 0;
+    }
+
+    if (!hasDigits || pos != token.size()) {
+      // infinity and NaN, as understood by strtod
+      char* end = nullptr;
+      const double d = std::strtod(token.c_str(), &end);
+      if (hasDigits || end != token.c_str() + token.size() || std::isfinite(d)) {
+        s.setstate(std::ios_base::failbit);
+        return s;
+      }
+      x = d;
+      return s;
+    }
+
+    value = Impl::doubleDoubleScale10(value, exponent);
+    x = negative ? -value : value;
+    return s;
+  }
+
+  //===== traits
+
+  template<>
+  struct IsNumber<DoubleDouble> : public std::true_type {};
+
+  template<>
+  struct HasNaN<DoubleDouble> : public std::true_type {};
+
+  template<>
+  struct PromotionTraits<DoubleDouble, double> { typedef DoubleDouble PromotedType; };
+
+  template<>
+  struct PromotionTraits<double, DoubleDouble> { typedef DoubleDouble PromotedType; };
+
+  //! The constants rounded to 106 bits
+  template<>
+  struct MathematicalConstants<DoubleDouble>
+  {
+    static const DoubleDouble e ()
+    {
+      return DoubleDouble::fromParts(2.718281828459045091e+00, 1.445646891729250158e-16);
+    }
+
+    static const DoubleDouble pi ()
+    {
+      return DoubleDouble::fromParts(3.141592653589793116e+00, 1.224646799147353207e-16);
+    }
+  };
+
+  /** @} */
+
+} // end namespace Dune
+
+namespace std {
+
+  template<>
+  class numeric_limits<Dune::DoubleDouble>
+  {
+    typedef Dune::DoubleDouble T;
+    typedef numeric_limits<double> Base;
+
+  public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr float_denorm_style has_denorm = denorm_absent;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr float_round_style round_style = round_indeterminate;
+    static constexpr bool is_iec559 = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = 2*Base::digits;
+    static constexpr int digits10 = 31;
+    static constexpr int max_digits10 = 33;
+    static constexpr int radix = 2;
+    //! the smallest exponent for which all 106 bits are available
+    static constexpr int min_exponent = Base::min_exponent + Base::digits;
+    static constexpr int min_exponent10 = -291;
+    static constexpr int max_exponent = Base::max_exponent;
+    static constexpr int max_exponent10 = Base::max_exponent10;
+    static constexpr bool traps = false;
+    static constexpr bool tinyness_before = false;
+
+    //! the smallest positive number with full precision
+    static constexpr T min () noexcept { return T::fromParts(0x1p-969, 0.0); }
+    static constexpr T lowest () noexcept { return T::fromParts(-Base::max(), -0x1.fffffffffffffp+969); }
+    static constexpr T max () noexcept { return T::fromParts(Base::max(), 0x1.fffffffffffffp+969); }
+    static constexpr T epsilon () noexcept { return T::fromParts(0x1p-104, 0.0); }
+    static constexpr T round_error () noexcept { return T::fromParts(0.5, 0.0); }
+    static constexpr T infinity () noexcept { return T::fromParts(Base::infinity(), 0.0); }
+    static constexpr T quiet_NaN () noexcept { return T::fromParts(Base::quiet_NaN(), Base::quiet_NaN()); }
+    static constexpr T signaling_NaN () noexcept { return T::fromParts(Base::signaling_NaN(), Base::signaling_NaN()); }
+    static constexpr T denorm_min () noexcept { return min(); }
+  };
+
+} // end namespace std
+
+#endif // DUNE_COMMON_DOUBLEDOUBLE_HH
@@ -0,0 +1,372 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_DUAL_HH
+#define DUNE_COMMON_DUAL_HH
+
+/** \file
+ * \brief Dual numbers for forward mode automatic differentiation
+ *
+ * A Dual<K,N> carries a value and its derivatives with respect to N
+ * independent variables.  Evaluating a function with Dual arguments yields
+ * the value and the gradient in one evaluation, exact up to rounding,
+ * where finite differences need N+1 evaluations and lose half of the
+ * digits:
+ * \code
+ * Dune::FieldVector<double,3> x = ...;
+ * auto xd = Dune::dualVariables(x);        // FieldVector<Dual<double,3>,3>
+ * auto r = xd.two_norm();                  // the norm and its gradient
+ * Dune::FieldVector<double,3> g = r.gradient();
+ * \endcode
+ * FieldVector and DenseVector work unchanged, with the norms computed by
+ * the generic fvmeta::abs2 and fvmeta::sqrt through the overloads found by
+ * argument-dependent lookup.  Dual numbers are real, so the generic
+ * conjugateComplex applies.
+ *
+ * The value and the derivatives are stored together in a LoopSIMD of N+1
+ * lanes, the value in lane 0.  Sums, products and the chain rule are then
+ * lane-wise operations on all N+1 lanes, which compilers vectorize.
+ *
+ * Comparisons only compare the values.  At points where a function is not
+ * differentiable, like sqrt or abs at zero, the derivatives are those of
+ * the formulas applied, possibly infinite or NaN.
+ */
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/loopsimd.hh>
+#include <dune/common/math.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  /** \brief A value and its derivatives with respect to N variables
+   *
+   * \tparam K a floating point type for the value and the derivatives
+   * \tparam N the number of independent variables
+   */
+  template<class K, int N>
+  class Dual
+  {
+    static_assert(std::is_floating_point<K>::value, "Dual requires a floating point type");
+    static_assert(N > 0, "Dual requires at least one derivative");
+
+  public:
+    //! the type of the value and the derivatives
+    typedef K value_type;
+
+    //! the number of derivatives
+    static constexpr int size = N;
+
+    //! the value and the derivatives as lanes of a SIMD type
+    typedef LoopSIMD<K, N+1> Lanes;
+
+    //! Constructor making a zero
+    constexpr Dual () = default;
+
+    //! Constructor making a constant, i.e., with zero derivatives
+    template<class U,
+             std::enable_if_t<std::is_arithmetic<U>::value, int> = 0>
+    Dual (const U& value)
+    {
+      lanes_[0] = K(value);
+    }
+
+    //! Constructor with given value and derivatives
+    Dual (const K& value, const FieldVector<K,N>& gradient)
+    {
+      lanes_[0] = value;
+      for (int i = 0; i < N; ++i)
+        lanes_[i+1] = gradient[i];
+    }
+
+    //! The independent variable i with the given value
+    static Dual variable (const K& value, int i)
+    {
+      Dual x(value);
+      x.lanes_[i+1] = K(1);
+      return x;
+    }
+
+    //! The number with the given value and derivatives
+    static Dual fromLanes (const Lanes& lanes)
+    {
+      Dual x;
+      x.lanes_ = lanes;
+      return x;
+    }
+
+    //! the value
+    const K& value () const
+    {
+      return lanes_[0];
+    }
+
+    //! the derivative with respect to variable i
+    const K& derivative (int i) const
+    {
+      return lanes_[i+1];
+    }
+
+    //! the derivative with respect to variable i
+    K& derivative (int i)
+    {
+      return lanes_[i+1];
+    }
+
+    //! the derivatives with respect to all variables
+    FieldVector<K,N> gradient () const
+    {
+      FieldVector<K,N> g;
+      for (int i = 0; i < N; ++i)
+        g[i] = lanes_[i+1];
+      return g;
+    }
+
+    //! the value and the derivatives
+    const Lanes& lanes () const
+    {
+      return lanes_;
+    }
+
+    //===== arithmetic
+
+    Dual& operator+= (const Dual& y) { lanes_ += y.lanes_; return *this; }
+    Dual& operator-= (const Dual& y) { lanes_ -= y.lanes_; return *this; }
+    Dual& operator*= (const Dual& y) { return *this = *this * y; }
+    Dual& operator/= (const Dual& y) { return *this = *this / y; }
+
+    Dual& operator+= (const K& k) { lanes_[0] += k; return *this; }
+    Dual& operator-= (const K& k) { lanes_[0] -= k; return *this; }
+    Dual& operator*= (const K& k) { lanes_ *= Lanes(k); return *this; }
+    Dual& operator/= (const K& k) { lanes_ /= Lanes(k); return *this; }
+
+    friend Dual operator+ (Dual x, const Dual& y) { return x += y; }
+    friend Dual operator- (Dual x, const Dual& y) { return x -= y; }
+    friend Dual operator+ (Dual x, const K& k) { return x += k; }
+    friend Dual operator- (Dual x, const K& k) { return x -= k; }
+    friend Dual operator* (Dual x, const K& k) { return x *= k; }
+    friend Dual operator/ (Dual x, const K& k) { return x /= k; }
+    friend Dual operator+ (const K& k, Dual x) { return x += k; }
+    friend Dual operator* (const K& k, Dual x) { return x *= k; }
+
+    friend Dual operator- (const K& k, const Dual& x)
+    {
+      Dual result = -x;
+      result.lanes_[0] += k;
+      return result;
+    }
+
+    friend Dual operator- (const Dual& x)
+    {
+      return fromLanes(-x.lanes_);
+    }
+
+    friend Dual operator+ (const Dual& x)
+    {
+      return x;
+    }
+
+    //! product rule: (xy)' = x'y + xy'
+    friend Dual operator* (const Dual& x, const Dual& y)
+    {
+      Dual result = fromLanes(Lanes(x.value()) * y.lanes_ + Lanes(y.value()) * x.lanes_);
+      result.lanes_[0] = x.value() * y.value();
+      return result;
+    }
+
+    //! quotient rule: (x/y)' = (x' - (x/y) y') / y
+    friend Dual operator/ (const Dual& x, const Dual& y)
+    {
+      const K q = x.value() / y.value();
+      Dual result = fromLanes((x.lanes_ - Lanes(q) * y.lanes_) / Lanes(y.value()));
+      result.lanes_[0] = q;
+      return result;
+    }
+
+    friend Dual operator/ (const K& k, const Dual& x)
+    {
+      const K q = k / x.value();
+      return chain(x, q, -q / x.value());
+    }
+
+    //===== comparisons of the values
+
+    friend bool operator== (const Dual& x, const Dual& y) { return x.value() == y.value(); }
+    friend bool operator!= (const Dual& x, const Dual& y) { return x.value() != y.value(); }
+    friend bool operator<  (const Dual& x, const Dual& y) { return x.value() <  y.value(); }
+    friend bool operator<= (const Dual& x, const Dual& y) { return x.value() <= y.value(); }
+    friend bool operator>  (const Dual& x, const Dual& y) { return x.value() >  y.value(); }
+    friend bool operator>= (const Dual& x, const Dual& y) { return x.value() >= y.value(); }
+
+    //===== math functions, found by argument-dependent lookup
+
+    friend Dual abs (const Dual& x)
+    {
+      return (x.value() < K(0)) ? -x : x;
+    }
+
+    friend Dual sqrt (const Dual& x)
+    {
+      using std::sqrt;
+      const K s = sqrt(x.value());
+      return chain(x, s, K(0.5) / s);
+    }
+
+    friend Dual exp (const Dual& x)
+    {
+      using std::exp;
+      const K e = exp(x.value());
+      return chain(x, e, e);
+    }
+
+    friend Dual log (const Dual& x)
+    {
+      using std::log;
+      return chain(x, log(x.value()), K(1) / x.value());
+    }
+
+    friend Dual sin (const Dual& x)
+    {
+      using std::sin; using std::cos;
+      return chain(x, sin(x.value()), cos(x.value()));
+    }
+
+    friend Dual cos (const Dual& x)
+    {
+      using std::sin; using std::cos;
+      return chain(x, cos(x.value()), -sin(x.value()));
+    }
+
+    //! x^p for a real exponent p
+    friend Dual pow (const Dual& x, const K& p)
+    {
+      using std::pow;
+      const K xp = pow(x.value(), p - K(1));
+      return chain(x, xp * x.value(), p * xp);
+    }
+
+    friend bool isnan (const Dual& x)
+    {
+      using std::isnan;
+      return isnan(x.value());
+    }
+
+    friend bool isinf (const Dual& x)
+    {
+      using std::isinf;
+      return isinf(x.value());
+    }
+
+    friend bool isfinite (const Dual& x)
+    {
+      using std::isfinite;
+      return isfinite(x.value());
+    }
+
+    //! the value followed by the derivatives in brackets
+    friend std::ostream& operator<< (std::ostream& s, const Dual& x)
+    {
+      s << x.value() << " [";
+      for (int i = 0; i < N; ++i)
+        s << (i > 0 ? ", " : "") << x.derivative(i);
+      return s << "]";
+    }
+
+  private:
+    // chain rule: f(x) with value fx and derivative df at x.value()
+    static Dual chain (const Dual& x, const K& fx, const K& df)
+    {
+      Dual result = fromLanes(Lanes(df) * x.lanes_);
+      result.lanes_[0] = fx;
+      return result;
+    }
+
+    Lanes lanes_;
+  };
+
+  /** \brief Integer power with the derivative computed directly
+   *  \relates Dual
+   */
+  template<class K, int N, class Exponent>
+  Dual<K,N> power (const Dual<K,N>& m, Exponent p)
+  {
+    static_assert(std::numeric_limits<Exponent>::is_integer, "Exponent must be an integer type!");
+    if (p == 0)
+      return Dual<K,N>(1);
+    // m^(p-1), and the derivative p m^(p-1) m'
+    const K mp = power(m.value(), p - 1);
+    typename Dual<K,N>::Lanes lanes = typename Dual<K,N>::Lanes(K(p) * mp) * m.lanes();
+    lanes[0] = mp * m.value();
+    return Dual<K,N>::fromLanes(lanes);
+  }
+
+  /** \brief The vector x as independent variables of a differentiation
+   *  \relates Dual
+   *
+   * Entry i of the result has the value x[i] and the unit derivative with
+   * respect to variable i.
+   */
+  template<class K, int N>
+  FieldVector<Dual<K,N>, N> dualVariables (const FieldVector<K,N>& x)
+  {
+    FieldVector<Dual<K,N>, N> result;
+    for (int i = 0; i < N; ++i)
+      result[i] = Dual<K,N>::variable(x[i], i);
+    return result;
+  }
+
+  //===== traits
+
+  template<class K, int N>
+  struct FieldTraits< Dual<K,N> >
+  {
+    typedef Dual<typename FieldTraits<K>::field_type, N> field_type;
+    typedef Dual<typename FieldTraits<K>::real_type, N> real_type;
+  };
+
+  template<class K, int N>
+  struct IsNumber< Dual<K,N> > : public std::true_type {};
+
+  template<class K, int N>
+  struct HasNaN< Dual<K,N> > : public std::integral_constant<bool, HasNaN<K>::value> {};
+
+  template<class K, int N>
+  struct PromotionTraits< Dual<K,N>, Dual<K,N> >
+  {
+    typedef Dual<K,N> PromotedType;
+  };
+
+  template<class K1, class K2, int N>
+  struct PromotionTraits< Dual<K1,N>, Dual<K2,N> >
+  {
+    typedef Dual<typename PromotionTraits<K1,K2>::PromotedType, N> PromotedType;
+  };
+
+  template<class K, class T, int N>
+  struct PromotionTraits< Dual<K,N>, T >
+  {
+    typedef Dual<typename PromotionTraits<K,T>::PromotedType, N> PromotedType;
+  };
+
+  template<class T, class K, int N>
+  struct PromotionTraits< T, Dual<K,N> >
+  {
+    typedef Dual<typename PromotionTraits<T,K>::PromotedType, N> PromotedType;
+  };
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_DUAL_HH
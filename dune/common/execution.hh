@@ -0,0 +1,90 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_EXECUTION_HH
+#define DUNE_COMMON_EXECUTION_HH
+
+/** \file
+ * \brief Execution policies selecting sequential or parallel algorithms
+ */
+
+#include <cstddef>
+
+#include <dune/common/parallelfor.hh>
+
+namespace Dune {
+
+  /** \brief Execution policies for algorithms on dense vectors
+   *
+   * The policies are passed as first argument to the algorithms, e.g.
+   * \code
+   * auto d = Dune::dot(Dune::Execution::par, x, y);
+   * \endcode
+   */
+  namespace Execution {
+
+    //! Request a sequential execution in the calling thread
+    struct SequencedPolicy {};
+
+    /** \brief Request a parallel execution
+     *
+     * The policy carries the ParallelOptions of the parallel loops.
+     * Problems smaller than the threshold are executed sequentially,
+     * hence the policy can be used for vectors of arbitrary size.
+     */
+    struct ParallelPolicy : public ParallelOptions
+    {
+      //! minimal problem size for which threads are used
+      std::size_t threshold = 32768;
+
+      /** \brief Whether reductions have to be bitwise reproducible
+       *
+       * If set, reductions like dot products and norms use a summation
+       * order which depends on the problem size only, so the results do
+       * not change with the number of threads or the threshold.
+       */
+      bool reproducible = false;
+
+      //! a copy of this policy using at most n threads
+      ParallelPolicy withThreads (std::size_t n) const
+      {
+        ParallelPolicy p(*this);
+        p.numThreads = n;
+        return p;
+      }
+
+      //! a copy of this policy executing at most g entries per task
+      ParallelPolicy withGrainSize (std::size_t g) const
+      {
+        ParallelPolicy p(*this);
+        p.grainSize = g;
+        return p;
+      }
+
+      //! a copy of this policy with bitwise reproducible reductions
+      ParallelPolicy withReproducibleReductions (bool r = true) const
+      {
+        ParallelPolicy p(*this);
+        p.reproducible = r;
+        return p;
+      }
+
+      //! a copy of this policy using threads for problems of size t and larger
+      ParallelPolicy withThreshold (std::size_t t) const
+      {
+        ParallelPolicy p(*this);
+        p.threshold = t;
+        return p;
+      }
+    };
+
+    //! the default sequential policy
+    constexpr SequencedPolicy seq{};
+
+    //! the default parallel policy
+    constexpr ParallelPolicy par{};
+
+  } // end namespace Execution
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_EXECUTION_HH
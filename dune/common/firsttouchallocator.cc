@@ -0,0 +1,96 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define DUNE_FIRSTTOUCH_USE_MMAP 1
+#endif
+
+#include <dune/common/firsttouchallocator.hh>
+
+namespace Dune {
+namespace Impl {
+
+  namespace {
+
+    // alignment of allocations which are not mapped page-wise
+    constexpr std::size_t cacheLineAlignment = 64;
+
+    // size of the huge pages mapped with HugePageMode::hugetlb
+    constexpr std::size_t hugePageSize = std::size_t(2) << 20;
+
+    bool mapPageWise (std::size_t bytes)
+    {
+#if DUNE_FIRSTTOUCH_USE_MMAP
+      return bytes >= pageAllocationThreshold;
+#else
+      (void) bytes;
+      return false;
+#endif
+    }
+
+#if DUNE_FIRSTTOUCH_USE_MMAP
+    // the size of the mapping, which is the same for all fallbacks of a mode
+    std::size_t mappedBytes (std::size_t bytes, HugePageMode mode)
+    {
+      const std::size_t page = (mode == HugePageMode::hugetlb)
+        ? hugePageSize : std::size_t(sysconf(_SC_PAGESIZE));
+      return (bytes + page - 1) / page * page;
+    }
+
+    void* mapAnonymous (std::size_t bytes, int extraFlags)
+    {
+      void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+      return (p == MAP_FAILED) ? nullptr : p;
+    }
+#endif
+
+  } // end anonymous namespace
+
+  void* allocatePages (std::size_t bytes, HugePageMode mode)
+  {
+    if (!mapPageWise(bytes))
+      return ::operator new(bytes, std::align_val_t(cacheLineAlignment));
+
+#if DUNE_FIRSTTOUCH_USE_MMAP
+    const std::size_t size = mappedBytes(bytes, mode);
+    void* p = nullptr;
+#ifdef MAP_HUGETLB
+    if (mode == HugePageMode::hugetlb)
+      p = mapAnonymous(size, MAP_HUGETLB);
+#endif
+    if (!p) {
+      p = mapAnonymous(size, 0);
+      if (!p)
+        throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+      if (mode != HugePageMode::none)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+    }
+    return p;
+#else
+    (void) mode;
+    return nullptr;
+#endif
+  }
+
+  void deallocatePages (void* p, std::size_t bytes, HugePageMode mode) noexcept
+  {
+    if (!mapPageWise(bytes)) {
+      ::operator delete(p, std::align_val_t(cacheLineAlignment));
+      return;
+    }
+
+#if DUNE_FIRSTTOUCH_USE_MMAP
+    munmap(p, mappedBytes(bytes, mode));
+#else
+    (void) mode;
+#endif
+  }
+
+} // end namespace Impl
+} // end namespace Dune
@@ -0,0 +1,180 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_FIRSTTOUCHALLOCATOR_HH
+#define DUNE_COMMON_FIRSTTOUCHALLOCATOR_HH
+
+/** \file
+ * \brief An allocator placing the pages of large vectors by parallel first touch
+ *
+ * Operating systems with a first-touch policy, like Linux, place a page on
+ * the NUMA node of the thread writing it first.  If a large vector is
+ * initialized by the main thread only, all its pages end up on one node and
+ * the threads on the other nodes read remote memory in every parallel
+ * kernel.  FirstTouchAllocator therefore writes the freshly allocated memory
+ * in parallel, split into the same cache-line aligned chunks as the kernels
+ * in paralleldensevector.hh use for the same execution policy:
+ * \code
+ * using Alloc = Dune::FirstTouchAllocator<double>;
+ * const auto policy = Dune::Execution::par.withThreads(16);
+ * Dune::DynamicVector<double, Alloc> x(n, Alloc(policy, Dune::HugePageMode::transparent));
+ * auto d = Dune::dot(policy, x, x);
+ * \endcode
+ * Vectors smaller than policy.threshold are touched by the calling thread,
+ * as the kernels process them there.  For larger ones the chunks are the
+ * same, but which thread runs which chunk is decided by the scheduler of
+ * each parallel loop, and work stealing may assign a chunk to another
+ * thread than in a later kernel.  The placement is therefore a likely
+ * match rather than a guarantee; it is most stable on a machine that is
+ * otherwise idle, with a policy limiting the number of threads.
+ *
+ * Large allocations may additionally be backed by huge pages to reduce TLB
+ * misses, see HugePageMode.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include <dune/common/execution.hh>
+#include <dune/common/paralleldensevector.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  //! How the memory of large allocations is backed by huge pages
+  enum class HugePageMode
+  {
+    //! use the default page size
+    none,
+    //! advise the kernel to use transparent huge pages (madvise(MADV_HUGEPAGE))
+    transparent,
+    //! map explicit huge pages from the hugetlb pool, falling back to transparent ones
+    hugetlb
+  };
+
+  namespace Impl {
+
+    //! allocations of at least this many bytes are mapped page-wise
+    constexpr std::size_t pageAllocationThreshold = std::size_t(1) << 20;
+
+    /** \brief Allocate bytes of memory aligned to at least a cache line
+     *
+     * Allocations of at least pageAllocationThreshold bytes are mapped
+     * directly from the operating system, if supported, and get huge pages
+     * according to mode.  The memory is not touched.
+     */
+    void* allocatePages (std::size_t bytes, HugePageMode mode);
+
+    //! Free memory obtained from allocatePages(bytes, mode)
+    void deallocatePages (void* p, std::size_t bytes, HugePageMode mode) noexcept;
+
+  } // end namespace Impl
+
+  /** \brief Allocator writing newly allocated memory in parallel
+   *
+   * The allocated memory is zeroed by the threads which later process it in
+   * the parallel kernels for the policy given on construction, which places
+   * the pages on the NUMA nodes of these threads.  Elements are constructed
+   * as by std::allocator; the construction does not change the placement
+   * of the pages any more.
+   *
+   * Two allocators compare equal if they use the same HugePageMode, the
+   * execution policy only affects the placement.
+   *
+   * \tparam T the value type
+   */
+  template<class T>
+  class FirstTouchAllocator
+  {
+    template<class U>
+    friend class FirstTouchAllocator;
+
+  public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind
+    {
+      typedef FirstTouchAllocator<U> other;
+    };
+
+    //! an allocator touching the memory as the kernels with the given policy
+    FirstTouchAllocator (const Execution::ParallelPolicy& policy = Execution::par,
+                         HugePageMode hugePages = HugePageMode::none) noexcept
+      : policy_(policy), hugePages_(hugePages)
+    {}
+
+    //! converting copy constructor
+    template<class U>
+    FirstTouchAllocator (const FirstTouchAllocator<U>& other) noexcept
+      : policy_(other.policy_), hugePages_(other.hugePages_)
+    {}
+
+    //! allocate n elements and touch them in parallel, or sequentially below the threshold of the policy
+    T* allocate (size_type n)
+    {
+      if (n > max_size())
+        throw std::bad_array_new_length();
+      T* p = static_cast<T*>(Impl::allocatePages(n*sizeof(T), hugePages_));
+      auto touch = [p] (std::size_t first, std::size_t last) {
+        std::memset(static_cast<void*>(p + first), 0, (last - first)*sizeof(T));
+      };
+      if (n < policy_.threshold)
+        touch(0, n);
+      else
+        Impl::forCacheLineChunks<T>(n, policy_, touch);
+      return p;
+    }
+
+    //! free the memory of n elements allocated by an equal allocator
+    void deallocate (T* p, size_type n) noexcept
+    {
+      Impl::deallocatePages(p, n*sizeof(T), hugePages_);
+    }
+
+    size_type max_size () const noexcept
+    {
+      return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    //! the policy determining which thread touches which part of the memory
+    const Execution::ParallelPolicy& policy () const noexcept
+    {
+      return policy_;
+    }
+
+    //! the huge page mode of large allocations
+    HugePageMode hugePages () const noexcept
+    {
+      return hugePages_;
+    }
+
+    template<class U>
+    bool operator== (const FirstTouchAllocator<U>& other) const noexcept
+    {
+      return hugePages_ == other.hugePages_;
+    }
+
+    template<class U>
+    bool operator!= (const FirstTouchAllocator<U>& other) const noexcept
+    {
+      return !(*this == other);
+    }
+
+  private:
+    Execution::ParallelPolicy policy_;
+    HugePageMode hugePages_;
+  };
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_FIRSTTOUCHALLOCATOR_HH
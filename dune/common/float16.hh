@@ -0,0 +1,412 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_FLOAT16_HH
+#define DUNE_COMMON_FLOAT16_HH
+
+/** \file
+ * \brief 16-bit floating point types for storage of large coefficient fields
+ *
+ * Float16 is the IEEE 754 binary16 format, BFloat16 is the upper half of a
+ * binary32 float.  Both are storage formats: all arithmetic converts the
+ * operands to float and yields float, and the reductions of DenseVector
+ * accumulate in float, since FieldTraits declare float as field and real
+ * type.  Conversions round to nearest, ties to even, and keep infinities
+ * and NaNs.
+ *
+ * The conversions of Float16 use the F16C instructions if the compiler
+ * targets them (e.g. with -mf16c or -march=native), the bulk conversions
+ * additionally use AVX-512 if available.  Otherwise, and for BFloat16,
+ * the conversions are done by integer arithmetic, which compilers
+ * vectorize in the bulk conversions.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+#if defined(__F16C__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <dune/common/ftraits.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  namespace Impl {
+
+    inline std::uint32_t floatBits (float f)
+    {
+      std::uint32_t u;
+      std::memcpy(&u, &f, sizeof(u));
+      return u;
+    }
+
+    inline float bitsToFloat (std::uint32_t u)
+    {
+      float f;
+      std::memcpy(&f, &u, sizeof(f));
+      return f;
+    }
+
+    //! binary16 bits of f, rounded to nearest even
+    inline std::uint16_t floatToHalfBits (float f)
+    {
+#ifdef __F16C__
+      return std::uint16_t(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+      std::uint32_t u = floatBits(f);
+      const std::uint32_t sign = u & 0x80000000u;
+      u ^= sign;
+
+      std::uint32_t h;
+      if (u >= (127u + 16u) << 23)
+        // overflow to infinity, or NaN keeping the upper payload bits and
+        // quieted, as F16C does
+        h = (u > 0x7f800000u) ? 0x7e00u | ((u >> 13) & 0x3ffu) : 0x7c00u;
+      else if (u < 113u << 23) {
+        // subnormal or zero: let the float addition round at the position of 2^-24
+        const float denormMagic = bitsToFloat(126u << 23);
+        h = floatBits(bitsToFloat(u) + denormMagic) - (126u << 23);
+      }
+      else {
+        // normal: rebias the exponent and round the mantissa to nearest even
+        const std::uint32_t mantissaOdd = (u >> 13) & 1u;
+        u += 0xc8000fffu + mantissaOdd;
+        h = u >> 13;
+      }
+      return std::uint16_t(h | (sign >> 16));
+#endif
+    }
+
+    //! the float value of binary16 bits
+    inline float halfBitsToFloat (std::uint16_t h)
+    {
+#ifdef __F16C__
+      return _cvtsh_ss(h);
+#else
+      const std::uint32_t shiftedExponent = 0x7c00u << 13;
+      std::uint32_t u = std::uint32_t(h & 0x7fffu) << 13;
+      const std::uint32_t exponent = u & shiftedExponent;
+      u += (127u - 15u) << 23;
+      if (exponent == shiftedExponent) {
+        // infinity, or NaN keeping the payload and quieted, as F16C does
+        u += (128u - 16u) << 23;
+        if (h & 0x3ffu)
+          u |= 0x400000u;
+      }
+      else if (exponent == 0) {
+        // zero or subnormal: renormalize
+        u += 1u << 23;
+        u = floatBits(bitsToFloat(u) - bitsToFloat(113u << 23));
+      }
+      return bitsToFloat(u | (std::uint32_t(h & 0x8000u) << 16));
+#endif
+    }
+
+    //! bfloat16 bits of f, rounded to nearest even
+    inline std::uint16_t floatToBFloatBits (float f)
+    {
+      const std::uint32_t u = floatBits(f);
+      if ((u & 0x7fffffffu) > 0x7f800000u)
+        return std::uint16_t((u >> 16) | 0x40u);
+      return std::uint16_t((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+    }
+
+    //! the float value of bfloat16 bits
+    inline float bfloatBitsToFloat (std::uint16_t b)
+    {
+      return bitsToFloat(std::uint32_t(b) << 16);
+    }
+
+    /** \brief d rounded to a float by rounding to odd
+     *
+     * Rounding the result to a format with at most 22 bits of mantissa
+     * gives the correctly rounded value of d, which a conversion to float
+     * rounded to nearest would not (double rounding).
+     */
+    inline float roundToOddFloat (double d)
+    {
+      const float f = float(d);
+      if (double(f) == d || std::isnan(d))
+        return f;
+      std::uint32_t u = floatBits(f);
+      if (std::abs(double(f)) > std::abs(d))
+        --u;
+      return bitsToFloat(u | 1u);
+    }
+
+  } // end namespace Impl
+
+  /** \brief IEEE 754 half precision (binary16) floating point number
+   *
+   * Arithmetic is done in float, see the file documentation.
+   */
+  class Float16
+  {
+  public:
+    //! Constructor making a zero
+    constexpr Float16 () noexcept
+      : bits_(0)
+    {}
+
+    //! Conversion from float, rounded to nearest even
+    Float16 (float f) noexcept
+      : bits_(Impl::floatToHalfBits(f))
+    {}
+
+    //! Conversion from double, rounded to nearest even
+    Float16 (double d) noexcept
+      : bits_(Impl::floatToHalfBits(Impl::roundToOddFloat(d)))
+    {}
+
+    //! Conversion from integers and long double
+    template<class T,
+             std::enable_if_t<std::is_arithmetic<T>::value
+                              && !std::is_same<T, float>::value && !std::is_same<T, double>::value, int> = 0>
+    Float16 (T t) noexcept
+      : Float16(double(t))
+    {}
+
+    //! The value as float, which is exact
+    operator float () const noexcept
+    {
+      return Impl::halfBitsToFloat(bits_);
+    }
+
+    //! The binary16 representation
+    std::uint16_t bits () const noexcept
+    {
+      return bits_;
+    }
+
+    //! The number with the given binary16 representation
+    static Float16 fromBits (std::uint16_t bits) noexcept
+    {
+      Float16 h;
+      h.bits_ = bits;
+      return h;
+    }
+
+    Float16& operator+= (float f) noexcept { return *this = float(*this) + f; }
+    Float16& operator-= (float f) noexcept { return *this = float(*this) - f; }
+    Float16& operator*= (float f) noexcept { return *this = float(*this) * f; }
+    Float16& operator/= (float f) noexcept { return *this = float(*this) / f; }
+
+  private:
+    std::uint16_t bits_;
+  };
+
+  /** \brief The bfloat16 floating point number, the upper half of a float
+   *
+   * It has the exponent range of float and 8 bits of mantissa.  Arithmetic
+   * is done in float, see the file documentation.
+   */
+  class BFloat16
+  {
+  public:
+    //! Constructor making a zero
+    constexpr BFloat16 () noexcept
+      : bits_(0)
+    {}
+
+    //! Conversion from float, rounded to nearest even
+    BFloat16 (float f) noexcept
+      : bits_(Impl::floatToBFloatBits(f))
+    {}
+
+    //! Conversion from double, rounded to nearest even
+    BFloat16 (double d) noexcept
+      : bits_(Impl::floatToBFloatBits(Impl::roundToOddFloat(d)))
+    {}
+
+    //! Conversion from integers and long double
+    template<class T,
+             std::enable_if_t<std::is_arithmetic<T>::value
+                              && !std::is_same<T, float>::value && !std::is_same<T, double>::value, int> = 0>
+    BFloat16 (T t) noexcept
+      : BFloat16(double(t))
+    {}
+
+    //! The value as float, which is exact
+    operator float () const noexcept
+    {
+      return Impl::bfloatBitsToFloat(bits_);
+    }
+
+    //! The bfloat16 representation
+    std::uint16_t bits () const noexcept
+    {
+      return bits_;
+    }
+
+    //! The number with the given bfloat16 representation
+    static BFloat16 fromBits (std::uint16_t bits) noexcept
+    {
+      BFloat16 b;
+      b.bits_ = bits;
+      return b;
+    }
+
+    BFloat16& operator+= (float f) noexcept { return *this = float(*this) + f; }
+    BFloat16& operator-= (float f) noexcept { return *this = float(*this) - f; }
+    BFloat16& operator*= (float f) noexcept { return *this = float(*this) * f; }
+    BFloat16& operator/= (float f) noexcept { return *this = float(*this) / f; }
+
+  private:
+    std::uint16_t bits_;
+  };
+
+  inline std::ostream& operator<< (std::ostream& s, const Float16& h)
+  {
+    return s << float(h);
+  }
+
+  inline std::ostream& operator<< (std::ostream& s, const BFloat16& b)
+  {
+    return s << float(b);
+  }
+
+  inline std::istream& operator>> (std::istream& s, Float16& h)
+  {
+    float f;
+    if (s >> f)
+      h = f;
+    return s;
+  }
+
+  inline std::istream& operator>> (std::istream& s, BFloat16& b)
+  {
+    float f;
+    if (s >> f)
+      b = f;
+    return s;
+  }
+
+  //===== bulk conversions
+
+  //! convert the n values starting at in to Float16
+  inline void convertArray (const float* in, std::size_t n, Float16* out)
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 16 <= n; i += 16)
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+        _mm512_cvtps_ph(_mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#elif defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= n; i += 8)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#endif
+    for (; i < n; ++i)
+      out[i] = Float16(in[i]);
+  }
+
+  //! convert the n values starting at in to float
+  inline void convertArray (const Float16* in, std::size_t n, float* out)
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 16 <= n; i += 16)
+      _mm512_storeu_ps(out + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+#elif defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= n; i += 8)
+      _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+#endif
+    for (; i < n; ++i)
+      out[i] = float(in[i]);
+  }
+
+  //! convert the n values starting at in to Float16
+  inline void convertArray (const double* in, std::size_t n, Float16* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = Float16(in[i]);
+  }
+
+  //! convert the n values starting at in to double
+  inline void convertArray (const Float16* in, std::size_t n, double* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = float(in[i]);
+  }
+
+  //! convert the n values starting at in to BFloat16
+  inline void convertArray (const float* in, std::size_t n, BFloat16* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = BFloat16(in[i]);
+  }
+
+  //! convert the n values starting at in to float
+  inline void convertArray (const BFloat16* in, std::size_t n, float* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = float(in[i]);
+  }
+
+  //! convert the n values starting at in to BFloat16
+  inline void convertArray (const double* in, std::size_t n, BFloat16* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = BFloat16(in[i]);
+  }
+
+  //! convert the n values starting at in to double
+  inline void convertArray (const BFloat16* in, std::size_t n, double* out)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = float(in[i]);
+  }
+
+  //===== traits
+
+  //! Float16 computes in float
+  template<>
+  struct FieldTraits<Float16>
+  {
+    typedef float field_type;
+    typedef float real_type;
+  };
+
+  //! BFloat16 computes in float
+  template<>
+  struct FieldTraits<BFloat16>
+  {
+    typedef float field_type;
+    typedef float real_type;
+  };
+
+  template<>
+  struct IsNumber<Float16> : public std::true_type {};
+
+  template<>
+  struct IsNumber<BFloat16> : public std::true_type {};
+
+  template<>
+  struct HasNaN<Float16> : public std::true_type {};
+
+  template<>
+  struct HasNaN<BFloat16> : public std::true_type {};
+
+  template<>
+  struct PromotionTraits<Float16, Float16> { typedef float PromotedType; };
+
+  template<>
+  struct PromotionTraits<BFloat16, BFloat16> { typedef float PromotedType; };
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_FLOAT16_HH
@@ -0,0 +1,337 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_FMATRIX_HH
+#define DUNE_FMATRIX_HH
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densematrix.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune
+{
+
+  /**
+      @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+
+     \brief Implements a matrix constructed from a given type
+     representing a field and compile-time given number of rows and columns.
+   */
+
+  template< class K, int ROWS, int COLS > class FieldMatrix;
+
+  template< class K, int ROWS, int COLS >
+  struct DenseMatVecTraits< FieldMatrix<K,ROWS,COLS> >
+  {
+    typedef FieldMatrix<K,ROWS,COLS> derived_type;
+
+    // each row is implemented by a field vector
+    typedef FieldVector<K,COLS> row_type;
+
+    typedef row_type &row_reference;
+    typedef const row_type &const_row_reference;
+
+    typedef std::array<row_type,ROWS> container_type;
+    typedef K value_type;
+    typedef typename container_type::size_type size_type;
+  };
+
+  template< class K, int ROWS, int COLS >
+  struct FieldTraits< FieldMatrix<K,ROWS,COLS> >
+  {
+    typedef typename FieldTraits<K>::field_type field_type;
+    typedef typename FieldTraits<K>::real_type real_type;
+  };
+
+  namespace Impl {
+
+    // the kernels of DenseMatrix are unrolled for FieldMatrix
+    template< class K, int ROWS, int COLS >
+    struct DenseMatrixStaticSize< FieldMatrix<K,ROWS,COLS> >
+    {
+      static constexpr std::size_t rows = ROWS;
+      static constexpr std::size_t cols = COLS;
+    };
+
+  } // end namespace Impl
+
+  /**
+      @brief A dense n x m matrix.
+
+     Matrices represent linear maps from a vector space V to a vector space W.
+     This class represents such a linear map by storing a two-dimensional
+     %array of numbers of a given field type K. The number of rows and
+     columns is given at compile time.
+
+     \tparam K    the field type (use float, double, complex, etc)
+     \tparam ROWS number of rows
+     \tparam COLS number of columns
+   */
+  template<class K, int ROWS, int COLS>
+  class FieldMatrix : public DenseMatrix< FieldMatrix<K,ROWS,COLS> >
+  {
+    std::array< FieldVector<K,COLS>, ROWS > _data;
+    typedef DenseMatrix< FieldMatrix<K,ROWS,COLS> > Base;
+  public:
+
+    //! export size
+    enum {
+      //! The number of rows.
+      rows = ROWS,
+      //! The number of columns.
+      cols = COLS
+    };
+
+    typedef typename Base::size_type size_type;
+    typedef typename Base::row_type row_type;
+
+    typedef typename Base::row_reference row_reference;
+    typedef typename Base::const_row_reference const_row_reference;
+
+    //===== constructors
+    /** \brief Default constructor
+     */
+    constexpr FieldMatrix() = default;
+
+    //! Constructor initializing all entries with the value t
+    explicit FieldMatrix (const K& t)
+    {
+      for (size_type i = 0; i < ROWS; ++i)
+        _data[i] = t;
+    }
+
+    /** \brief Constructor initializing the matrix from a list of vector
+     */
+    FieldMatrix(std::initializer_list<Dune::FieldVector<K, cols> > const &l) {
+      assert(l.size() == rows); // Actually, this is not needed any more!
+      std::copy_n(l.begin(), std::min(static_cast< std::size_t >( ROWS ),
+                                     l.size()),
+                 _data.begin());
+    }
+
+    //! Constructor from a matrix of the same size with a different field type
+    template<class K1>
+    explicit FieldMatrix (const FieldMatrix<K1,ROWS,COLS>& other)
+    {
+      for (size_type i = 0; i < ROWS; ++i)
+        _data[i] = other[i];
+    }
+
+    //! copy assignment operator
+    FieldMatrix& operator= (const FieldMatrix&) = default;
+
+    using Base::operator=;
+
+    //! Function that returns the transpose of the matrix
+    FieldMatrix<K, COLS, ROWS> transposed() const
+    {
+      FieldMatrix<K, COLS, ROWS> AT;
+      for (int i = 0; i < ROWS; ++i)
+        for (int j = 0; j < COLS; ++j)
+          AT[j][i] = (*this)[i][j];
+      return AT;
+    }
+
+    //! vector space addition -- two-argument version
+    template <class OtherScalar>
+    friend auto operator+ ( const FieldMatrix& matrixA,
+                            const FieldMatrix<OtherScalar,ROWS,COLS>& matrixB)
+    {
+      FieldMatrix<typename PromotionTraits<K,OtherScalar>::PromotedType,ROWS,COLS> result;
+
+      for (size_type i = 0; i < ROWS; ++i)
+        for (size_type j = 0; j < COLS; ++j)
+          result[i][j] = matrixA[i][j] + matrixB[i][j];
+
+      return result;
+    }
+
+    //! vector space subtraction -- two-argument version
+    template <class OtherScalar>
+    friend auto operator- ( const FieldMatrix& matrixA,
+                            const FieldMatrix<OtherScalar,ROWS,COLS>& matrixB)
+    {
+      FieldMatrix<typename PromotionTraits<K,OtherScalar>::PromotedType,ROWS,COLS> result;
+
+      for (size_type i = 0; i < ROWS; ++i)
+        for (size_type j = 0; j < COLS; ++j)
+          result[i][j] = matrixA[i][j] - matrixB[i][j];
+
+      return result;
+    }
+
+    //! vector space multiplication with scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator* ( const FieldMatrix& matrix, Scalar scalar)
+    {
+      FieldMatrix<typename PromotionTraits<K,Scalar>::PromotedType,ROWS,COLS> result;
+
+      for (size_type i = 0; i < ROWS; ++i)
+        for (size_type j = 0; j < COLS; ++j)
+          result[i][j] = matrix[i][j] * scalar;
+
+      return result;
+    }
+
+    //! vector space multiplication with scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator* ( Scalar scalar, const FieldMatrix& matrix)
+    {
+      FieldMatrix<typename PromotionTraits<K,Scalar>::PromotedType,ROWS,COLS> result;
+
+      for (size_type i = 0; i < ROWS; ++i)
+        for (size_type j = 0; j < COLS; ++j)
+          result[i][j] = scalar * matrix[i][j];
+
+      return result;
+    }
+
+    //! vector space division by scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator/ ( const FieldMatrix& matrix, Scalar scalar)
+    {
+      FieldMatrix<typename PromotionTraits<K,Scalar>::PromotedType,ROWS,COLS> result;
+
+      for (size_type i = 0; i < ROWS; ++i)
+        for (size_type j = 0; j < COLS; ++j)
+          result[i][j] = matrix[i][j] / scalar;
+
+      return result;
+    }
+
+    //! Matrix-vector product A x
+    template <class OtherScalar>
+    friend auto operator* ( const FieldMatrix& matrix,
+                            const FieldVector<OtherScalar,COLS>& x)
+    {
+      FieldVector<typename PromotionTraits<K,OtherScalar>::PromotedType,ROWS> result;
+      matrix.mv(x, result);
+      return result;
+    }
+
+    /** \brief Matrix-matrix multiplication
+     */
+    template <class OtherScalar, int otherCols>
+    friend auto operator* ( const FieldMatrix& matrixA,
+                            const FieldMatrix<OtherScalar, COLS, otherCols>& matrixB)
+    {
+      FieldMatrix<typename PromotionTraits<K,OtherScalar>::PromotedType,ROWS,otherCols> result;
+      Impl::matrixProduct<COLS, otherCols>(matrixA, matrixB, result, ROWS, COLS, otherCols);
+      return result;
+    }
+
+    //! Multiplies M from the left to this matrix, this matrix is not modified
+    template<int l>
+    FieldMatrix<K,l,cols> leftmultiplyany (const FieldMatrix<K,l,rows>& M) const
+    {
+      return M * (*this);
+    }
+
+    //! Multiplies M from the right to this matrix, this matrix is not modified
+    template<int l>
+    FieldMatrix<K,rows,l> rightmultiplyany (const FieldMatrix<K,cols,l>& M) const
+    {
+      return (*this) * M;
+    }
+
+    // make this thing a matrix
+    static constexpr size_type mat_rows() { return ROWS; }
+    static constexpr size_type mat_cols() { return COLS; }
+
+    row_reference operator[] ( size_type i )
+    {
+      DUNE_ASSERT_BOUNDS(i < ROWS);
+      return _data[i];
+    }
+
+    const_row_reference operator[] ( size_type i ) const
+    {
+      DUNE_ASSERT_BOUNDS(i < ROWS);
+      return _data[i];
+    }
+  };
+
+  namespace FMatrixHelp {
+
+    //! compute inverse of matrix of size 1, returns the determinant
+    template <typename K>
+    static inline K invertMatrix (const FieldMatrix<K,1,1> &matrix, FieldMatrix<K,1,1> &inverse)
+    {
+      inverse[0][0] = K(1) / matrix[0][0];
+      return matrix[0][0];
+    }
+
+    //! compute inverse of matrix of size 2, returns the determinant
+    template <typename K>
+    static inline K invertMatrix (const FieldMatrix<K,2,2> &matrix, FieldMatrix<K,2,2> &inverse)
+    {
+      return Impl::invert2(matrix, inverse);
+    }
+
+    //! compute inverse of matrix of size 3, returns the determinant
+    template <typename K>
+    static inline K invertMatrix (const FieldMatrix<K,3,3> &matrix, FieldMatrix<K,3,3> &inverse)
+    {
+      return Impl::invert3(matrix, inverse);
+    }
+
+    //! compute the transposed inverse of matrix of size 2, returns the determinant
+    template <typename K>
+    static inline K invertMatrix_retTransposed (const FieldMatrix<K,2,2> &matrix, FieldMatrix<K,2,2> &inverse)
+    {
+      const K det = Impl::invert2(matrix, inverse);
+      std::swap(inverse[0][1], inverse[1][0]);
+      return det;
+    }
+
+    //! compute the transposed inverse of matrix of size 3, returns the determinant
+    template <typename K>
+    static inline K invertMatrix_retTransposed (const FieldMatrix<K,3,3> &matrix, FieldMatrix<K,3,3> &inverse)
+    {
+      const K det = Impl::invert3(matrix, inverse);
+      for (int i = 0; i < 3; ++i)
+        for (int j = i+1; j < 3; ++j)
+          std::swap(inverse[i][j], inverse[j][i]);
+      return det;
+    }
+
+    //! calculates ret = A * B
+    template< class K, int m, int n, int p >
+    static inline void multMatrix ( const FieldMatrix< K, m, n > &A,
+                                    const FieldMatrix< K, n, p > &B,
+                                    FieldMatrix< K, m, p > &ret )
+    {
+      ret = A * B;
+    }
+
+    //! calculates ret = A^T * A
+    template <typename K, int rows, int cols>
+    static inline void multTransposedMatrix(const FieldMatrix<K,rows,cols> &matrix, FieldMatrix<K,cols,cols>& ret)
+    {
+      ret = matrix.transposed() * matrix;
+    }
+
+  } // end namespace FMatrixHelp
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif
@@ -0,0 +1,479 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_FMATRIXBATCH_HH
+#define DUNE_COMMON_FMATRIXBATCH_HH
+
+/** \file
+ * \brief Arrays of small vectors and matrices in SoA layout with batched solvers
+ *
+ * FieldVectorBatch<K,N> and FieldMatrixBatch<K,ROWS,COLS> store many
+ * vectors or matrices of the same size component by component: all
+ * entries (i,j) of the batch lie contiguously.  Single items are read and
+ * written as FieldVector and FieldMatrix:
+ * \code
+ * Dune::FieldMatrixBatch<double,3,3> jacobians(count);
+ * for (std::size_t e = 0; e < count; ++e)
+ *   jacobians.set(e, jacobian(e));      // a FieldMatrix<double,3,3>
+ * jacobians.invert();
+ * Dune::FieldMatrix<double,3,3> inverse = jacobians.get(0);
+ * \endcode
+ *
+ * determinant(), invert() and solve() compute the same as the
+ * corresponding methods of FieldMatrix for every item.  The closed
+ * formulas for sizes 1 to 3 are evaluated in a loop over the items, which
+ * reads every entry from a contiguous array and vectorizes.  Larger
+ * matrices are decomposed Impl::batchLanes<K>() at a time, one per lane of
+ * a LoopSIMD, where the pivot search and the row interchanges of the
+ * partial pivoting select lane-wise instead of branching.  The results agree
+ * bitwise with FieldMatrix unless the compiler contracts products and sums
+ * into fused multiply-adds differently in both.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densematrix.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/loopsimd.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  namespace Impl {
+
+    //! number of matrices of a batch factorized together, as many as fill 512 bits
+    template<class K>
+    constexpr std::size_t batchLanes ()
+    {
+      return sizeof(K) < 64 ? 64 / sizeof(K) : 1;
+    }
+
+    //! exchanges a and b in the lanes where m is true
+    template<class T>
+    void swapLanes (const typename T::mask_type& m, T& a, T& b)
+    {
+      const T t = cond(m, b, a);
+      b = cond(m, a, b);
+      a = t;
+    }
+
+    /** \brief Lane-wise in-place LU decomposition with partial pivoting
+     *
+     * Every lane of A is decomposed like DenseMatrix::luDecomposition
+     * does, with pivot[i] holding the original index of row i.  The pivot
+     * search and the row interchanges select lane-wise instead of
+     * branching.  Singular lanes are continued with a unit pivot instead
+     * of throwing.
+     *
+     * \returns the lanes holding singular matrices
+     */
+    template<class T, int n>
+    typename T::mask_type batchLUDecomposition (FieldMatrix<T,n,n>& A, FieldVector<T,n>& pivot, T& sign)
+    {
+      using std::abs;
+      typename T::mask_type singular;
+      sign = T(1);
+      for (int i = 0; i < n; ++i)
+        pivot[i] = T(i);
+      for (int k = 0; k < n; ++k) {
+        T p = T(k);
+        T pivmax = abs(A[k][k]);
+        for (int i = k+1; i < n; ++i) {
+          const T a = abs(A[i][k]);
+          const auto larger = a > pivmax;
+          pivmax = cond(larger, a, pivmax);
+          p = cond(larger, T(i), p);
+        }
+        const auto zero = pivmax == T(0);
+        singular = singular || zero;
+
+        for (int i = k+1; i < n; ++i) {
+          const auto swap = p == T(i);
+          for (int j = 0; j < n; ++j)
+            swapLanes(swap, A[k][j], A[i][j]);
+          swapLanes(swap, pivot[k], pivot[i]);
+        }
+        sign = cond(p == T(k), sign, -sign);
+
+        const T akk = cond(zero, T(1), A[k][k]);
+        for (int i = k+1; i < n; ++i) {
+          const T factor = A[i][k] / akk;
+          A[i][k] = factor;
+          for (int j = k+1; j < n; ++j)
+            A[i][j] -= factor * A[k][j];
+        }
+      }
+      return singular;
+    }
+
+    //! lane-wise forward and backward substitution with the factors of batchLUDecomposition, x holds the permuted right-hand sides on entry
+    template<class T, int n>
+    void batchLUSubstitution (const FieldMatrix<T,n,n>& lu, FieldVector<T,n>& x)
+    {
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < i; ++j)
+          x[i] -= lu[i][j] * x[j];
+      for (int i = n; i-- > 0;) {
+        for (int j = i+1; j < n; ++j)
+          x[i] -= lu[i][j] * x[j];
+        x[i] /= lu[i][i];
+      }
+    }
+
+    //! the number of lanes below n where m is true
+    template<std::size_t W>
+    std::size_t countLanes (const LoopSIMD<bool,W>& m, std::size_t n)
+    {
+      std::size_t count = 0;
+      for (std::size_t l = 0; l < n; ++l)
+        count += m[l];
+      return count;
+    }
+
+  } // end namespace Impl
+
+  /** \brief An array of vectors of size N, stored component by component
+   *
+   * Component i of all vectors lies contiguously at component(i).
+   */
+  template<class K, int N>
+  class FieldVectorBatch
+  {
+  public:
+    //! export the type representing the field
+    typedef K field_type;
+
+    //! the type of the items
+    typedef FieldVector<K,N> vector_type;
+
+    //! the type used for the index access and size operation
+    typedef std::size_t size_type;
+
+    //! export size of the items
+    enum {
+      //! The size of the items
+      dimension = N
+    };
+
+    //! Constructor making a batch of count vectors with entries zero
+    explicit FieldVectorBatch (size_type count = 0)
+      : data_(N*count), count_(count)
+    {}
+
+    //! the number of vectors
+    size_type size () const
+    {
+      return count_;
+    }
+
+    //! a copy of vector item
+    vector_type get (size_type item) const
+    {
+      DUNE_ASSERT_BOUNDS(item < count_);
+      vector_type v;
+      for (int i = 0; i < N; ++i)
+        v[i] = component(i)[item];
+      return v;
+    }
+
+    //! replaces vector item by v
+    void set (size_type item, const vector_type& v)
+    {
+      DUNE_ASSERT_BOUNDS(item < count_);
+      for (int i = 0; i < N; ++i)
+        component(i)[item] = v[i];
+    }
+
+    //! the entries i of all vectors
+    K* component (int i)
+    {
+      DUNE_ASSERT_BOUNDS(0 <= i && i < N);
+      return data_.data() + i*count_;
+    }
+
+    //! the entries i of all vectors
+    const K* component (int i) const
+    {
+      DUNE_ASSERT_BOUNDS(0 <= i && i < N);
+      return data_.data() + i*count_;
+    }
+
+  private:
+    std::vector<K> data_;
+    size_type count_;
+  };
+
+  /** \brief An array of ROWS x COLS matrices, stored entry by entry
+   *
+   * Entry (i,j) of all matrices lies contiguously at component(i,j).  The
+   * batches of square matrices provide the determinants, inverses and
+   * solutions of linear systems of all items, computed like those of
+   * FieldMatrix but several items at a time.
+   */
+  template<class K, int ROWS, int COLS>
+  class FieldMatrixBatch
+  {
+    // the number of matrices decomposed together, one per lane
+    static constexpr std::size_t W = Impl::batchLanes<K>();
+    typedef LoopSIMD<K,W> Lanes;
+
+    // the LU decompositions of W matrices
+    struct LUBlock
+    {
+      FieldMatrix<Lanes,ROWS,COLS> factors;
+      FieldVector<Lanes,ROWS> pivot;
+      Lanes sign;
+    };
+
+  public:
+    //! export the type representing the field
+    typedef K field_type;
+
+    //! the type of the items
+    typedef FieldMatrix<K,ROWS,COLS> matrix_type;
+
+    //! the type used for the index access and size operation
+    typedef std::size_t size_type;
+
+    //! export size of the items
+    enum {
+      //! The number of rows.
+      rows = ROWS,
+      //! The number of columns.
+      cols = COLS
+    };
+
+    //! Constructor making a batch of count matrices with entries zero
+    explicit FieldMatrixBatch (size_type count = 0)
+      : data_(ROWS*COLS*count), count_(count)
+    {}
+
+    //! the number of matrices
+    size_type size () const
+    {
+      return count_;
+    }
+
+    //! a copy of matrix item
+    matrix_type get (size_type item) const
+    {
+      DUNE_ASSERT_BOUNDS(item < count_);
+      matrix_type A;
+      for (int i = 0; i < ROWS; ++i)
+        for (int j = 0; j < COLS; ++j)
+          A[i][j] = component(i, j)[item];
+      return A;
+    }
+
+    //! replaces matrix item by A
+    void set (size_type item, const matrix_type& A)
+    {
+      DUNE_ASSERT_BOUNDS(item < count_);
+      for (int i = 0; i < ROWS; ++i)
+        for (int j = 0; j < COLS; ++j)
+          component(i, j)[item] = A[i][j];
+    }
+
+    //! the entries (i,j) of all matrices
+    K* component (int i, int j)
+    {
+      DUNE_ASSERT_BOUNDS(0 <= i && i < ROWS && 0 <= j && j < COLS);
+      return data_.data() + (i*COLS + j)*count_;
+    }
+
+    //! the entries (i,j) of all matrices
+    const K* component (int i, int j) const
+    {
+      DUNE_ASSERT_BOUNDS(0 <= i && i < ROWS && 0 <= j && j < COLS);
+      return data_.data() + (i*COLS + j)*count_;
+    }
+
+    /** \brief the determinants of all matrices
+     *
+     * \param[out] det det[e] is the determinant of matrix e, as computed by FieldMatrix::determinant()
+     */
+    void determinant (std::vector<K>& det) const
+    {
+      static_assert(ROWS == COLS, "determinant requires square matrices");
+      det.resize(count_);
+      if constexpr (ROWS <= 3) {
+        for (size_type e = 0; e < count_; ++e)
+          det[e] = get(e).determinant();
+      }
+      else {
+        forEachLUBlock([&] (size_type first, size_type n, const LUBlock& lu, const auto& singular) {
+            Lanes d = lu.sign;
+            for (int i = 0; i < ROWS; ++i)
+              d *= lu.factors[i][i];
+            storeLanes(cond(singular, Lanes(0), d), det.data() + first, n);
+            return size_type(0);
+          });
+      }
+    }
+
+    /** \brief inverts all matrices in place
+     *
+     * Every matrix gets the result of FieldMatrix::invert().
+     *
+     * \exception FMatrixError if matrices are singular, after all matrices
+     *            have been processed, the singular ones have unspecified
+     *            entries
+     */
+    void invert ()
+    {
+      static_assert(ROWS == COLS, "invert requires square matrices");
+      size_type singular = 0;
+      if constexpr (ROWS <= 3) {
+        for (size_type e = 0; e < count_; ++e) {
+          matrix_type A = get(e);
+          const K det = A.determinant();
+          singular += (det == K(0));
+          if constexpr (ROWS == 1)
+            A[0][0] = K(1) / A[0][0];
+          else if constexpr (ROWS == 2)
+            Impl::invert2(A, A);
+          else
+            Impl::invert3(A, A);
+          set(e, A);
+        }
+      }
+      else {
+        singular = forEachLUBlock([&] (size_type first, size_type n, const LUBlock& lu, const auto& s) {
+            // solve for the columns of the permuted identity
+            for (int c = 0; c < COLS; ++c) {
+              FieldVector<Lanes,ROWS> x;
+              for (int i = 0; i < ROWS; ++i)
+                x[i] = cond(lu.pivot[i] == Lanes(c), Lanes(1), Lanes(0));
+              Impl::batchLUSubstitution(lu.factors, x);
+              for (int i = 0; i < ROWS; ++i)
+                storeLanes(x[i], component(i, c) + first, n);
+            }
+            return Impl::countLanes(s, n);
+          });
+      }
+      if (singular > 0)
+        DUNE_THROW(FMatrixError, singular << " of " << count_ << " matrices of the batch are singular");
+    }
+
+    /** \brief solves the systems A_e x_e = b_e of all items e
+     *
+     * Every item gets the result of FieldMatrix::solve().
+     *
+     * \exception FMatrixError if matrices are singular, after all systems
+     *            have been processed, the solutions of the singular ones
+     *            are unspecified
+     */
+    void solve (FieldVectorBatch<K,ROWS>& x, const FieldVectorBatch<K,ROWS>& b) const
+    {
+      static_assert(ROWS == COLS, "solve requires square matrices");
+      DUNE_ASSERT_BOUNDS(x.size() == count_ && b.size() == count_);
+      size_type singular = 0;
+      if constexpr (ROWS <= 3) {
+        for (size_type e = 0; e < count_; ++e) {
+          const matrix_type A = get(e);
+          const K det = A.determinant();
+          singular += (det == K(0));
+          FieldVector<K,ROWS> xe;
+          solveClosed(A, det, xe, b.get(e));
+          x.set(e, xe);
+        }
+      }
+      else {
+        singular = forEachLUBlock([&] (size_type first, size_type n, const LUBlock& lu, const auto& s) {
+            // gather the permuted right-hand sides
+            FieldVector<Lanes,ROWS> bl, y(Lanes(0));
+            for (int c = 0; c < ROWS; ++c)
+              loadLanes(bl[c], b.component(c) + first, n, K(0));
+            for (int i = 0; i < ROWS; ++i)
+              for (int c = 0; c < ROWS; ++c)
+                y[i] = cond(lu.pivot[i] == Lanes(c), bl[c], y[i]);
+            Impl::batchLUSubstitution(lu.factors, y);
+            for (int i = 0; i < ROWS; ++i)
+              storeLanes(y[i], x.component(i) + first, n);
+            return Impl::countLanes(s, n);
+          });
+      }
+      if (singular > 0)
+        DUNE_THROW(FMatrixError, singular << " of " << count_ << " matrices of the batch are singular");
+    }
+
+  private:
+    // Cramer's rule as in DenseMatrix::solve, for sizes 1 to 3
+    static void solveClosed (const matrix_type& A, const K& det, FieldVector<K,ROWS>& x, const FieldVector<K,ROWS>& b)
+    {
+      if constexpr (ROWS == 1)
+        x[0] = b[0] / A[0][0];
+      else {
+        const K detInv = K(1) / det;
+        if constexpr (ROWS == 2) {
+          x[0] = detInv * (A[1][1]*b[0] - A[0][1]*b[1]);
+          x[1] = detInv * (A[0][0]*b[1] - A[1][0]*b[0]);
+        }
+        else {
+          // the determinants with b in place of column j
+          FieldVector<K,3> y;
+          for (int j = 0; j < 3; ++j) {
+            matrix_type Aj = A;
+            for (int i = 0; i < 3; ++i)
+              Aj[i][j] = b[i];
+            y[j] = detInv * Impl::determinant3(Aj);
+          }
+          x = y;
+        }
+      }
+    }
+
+    // lanes [0,n) of t from a[0], ..., a[n-1], the others set to fill
+    static void loadLanes (Lanes& t, const K* a, size_type n, const K& fill)
+    {
+      if (n == W)
+        for (std::size_t l = 0; l < W; ++l)
+          t[l] = a[l];
+      else
+        for (std::size_t l = 0; l < W; ++l)
+          t[l] = (l < n) ? a[l] : fill;
+    }
+
+    // lanes [0,n) of t to a[0], ..., a[n-1]
+    static void storeLanes (const Lanes& t, K* a, size_type n)
+    {
+      for (size_type l = 0; l < n; ++l)
+        a[l] = t[l];
+    }
+
+    /* The LU decompositions of W matrices first, ..., first+n-1 at a time,
+     * one per lane, passed to f(first, n, lu, singular).  Lanes
+     * beyond n hold identity matrices.  Returns the sum of the results of f.
+     */
+    template<class F>
+    size_type forEachLUBlock (F&& f) const
+    {
+      size_type result = 0;
+      for (size_type first = 0; first < count_; first += W) {
+        const size_type n = std::min(W, count_ - first);
+        LUBlock lu;
+        for (int i = 0; i < ROWS; ++i)
+          for (int j = 0; j < COLS; ++j)
+            loadLanes(lu.factors[i][j], component(i, j) + first, n, K(i == j ? 1 : 0));
+        const auto singular = Impl::batchLUDecomposition(lu.factors, lu.pivot, lu.sign);
+        result += f(first, n, lu, singular);
+      }
+      return result;
+    }
+
+    std::vector<K> data_;
+    size_type count_;
+  };
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_FMATRIXBATCH_HH
@@ -52,6 +52,27 @@ namespace Dune {
     typedef typename FieldTraits<K>::real_type real_type;
   };
 
+  namespace Impl {
+
+    // loops over FieldVectors are unrolled
+    template< class K, int SIZE >
+    struct DenseVectorStaticSize< FieldVector<K,SIZE> >
+      : public std::integral_constant<std::size_t, SIZE> {};
+
+    // the element-wise operations of small nested FieldVectors of arithmetic
+    // scalars run over the flattened scalars
+    template< class K, int m, int n >
+    struct DenseVectorFlatStorage< FieldVector<FieldVector<K,m>,n> >
+      : public std::integral_constant<bool, std::is_arithmetic<K>::value
+                                              && std::size_t(n*m) <= maxUnrolledSize
+                                              && sizeof(FieldVector<FieldVector<K,m>,n>) == n*m*sizeof(K)>
+    {
+      typedef K scalar_type;
+      static constexpr std::size_t size = n*m;
+    };
+
+  } // end namespace Impl
+
   /**
    * @brief TMP to check the size of a DenseVectors statically, if possible.
    *
@@ -85,6 +106,22 @@ namespace Dune {
   };
 
 
+  namespace Impl {
+
+    //! whether arithmetic of K and Scalar yields K
+    template<class K, class Scalar>
+    struct PromotesToSelf
+      : std::is_same<typename PromotionTraits<K,Scalar>::PromotedType, K>
+    {};
+
+    //! whether Scalar is a number whose product with K is of type K
+    template<class K, class Scalar>
+    struct IsFieldPreservingScalar
+      : std::conjunction<IsNumber<Scalar>, PromotesToSelf<K,Scalar> >
+    {};
+
+  } // end namespace Impl
+
   /** \brief vector space out of a tensor product of fields.
    *
    * \tparam K    the field type (use float, double, complex, etc)
@@ -127,9 +164,14 @@ namespace Dune {
     // `... = default;` causes an internal compiler error on GCC 5.4 (Ubuntu 16.04)
     //! copy constructor
     FieldVector(const FieldVector& x) : _data(x._data) {}
+    //! move constructor
+    FieldVector(FieldVector&& x) : _data(std::move(x._data)) {}
 #else
     //! Copy constructor
     FieldVector (const FieldVector&) = default;
+
+    //! Move constructor, moves the entries
+    FieldVector (FieldVector&&) = default;
 #endif
 
     /** \brief Construct from a std::initializer_list */
@@ -144,6 +186,9 @@ namespace Dune {
     //! copy assignment operator
     FieldVector& operator= (const FieldVector&) = default;
 
+    //! move assignment operator, moves the entries
+    FieldVector& operator= (FieldVector&&) = default;
+
     template <typename T>
     FieldVector& operator= (const FieldVector<T, SIZE>& x)
     {
@@ -217,8 +262,7 @@ namespace Dune {
     {
       FieldVector<typename PromotionTraits<value_type,Scalar>::PromotedType,SIZE> result;
 
-      for (size_type i = 0; i < vector.size(); ++i)
-        result[i] = vector[i] * scalar;
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { result[i] = vector[i] * scalar; });
 
       return result;
     }
@@ -230,8 +274,7 @@ namespace Dune {
     {
       FieldVector<typename PromotionTraits<value_type,Scalar>::PromotedType,SIZE> result;
 
-      for (size_type i = 0; i < vector.size(); ++i)
-        result[i] = scalar * vector[i];
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { result[i] = scalar * vector[i]; });
 
       return result;
     }
@@ -243,12 +286,41 @@ namespace Dune {
     {
       FieldVector<typename PromotionTraits<value_type,Scalar>::PromotedType,SIZE> result;
 
-      for (size_type i = 0; i < vector.size(); ++i)
-        result[i] = vector[i] / scalar;
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { result[i] = vector[i] / scalar; });
 
       return result;
     }
 
+    //! vector space multiplication with scalar, in the storage of the temporary vector
+    template <class Scalar,
+              std::enable_if_t<Impl::IsFieldPreservingScalar<value_type,Scalar>::value, int> = 0>
+    friend FieldVector operator* ( FieldVector&& vector, Scalar scalar)
+    {
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { vector[i] *= scalar; });
+
+      return std::move(vector);
+    }
+
+    //! vector space multiplication with scalar, in the storage of the temporary vector
+    template <class Scalar,
+              std::enable_if_t<Impl::IsFieldPreservingScalar<value_type,Scalar>::value, int> = 0>
+    friend FieldVector operator* ( Scalar scalar, FieldVector&& vector)
+    {
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { vector[i] = scalar * std::move(vector[i]); });
+
+      return std::move(vector);
+    }
+
+    //! vector space division by scalar, in the storage of the temporary vector
+    template <class Scalar,
+              std::enable_if_t<Impl::IsFieldPreservingScalar<value_type,Scalar>::value, int> = 0>
+    friend FieldVector operator/ ( FieldVector&& vector, Scalar scalar)
+    {
+      Impl::denseFor<FieldVector>(vector.size(), [&](size_type i) { vector[i] /= scalar; });
+
+      return std::move(vector);
+    }
+
   };
 
   /** \brief Read a FieldVector from an input stream
@@ -338,9 +410,15 @@ namespace Dune {
     //! copy constructor
     FieldVector(const FieldVector&) = default;
 
+    //! move constructor, moves the entry
+    FieldVector(FieldVector&&) = default;
+
     //! copy assignment operator
     FieldVector& operator=(const FieldVector&) = default;
 
+    //! move assignment operator, moves the entry
+    FieldVector& operator=(FieldVector&&) = default;
+
     template <typename T>
     FieldVector& operator= (const FieldVector<T, 1>& other)
     {
@@ -0,0 +1,295 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_FVECTORREF_HH
+#define DUNE_COMMON_FVECTORREF_HH
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/densevector.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+   * \brief Views of a compile-time given number of consecutive entries of
+   * a vector, e.g. of the first three entries of a FieldVector<double,4>
+   *
+   * \code
+   * Dune::FieldVector<double,4> x = { 1, 2, 3, 4 };
+   * Dune::head<3>(x) *= 2.0;                    // x = { 2, 4, 6, 4 }
+   * double d = Dune::tail<2>(x).two_norm2();    // 52
+   * auto y = Dune::segment<1,2>(x) + Dune::head<2>(x);  // a FieldVector<double,2>
+   * \endcode
+   */
+
+  template< class K, int SIZE > class FieldVectorRef;
+
+  template< class K, int SIZE >
+  struct DenseMatVecTraits< FieldVectorRef<K,SIZE> >
+  {
+    typedef FieldVectorRef<K,SIZE> derived_type;
+    typedef K* container_type;
+    typedef K value_type;
+    typedef std::size_t size_type;
+  };
+
+  template< class K, int SIZE >
+  struct FieldTraits< FieldVectorRef<K,SIZE> >
+  {
+    typedef typename FieldTraits<K>::field_type field_type;
+    typedef typename FieldTraits<K>::real_type real_type;
+  };
+
+  namespace Impl {
+
+    // loops over FieldVectorRefs are unrolled like those over FieldVectors
+    template< class K, int SIZE >
+    struct DenseVectorStaticSize< FieldVectorRef<K,SIZE> >
+      : public std::integral_constant<std::size_t, SIZE> {};
+
+  } // end namespace Impl
+
+  template<typename T, int SIZE>
+  struct IsFieldVectorSizeCorrect<FieldVectorRef<T,SIZE>,SIZE>
+  {
+    enum {value = true};
+  };
+
+  template<typename T, int SIZE, int SIZE1>
+  struct IsFieldVectorSizeCorrect<FieldVectorRef<T,SIZE1>,SIZE>
+  {
+    enum {value = false};
+  };
+
+  /** \brief A view of SIZE consecutive entries of type K in memory owned by someone else
+   *
+   * The view implements the DenseVector interface.  Reading and writing its
+   * entries reads and writes the viewed memory, and assigning to the view
+   * copies entries into the viewed memory.  Copies of the view view the same
+   * memory.  Arithmetic producing a new vector, e.g. `x + y`, returns an
+   * owning FieldVector<K,SIZE>.
+   *
+   * \tparam K    the type of the entries, const K for read-only views
+   * \tparam SIZE the number of entries
+   */
+  template< class K, int SIZE >
+  class FieldVectorRef :
+    public DenseVector< FieldVectorRef<K,SIZE> >
+  {
+    K* _data;
+    typedef DenseVector< FieldVectorRef<K,SIZE> > Base;
+    typedef typename std::remove_const<K>::type field_value_type;
+
+  public:
+    //! export size
+    enum {
+      //! The size of this vector.
+      dimension = SIZE
+    };
+
+    typedef typename Base::size_type size_type;
+    typedef typename Base::value_type value_type;
+
+    //! the owning vector type of the results of the arithmetic
+    typedef FieldVector<field_value_type,SIZE> vector_type;
+
+    //! Constructor viewing the SIZE entries starting at data
+    explicit FieldVectorRef (K* data) noexcept
+      : _data(data)
+    {}
+
+    //! Constructor viewing all entries of a FieldVector
+    template<class V,
+             std::enable_if_t<std::is_same<std::remove_const_t<V>, vector_type>::value
+                              && std::is_convertible<decltype(std::declval<V&>().data()), K*>::value, int> = 0>
+    FieldVectorRef (V& v) noexcept
+      : _data(v.data())
+    {}
+
+    //! Constructor of a read-only view from a mutable one
+    template<class K1,
+             std::enable_if_t<!std::is_same<K1, K>::value && std::is_convertible<K1*, K*>::value, int> = 0>
+    FieldVectorRef (const FieldVectorRef<K1,SIZE>& other) noexcept
+      : _data(other.data())
+    {}
+
+    //! Copy constructor, the copy views the same entries
+    FieldVectorRef (const FieldVectorRef&) = default;
+
+    //! copy the entries of other into the viewed entries
+    FieldVectorRef& operator= (const FieldVectorRef& other)
+    {
+      return assign(other);
+    }
+
+    //! copy the entries of a view of the same, possibly read-only, entry type into the viewed entries
+    template<class K1,
+             std::enable_if_t<!std::is_same<K1, K>::value
+                              && std::is_same<std::remove_const_t<K1>, field_value_type>::value, int> = 0>
+    FieldVectorRef& operator= (const FieldVectorRef<K1,SIZE>& other)
+    {
+      return assign(other);
+    }
+
+    using Base::operator=;
+
+    //===== access to components
+
+    static constexpr size_type size () { return SIZE; }
+
+    K & operator[](size_type i)
+    {
+      DUNE_ASSERT_BOUNDS(i < SIZE);
+      return _data[i];
+    }
+    const K & operator[](size_type i) const
+    {
+      DUNE_ASSERT_BOUNDS(i < SIZE);
+      return _data[i];
+    }
+
+    //! return pointer to the viewed entries
+    K* data() const noexcept
+    {
+      return _data;
+    }
+
+    //===== arithmetic with owning results
+
+    //! Binary vector addition
+    template <class Other>
+    vector_type operator+ (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z += b;
+      return z;
+    }
+
+    //! Binary vector subtraction
+    template <class Other>
+    vector_type operator- (const DenseVector<Other>& b) const
+    {
+      vector_type z(*this);
+      z -= b;
+      return z;
+    }
+
+    //! Vector negation
+    vector_type operator- () const
+    {
+      return -vector_type(*this);
+    }
+
+    //! vector space multiplication with scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator* ( const FieldVectorRef& vector, Scalar scalar)
+    {
+      return vector_type(vector) * scalar;
+    }
+
+    //! vector space multiplication with scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator* ( Scalar scalar, const FieldVectorRef& vector)
+    {
+      return scalar * vector_type(vector);
+    }
+
+    //! vector space division by scalar
+    template <class Scalar,
+              std::enable_if_t<IsNumber<Scalar>::value, int> = 0>
+    friend auto operator/ ( const FieldVectorRef& vector, Scalar scalar)
+    {
+      return vector_type(vector) / scalar;
+    }
+
+    // the dot product is found in the base class
+    using Base::operator*;
+
+  private:
+    // copy the entries of other, through a copy if the viewed entries overlap
+    template<class K1>
+    FieldVectorRef& assign (const FieldVectorRef<K1,SIZE>& other)
+    {
+      const std::less<const field_value_type*> less;
+      if (SIZE > 0 && !less(_data + (SIZE-1), other.data()) && !less(other.data() + (SIZE-1), _data)) {
+        const vector_type values(other);
+        Impl::denseFor<FieldVectorRef>(SIZE, [&](size_type i) { _data[i] = values[i]; });
+      }
+      else
+        Impl::denseFor<FieldVectorRef>(SIZE, [&](size_type i) { _data[i] = other[i]; });
+      return *this;
+    }
+  };
+
+  /** \brief View of the LEN entries of v starting at OFFSET
+   *  \relates FieldVectorRef
+   */
+  template<int OFFSET, int LEN, class K, int SIZE>
+  FieldVectorRef<K,LEN> segment (FieldVector<K,SIZE>& v)
+  {
+    static_assert(OFFSET >= 0 && LEN >= 0 && OFFSET + LEN <= SIZE, "segment exceeds the vector");
+    return FieldVectorRef<K,LEN>(v.data() + OFFSET);
+  }
+
+  /** \brief Read-only view of the LEN entries of v starting at OFFSET
+   *  \relates FieldVectorRef
+   */
+  template<int OFFSET, int LEN, class K, int SIZE>
+  FieldVectorRef<const K,LEN> segment (const FieldVector<K,SIZE>& v)
+  {
+    static_assert(OFFSET >= 0 && LEN >= 0 && OFFSET + LEN <= SIZE, "segment exceeds the vector");
+    return FieldVectorRef<const K,LEN>(v.data() + OFFSET);
+  }
+
+  //! views of temporary vectors would dangle
+  template<int OFFSET, int LEN, class K, int SIZE>
+  void segment (const FieldVector<K,SIZE>&& v) = delete;
+
+  /** \brief View of the LEN entries of the view v starting at OFFSET
+   *  \relates FieldVectorRef
+   */
+  template<int OFFSET, int LEN, class K, int SIZE>
+  FieldVectorRef<K,LEN> segment (const FieldVectorRef<K,SIZE>& v)
+  {
+    static_assert(OFFSET >= 0 && LEN >= 0 && OFFSET + LEN <= SIZE, "segment exceeds the vector");
+    return FieldVectorRef<K,LEN>(v.data() + OFFSET);
+  }
+
+  /** \brief View of the first LEN entries of v
+   *  \relates FieldVectorRef
+   */
+  template<int LEN, class V>
+  auto head (V&& v)
+    -> decltype(segment<0,LEN>(std::forward<V>(v)))
+  {
+    return segment<0,LEN>(std::forward<V>(v));
+  }
+
+  /** \brief View of the last LEN entries of v
+   *  \relates FieldVectorRef
+   */
+  template<int LEN, class V>
+  auto tail (V&& v)
+    -> decltype(segment<std::decay_t<V>::dimension - LEN, LEN>(std::forward<V>(v)))
+  {
+    return segment<std::decay_t<V>::dimension - LEN, LEN>(std::forward<V>(v));
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_FVECTORREF_HH
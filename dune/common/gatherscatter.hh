@@ -0,0 +1,272 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_GATHERSCATTER_HH
+#define DUNE_COMMON_GATHERSCATTER_HH
+
+/** \file
+ * \brief Gather blocks of a global array by an index list into a local
+ * buffer, and scatter or scatter-add them back
+ *
+ * The global arrays and the local buffers are contiguous ranges of blocks,
+ * e.g. std::vector<FieldVector<double,3> >, BlockVector or
+ * FieldVector<FieldVector<double,3>,m>, and the index lists are contiguous
+ * ranges of integers:
+ * \code
+ * std::vector<Dune::FieldVector<double,3> > u = ..., r = ...;
+ * std::array<int,4> dofs = ...;                    // of one element
+ * Dune::FieldVector<Dune::FieldVector<double,3>,4> uLocal, rLocal;
+ * Dune::gather(u, dofs, uLocal);                   // uLocal[k] = u[dofs[k]]
+ * ...
+ * Dune::scatterAdd(r, dofs, rLocal);               // r[dofs[k]] += rLocal[k]
+ * \endcode
+ *
+ * The local buffer can also be a FieldVector<LoopSIMD<K,W>,b>, which
+ * stores the blocks of W indices transposed, one lane per index, so that
+ * W elements are processed in one instruction stream.  These gathers use
+ * the hardware gather instructions of AVX2 and AVX-512 for float and
+ * double entries and 32 bit indices, which are about twice as fast as
+ * the transposition by scalar loads if the blocks are in cache.
+ *
+ * Repeated indices are allowed.  A scatter leaves the block of the last
+ * of them, and a scatter-add adds all of them, in the order of the index
+ * list.  Scatters of long index lists prefetch the blocks a few indices
+ * ahead for writing, which hides part of the latency of read-modify-write
+ * accesses to blocks outside the cache.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <dune/common/boundschecking.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/loopsimd.hh>
+#include <dune/common/unused.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  namespace Impl {
+
+    //! number of indices the scatters prefetch ahead
+    constexpr std::size_t scatterPrefetchDistance = 16;
+
+    template<class G, class I, class L>
+    void gatherBlocks (const G* global, std::size_t size, const I* indices, std::size_t n, L* local)
+    {
+      DUNE_UNUSED_PARAMETER(size);
+      for (std::size_t k = 0; k < n; ++k) {
+        DUNE_ASSERT_BOUNDS(std::size_t(indices[k]) < size);
+        local[k] = global[indices[k]];
+      }
+    }
+
+    // op(global[indices[k]], local[k]) for k = 0,...,n-1, prefetching the blocks ahead
+    template<class G, class I, class L, class F>
+    void scatterBlocks (G* global, std::size_t size, const I* indices, std::size_t n, const L* local, F op)
+    {
+      DUNE_UNUSED_PARAMETER(size);
+      constexpr std::size_t D = scatterPrefetchDistance;
+      std::size_t k = 0;
+      for (; k + D < n; ++k) {
+        DUNE_ASSERT_BOUNDS(std::size_t(indices[k]) < size);
+        __builtin_prefetch(global + indices[k+D], 1);
+        op(global[indices[k]], local[k]);
+      }
+      for (; k < n; ++k) {
+        DUNE_ASSERT_BOUNDS(std::size_t(indices[k]) < size);
+        op(global[indices[k]], local[k]);
+      }
+    }
+
+    // whether the transposing gathers of blocks of b entries of type K may use the
+    // hardware gather instructions, which take 32 bit offsets counted in entries
+    template<class K, class I>
+    constexpr bool hasHardwareGather ()
+    {
+#if defined(__AVX2__) || defined(__AVX512F__)
+      return (std::is_same<K, double>::value || std::is_same<K, float>::value)
+        && std::is_integral<I>::value && sizeof(I) == 4;
+#else
+      return false;
+#endif
+    }
+
+    /** \brief local[j][k] = global[indices[k]][j] for k = 0,...,n-1 and n <= W
+     *
+     * Returns the number of indices gathered by hardware gathers, the
+     * remaining ones are left to the caller.
+     */
+    template<class K, std::size_t W, int b, class I>
+    std::size_t hardwareGather (const K* global, const I* indices, std::size_t n,
+                                FieldVector<LoopSIMD<K,W>,b>& local)
+    {
+      std::size_t k = 0;
+#if defined(__AVX512F__)
+      constexpr std::size_t L = 64 / sizeof(K);
+      for (; k + L <= n; k += L) {
+        if constexpr (std::is_same<K, double>::value) {
+          const __m256i offsets = _mm256_mullo_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k)), _mm256_set1_epi32(b));
+          for (int j = 0; j < b; ++j)
+            _mm512_storeu_pd(&local[j][k], _mm512_i32gather_pd(offsets, global + j, sizeof(K)));
+        }
+        else {
+          const __m512i offsets = _mm512_mullo_epi32(
+            _mm512_loadu_si512(indices + k), _mm512_set1_epi32(b));
+          for (int j = 0; j < b; ++j)
+            _mm512_storeu_ps(&local[j][k], _mm512_i32gather_ps(offsets, global + j, sizeof(K)));
+        }
+      }
+#elif defined(__AVX2__)
+      constexpr std::size_t L = 32 / sizeof(K);
+      for (; k + L <= n; k += L) {
+        if constexpr (std::is_same<K, double>::value) {
+          const __m128i offsets = _mm_mullo_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + k)), _mm_set1_epi32(b));
+          for (int j = 0; j < b; ++j)
+            _mm256_storeu_pd(&local[j][k], _mm256_i32gather_pd(global + j, offsets, sizeof(K)));
+        }
+        else {
+          const __m256i offsets = _mm256_mullo_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k)), _mm256_set1_epi32(b));
+          for (int j = 0; j < b; ++j)
+            _mm256_storeu_ps(&local[j][k], _mm256_i32gather_ps(global + j, offsets, sizeof(K)));
+        }
+      }
+#endif
+      return k;
+    }
+
+  } // end namespace Impl
+
+  /** \brief local[k] = global[indices[k]] for all k
+   *
+   * \param global  contiguous range of blocks
+   * \param indices contiguous range of indices into global
+   * \param local   contiguous range of blocks, at least as long as indices
+   */
+  template<class Global, class Indices, class Local>
+  void gather (const Global& global, const Indices& indices, Local& local)
+  {
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= std::size(local));
+    Impl::gatherBlocks(std::data(global), std::size(global),
+                       std::data(indices), std::size(indices), std::data(local));
+  }
+
+  /** \brief global[indices[k]] = local[k] for all k
+   *
+   * \param global  contiguous range of blocks
+   * \param indices contiguous range of indices into global
+   * \param local   contiguous range of blocks, at least as long as indices
+   */
+  template<class Global, class Indices, class Local>
+  void scatter (Global& global, const Indices& indices, const Local& local)
+  {
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= std::size(local));
+    Impl::scatterBlocks(std::data(global), std::size(global),
+                        std::data(indices), std::size(indices), std::data(local),
+                        [] (auto& g, const auto& l) { g = l; });
+  }
+
+  /** \brief global[indices[k]] += local[k] for all k
+   *
+   * \param global  contiguous range of blocks
+   * \param indices contiguous range of indices into global
+   * \param local   contiguous range of blocks, at least as long as indices
+   */
+  template<class Global, class Indices, class Local>
+  void scatterAdd (Global& global, const Indices& indices, const Local& local)
+  {
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= std::size(local));
+    Impl::scatterBlocks(std::data(global), std::size(global),
+                        std::data(indices), std::size(indices), std::data(local),
+                        [] (auto& g, const auto& l) { g += l; });
+  }
+
+  /** \brief local[j][k] = global[indices[k]][j] for all k, transposing the blocks into the lanes
+   *
+   * \param global  contiguous range of blocks FieldVector<K,b>
+   * \param indices contiguous range of at most W indices into global
+   * \param local   the blocks, lane k holds the block of indices[k]; the
+   *                lanes beyond the number of indices are left unchanged
+   */
+  template<class Global, class Indices, class K, std::size_t W, int b>
+  void gather (const Global& global, const Indices& indices, FieldVector<LoopSIMD<K,W>,b>& local)
+  {
+    static_assert(sizeof(FieldVector<K,b>) == b*sizeof(K), "blocks with padding cannot be transposed");
+    const auto* blocks = std::data(global);
+    const auto* index = std::data(indices);
+    const std::size_t size = std::size(global);
+    const std::size_t n = std::size(indices);
+    DUNE_ASSERT_BOUNDS(n <= W);
+
+    std::size_t k = 0;
+    typedef std::remove_const_t<std::remove_pointer_t<decltype(index)> > Index;
+    if constexpr (Impl::hasHardwareGather<K, Index>()) {
+      if (size <= std::size_t(std::numeric_limits<int>::max()) / b) {
+#ifdef DUNE_CHECK_BOUNDS
+        for (std::size_t i = 0; i < n; ++i)
+          DUNE_ASSERT_BOUNDS(std::size_t(index[i]) < size);
+#endif
+        k = Impl::hardwareGather(reinterpret_cast<const K*>(blocks), index, n, local);
+      }
+    }
+    for (; k < n; ++k) {
+      DUNE_ASSERT_BOUNDS(std::size_t(index[k]) < size);
+      for (int j = 0; j < b; ++j)
+        local[j][k] = blocks[index[k]][j];
+    }
+  }
+
+  /** \brief global[indices[k]][j] = local[j][k] for all k, transposing the lanes into the blocks
+   *
+   * \param global  contiguous range of blocks FieldVector<K,b>
+   * \param indices contiguous range of at most W indices into global
+   * \param local   the blocks, lane k holds the block of indices[k]
+   */
+  template<class Global, class Indices, class K, std::size_t W, int b>
+  void scatter (Global& global, const Indices& indices, const FieldVector<LoopSIMD<K,W>,b>& local)
+  {
+    auto* blocks = std::data(global);
+    const auto* index = std::data(indices);
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= W);
+    for (std::size_t k = 0; k < std::size(indices); ++k) {
+      DUNE_ASSERT_BOUNDS(std::size_t(index[k]) < std::size(global));
+      for (int j = 0; j < b; ++j)
+        blocks[index[k]][j] = local[j][k];
+    }
+  }
+
+  /** \brief global[indices[k]][j] += local[j][k] for all k, transposing the lanes into the blocks
+   *
+   * \param global  contiguous range of blocks FieldVector<K,b>
+   * \param indices contiguous range of at most W indices into global
+   * \param local   the blocks, lane k holds the block of indices[k]
+   */
+  template<class Global, class Indices, class K, std::size_t W, int b>
+  void scatterAdd (Global& global, const Indices& indices, const FieldVector<LoopSIMD<K,W>,b>& local)
+  {
+    auto* blocks = std::data(global);
+    const auto* index = std::data(indices);
+    DUNE_ASSERT_BOUNDS(std::size(indices) <= W);
+    for (std::size_t k = 0; k < std::size(indices); ++k) {
+      DUNE_ASSERT_BOUNDS(std::size_t(index[k]) < std::size(global));
+      for (int j = 0; j < b; ++j)
+        blocks[index[k]][j] += local[j][k];
+    }
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_GATHERSCATTER_HH
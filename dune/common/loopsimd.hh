@@ -0,0 +1,376 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_LOOPSIMD_HH
+#define DUNE_COMMON_LOOPSIMD_HH
+
+/** \file
+ * \brief A portable SIMD type whose lanes are processed by loops
+ *
+ * LoopSIMD<T,W> holds W values of type T and applies every operation to
+ * all lanes.  It can be used as field type of FieldVector and DenseVector,
+ * so that FieldVector<LoopSIMD<double,W>,N> describes W independent
+ * problems which are evaluated in one instruction stream:
+ * \code
+ * Dune::FieldVector<Dune::LoopSIMD<double,4>,3> x = ...;  // 4 vectors of size 3
+ * auto n = x.two_norm();    // the 4 norms, one per lane
+ * \endcode
+ * The loops over the lanes have a length fixed at compile time and no
+ * dependencies between the lanes, so compilers emit SIMD instructions for
+ * them.
+ *
+ * If the standard library provides std::experimental::simd (Parallelism
+ * TS v2, e.g. libstdc++ of GCC 11 and later), the arithmetic, the
+ * comparisons and abs, sqrt, isnan, isinf and isfinite of floating point
+ * lanes are computed by std::experimental::fixed_size_simd<T,W> instead of
+ * loops.  Defining DUNE_LOOPSIMD_STD_SIMD to 0 before including this
+ * header selects the loops.  Both backends compute every lane by the same
+ * IEEE operation, so their results agree, unless the compiler contracts
+ * multiplications and additions of the loops into fused multiply-adds
+ * (e.g. GCC with -ffp-contract=fast on FMA targets).
+ *
+ * Comparisons return masks of type LoopSIMD<bool,W>, which are reduced by
+ * allTrue() and anyTrue() and used for lane-wise selection by cond().  The
+ * norms of DenseVector are computed lane-wise, including the propagation
+ * of NaNs by infinity_norm.  Comparing two vectors by == yields whether
+ * they agree in all lanes.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+#include <dune/common/ftraits.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+#ifndef DUNE_LOOPSIMD_STD_SIMD
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#endif
+#ifdef __cpp_lib_experimental_parallel_simd
+#define DUNE_LOOPSIMD_STD_SIMD 1
+#else
+#define DUNE_LOOPSIMD_STD_SIMD 0
+#endif
+#elif DUNE_LOOPSIMD_STD_SIMD
+#include <experimental/simd>
+#endif
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  namespace Impl {
+
+    // alignment of the lanes, as for a SIMD register of the same size if possible
+    template<class T, std::size_t W>
+    constexpr std::size_t loopSIMDAlignment ()
+    {
+      constexpr std::size_t bytes = W*sizeof(T);
+      return ((bytes & (bytes - 1)) == 0 && bytes > alignof(T))
+        ? (bytes < 64 ? bytes : 64) : alignof(T);
+    }
+
+    //! whether the lanes of type T are processed by std::experimental::simd
+    template<class T>
+    constexpr bool loopSIMDUsesStdSIMD ()
+    {
+      return DUNE_LOOPSIMD_STD_SIMD && !std::is_same<T, bool>::value;
+    }
+
+  } // end namespace Impl
+
+  /** \brief W values of type T with lane-wise arithmetic
+   *
+   * \tparam T an arithmetic type
+   * \tparam W the number of lanes
+   */
+  template<class T, std::size_t W>
+  class alignas(Impl::loopSIMDAlignment<T,W>()) LoopSIMD
+  {
+    static_assert(std::is_arithmetic<T>::value, "LoopSIMD requires an arithmetic lane type");
+    static_assert(W > 0, "LoopSIMD requires at least one lane");
+
+  public:
+    //! the type of a single lane
+    typedef T value_type;
+
+    //! the type of the lane-wise comparison results
+    typedef LoopSIMD<bool, W> mask_type;
+
+    //! Constructor setting all lanes to zero
+    constexpr LoopSIMD ()
+      : lanes_{}
+    {}
+
+    //! Constructor broadcasting a scalar to all lanes
+    template<class U,
+             std::enable_if_t<std::is_arithmetic<U>::value, int> = 0>
+    constexpr LoopSIMD (const U& u)
+      : lanes_{}
+    {
+      for (std::size_t l = 0; l < W; ++l)
+        lanes_[l] = T(u);
+    }
+
+    //! Conversion from another lane type
+    template<class U,
+             std::enable_if_t<!std::is_same<U, T>::value, int> = 0>
+    explicit LoopSIMD (const LoopSIMD<U, W>& other)
+    {
+      for (std::size_t l = 0; l < W; ++l)
+        lanes_[l] = T(other[l]);
+    }
+
+    //! the number of lanes
+    static constexpr std::size_t size ()
+    {
+      return W;
+    }
+
+    //! access to lane l
+    T& operator[] (std::size_t l)
+    {
+      return lanes_[l];
+    }
+
+    //! access to lane l
+    const T& operator[] (std::size_t l) const
+    {
+      return lanes_[l];
+    }
+
+    //===== arithmetic
+
+#define DUNE_LOOPSIMD_COMPOUND_OPERATOR(OP)                                 \
+    LoopSIMD& operator OP##= (const LoopSIMD& other)                        \
+    {                                                                       \
+      return *this = lanewise<LoopSIMD>([] (auto a, auto b) { return a OP b; }, \
+                                        *this, other);                      \
+    }
+
+    DUNE_LOOPSIMD_COMPOUND_OPERATOR(+)
+    DUNE_LOOPSIMD_COMPOUND_OPERATOR(-)
+    DUNE_LOOPSIMD_COMPOUND_OPERATOR(*)
+    DUNE_LOOPSIMD_COMPOUND_OPERATOR(/)
+#undef DUNE_LOOPSIMD_COMPOUND_OPERATOR
+
+#define DUNE_LOOPSIMD_BINARY_OPERATOR(OP)                               \
+    friend LoopSIMD operator OP (const LoopSIMD& a, const LoopSIMD& b)  \
+    {                                                                   \
+      return lanewise<LoopSIMD>([] (auto x, auto y) { return x OP y; }, a, b); \
+    }
+
+    DUNE_LOOPSIMD_BINARY_OPERATOR(+)
+    DUNE_LOOPSIMD_BINARY_OPERATOR(-)
+    DUNE_LOOPSIMD_BINARY_OPERATOR(*)
+    DUNE_LOOPSIMD_BINARY_OPERATOR(/)
+#undef DUNE_LOOPSIMD_BINARY_OPERATOR
+
+    friend LoopSIMD operator- (const LoopSIMD& a)
+    {
+      return lanewise<LoopSIMD>([] (auto x) { return -x; }, a);
+    }
+
+    friend LoopSIMD operator+ (const LoopSIMD& a)
+    {
+      return a;
+    }
+
+    //===== lane-wise comparisons
+
+#define DUNE_LOOPSIMD_COMPARISON(OP)                                    \
+    friend mask_type operator OP (const LoopSIMD& a, const LoopSIMD& b) \
+    {                                                                   \
+      return lanewise<mask_type>([] (auto x, auto y) { return x OP y; }, a, b); \
+    }
+
+    DUNE_LOOPSIMD_COMPARISON(==)
+    DUNE_LOOPSIMD_COMPARISON(!=)
+    DUNE_LOOPSIMD_COMPARISON(<)
+    DUNE_LOOPSIMD_COMPARISON(<=)
+    DUNE_LOOPSIMD_COMPARISON(>)
+    DUNE_LOOPSIMD_COMPARISON(>=)
+#undef DUNE_LOOPSIMD_COMPARISON
+
+    //===== lane-wise math functions, found by argument-dependent lookup
+
+#define DUNE_LOOPSIMD_UNARY_FUNCTION(RESULT, NAME)                      \
+    friend RESULT NAME (const LoopSIMD& a)                              \
+    {                                                                   \
+      return lanewise<RESULT, std::is_floating_point<T>::value>(        \
+        [] (auto x) { using std::NAME; return NAME(x); }, a);           \
+    }
+
+    DUNE_LOOPSIMD_UNARY_FUNCTION(LoopSIMD, abs)
+    DUNE_LOOPSIMD_UNARY_FUNCTION(LoopSIMD, sqrt)
+    DUNE_LOOPSIMD_UNARY_FUNCTION(mask_type, isnan)
+    DUNE_LOOPSIMD_UNARY_FUNCTION(mask_type, isinf)
+    DUNE_LOOPSIMD_UNARY_FUNCTION(mask_type, isfinite)
+#undef DUNE_LOOPSIMD_UNARY_FUNCTION
+
+    //! lane-wise maximum
+    friend LoopSIMD max (const LoopSIMD& a, const LoopSIMD& b)
+    {
+      LoopSIMD result;
+      for (std::size_t l = 0; l < W; ++l)
+        result.lanes_[l] = (a.lanes_[l] < b.lanes_[l]) ? b.lanes_[l] : a.lanes_[l];
+      return result;
+    }
+
+    //! lane-wise minimum
+    friend LoopSIMD min (const LoopSIMD& a, const LoopSIMD& b)
+    {
+      LoopSIMD result;
+      for (std::size_t l = 0; l < W; ++l)
+        result.lanes_[l] = (b.lanes_[l] < a.lanes_[l]) ? b.lanes_[l] : a.lanes_[l];
+      return result;
+    }
+
+    //! the lanes separated by commas in angle brackets
+    friend std::ostream& operator<< (std::ostream& s, const LoopSIMD& a)
+    {
+      s << "<";
+      for (std::size_t l = 0; l < W; ++l)
+        s << (l > 0 ? ", " : "") << a.lanes_[l];
+      return s << ">";
+    }
+
+  private:
+    /** \brief result[l] = f(a[l], ...) for all lanes
+     *
+     * The functor is applied to std::experimental::fixed_size_simd<T,W>
+     * holding all lanes if simd is true and to the single lanes otherwise.
+     */
+    template<class R, bool simd = Impl::loopSIMDUsesStdSIMD<T>(), class F, class... A>
+    static R lanewise (F f, const A&... a)
+    {
+      R result;
+#if DUNE_LOOPSIMD_STD_SIMD
+      if constexpr (simd) {
+        namespace stdx = std::experimental;
+        f(stdx::fixed_size_simd<T,W>(a.lanes_, stdx::element_aligned)...)
+          .copy_to(&result[0], stdx::element_aligned);
+        return result;
+      }
+#endif
+      for (std::size_t l = 0; l < W; ++l)
+        result[l] = f(a.lanes_[l]...);
+      return result;
+    }
+
+    T lanes_[W];
+  };
+
+  //===== masks
+
+  //! lane-wise negation of a mask
+  template<std::size_t W>
+  LoopSIMD<bool, W> operator! (const LoopSIMD<bool, W>& m)
+  {
+    LoopSIMD<bool, W> result;
+    for (std::size_t l = 0; l < W; ++l)
+      result[l] = !m[l];
+    return result;
+  }
+
+  //! lane-wise conjunction of masks, both operands are evaluated
+  template<std::size_t W>
+  LoopSIMD<bool, W> operator&& (const LoopSIMD<bool, W>& a, const LoopSIMD<bool, W>& b)
+  {
+    LoopSIMD<bool, W> result;
+    for (std::size_t l = 0; l < W; ++l)
+      result[l] = a[l] && b[l];
+    return result;
+  }
+
+  //! lane-wise disjunction of masks, both operands are evaluated
+  template<std::size_t W>
+  LoopSIMD<bool, W> operator|| (const LoopSIMD<bool, W>& a, const LoopSIMD<bool, W>& b)
+  {
+    LoopSIMD<bool, W> result;
+    for (std::size_t l = 0; l < W; ++l)
+      result[l] = a[l] || b[l];
+    return result;
+  }
+
+  //! whether all lanes of a mask are true
+  template<std::size_t W>
+  bool allTrue (const LoopSIMD<bool, W>& m)
+  {
+    bool result = true;
+    for (std::size_t l = 0; l < W; ++l)
+      result = result && m[l];
+    return result;
+  }
+
+  //! whether any lane of a mask is true
+  template<std::size_t W>
+  bool anyTrue (const LoopSIMD<bool, W>& m)
+  {
+    bool result = false;
+    for (std::size_t l = 0; l < W; ++l)
+      result = result || m[l];
+    return result;
+  }
+
+  //! lane-wise selection: the lanes of a where the mask is true, those of b otherwise
+  template<class T, std::size_t W>
+  LoopSIMD<T, W> cond (const LoopSIMD<bool, W>& m, const LoopSIMD<T, W>& a, const LoopSIMD<T, W>& b)
+  {
+    LoopSIMD<T, W> result;
+    for (std::size_t l = 0; l < W; ++l)
+      result[l] = m[l] ? a[l] : b[l];
+    return result;
+  }
+
+  //===== traits
+
+  template<class T, std::size_t W>
+  struct FieldTraits< LoopSIMD<T, W> >
+  {
+    typedef LoopSIMD<typename FieldTraits<T>::field_type, W> field_type;
+    typedef LoopSIMD<typename FieldTraits<T>::real_type, W> real_type;
+  };
+
+  template<class T, std::size_t W>
+  struct IsNumber< LoopSIMD<T, W> >
+    : public std::integral_constant<bool, IsNumber<T>::value> {};
+
+  template<class T, std::size_t W>
+  struct HasNaN< LoopSIMD<T, W> >
+    : public std::integral_constant<bool, HasNaN<T>::value> {};
+
+  template<class T, std::size_t W>
+  struct PromotionTraits< LoopSIMD<T, W>, LoopSIMD<T, W> >
+  {
+    typedef LoopSIMD<T, W> PromotedType;
+  };
+
+  template<class T1, class T2, std::size_t W>
+  struct PromotionTraits< LoopSIMD<T1, W>, LoopSIMD<T2, W> >
+  {
+    typedef LoopSIMD<typename PromotionTraits<T1, T2>::PromotedType, W> PromotedType;
+  };
+
+  template<class T1, class T2, std::size_t W>
+  struct PromotionTraits< LoopSIMD<T1, W>, T2 >
+  {
+    typedef LoopSIMD<typename PromotionTraits<T1, T2>::PromotedType, W> PromotedType;
+  };
+
+  template<class T1, class T2, std::size_t W>
+  struct PromotionTraits< T1, LoopSIMD<T2, W> >
+  {
+    typedef LoopSIMD<typename PromotionTraits<T1, T2>::PromotedType, W> PromotedType;
+  };
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_LOOPSIMD_HH
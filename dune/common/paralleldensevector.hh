@@ -0,0 +1,520 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_PARALLELDENSEVECTOR_HH
+#define DUNE_COMMON_PARALLELDENSEVECTOR_HH
+
+/** \file
+ * \brief Multi-threaded implementations of the DenseVector operations
+ *
+ * The functions in this file take an execution policy as first argument.
+ * With Execution::seq they forward to the corresponding member function of
+ * DenseVector; with Execution::par vectors of at least policy.threshold
+ * entries are split into chunks which are processed by different threads.
+ * Chunk boundaries are multiples of a cache line, so threads never write
+ * to the same cache line of a vector with cache-line aligned storage, and
+ * reductions accumulate a partial result per thread.
+ *
+ * The member functions of DenseVector themselves never use threads.
+ *
+ * The fused kernels axpby, xpay, multiAxpy and linearCombination, which
+ * have no member counterpart, combine several vectors entry by entry in
+ * one pass for both policies: each input is read once and the result is
+ * written once, where a sequence of axpy operations would stream the
+ * result once per term.  If all vectors store their arithmetic entries
+ * contiguously, the entries of a cache line are loaded before any of
+ * them is stored, so that the compiler vectorizes the loops without
+ * checking the vectors for aliasing.  The result may be one of the
+ * inputs.
+ *
+ * The summation order of the parallel reductions depends on the number of
+ * threads, so the rounding errors may change with the number of threads
+ * and even between runs.  If the policy requests reproducible reductions
+ * (see Execution::ParallelPolicy::withReproducibleReductions()), dot,
+ * two_norm2, two_norm and one_norm use a summation order depending on the
+ * vector size only:
+ *  - the vector is split into blocks of Impl::reproducibleBlockSize entries,
+ *  - within a block, eight interleaved partial sums are accumulated in
+ *    index order and combined by a fixed binary tree,
+ *  - the block sums are combined by a fixed binary tree.
+ * The results are bitwise identical for all numbers of threads, grain sizes
+ * and thresholds, and they do not depend on the SIMD width the compiler
+ * chooses, as long as value-changing optimizations like -ffast-math or
+ * -fassociative-math are disabled.  The eight independent partial sums
+ * compensate most of the overhead of the fixed order; compared with the
+ * non-reproducible path, the additional cost is the storage and the
+ * sequential tree reduction of one value per block.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dune/common/densevector.hh>
+#include <dune/common/densevectorref.hh>
+#include <dune/common/dotproduct.hh>
+#include <dune/common/execution.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/parallelfor.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  namespace Impl {
+
+    //! number of vector entries sharing a cache line
+    template<class K>
+    constexpr std::size_t cacheLineEntries ()
+    {
+      return (sizeof(K) < 64) ? 64 / sizeof(K) : 1;
+    }
+
+    // options for a loop over cache lines instead of single entries
+    template<class K>
+    ParallelOptions cacheLineOptions (const Execution::ParallelPolicy& policy)
+    {
+      constexpr std::size_t L = cacheLineEntries<K>();
+      ParallelOptions options = policy;
+      options.grainSize = (policy.grainSize + L - 1) / L;
+      return options;
+    }
+
+    //! call f(first, last) in parallel for chunks of [0,n) aligned to cache lines of K
+    template<class K, class F>
+    void forCacheLineChunks (std::size_t n, const Execution::ParallelPolicy& policy, F&& f)
+    {
+      constexpr std::size_t L = cacheLineEntries<K>();
+      parallelForChunks(std::size_t(0), (n + L - 1) / L, [&f, n] (std::size_t first, std::size_t last) {
+          f(first*L, std::min(last*L, n));
+        }, cacheLineOptions<K>(policy));
+    }
+
+    //! reduce f(first, last, init) in parallel over chunks of [0,n) aligned to cache lines of K
+    template<class K, class T, class F, class R>
+    T reduceCacheLineChunks (std::size_t n, const Execution::ParallelPolicy& policy,
+                             const T& identity, F&& f, R&& reduce)
+    {
+      constexpr std::size_t L = cacheLineEntries<K>();
+      return parallelReduceChunks(std::size_t(0), (n + L - 1) / L, identity,
+        [&f, n] (std::size_t first, std::size_t last, T init) {
+          return f(first*L, std::min(last*L, n), std::move(init));
+        }, reduce, cacheLineOptions<K>(policy));
+    }
+
+    //! number of entries reduced to one partial result by reproducible reductions
+    constexpr std::size_t reproducibleBlockSize = 4096;
+
+    //! number of interleaved partial sums within a block of a reproducible reduction
+    constexpr std::size_t reproducibleLanes = 8;
+
+    //! sum up the values in [first, first+n) by a fixed binary tree, overwriting them
+    template<class T>
+    T treeSum (T* first, std::size_t n)
+    {
+      if (n == 0)
+        return T(0);
+      while (n > 1) {
+        const std::size_t half = n / 2;
+        for (std::size_t k = 0; k < half; ++k)
+          first[k] = first[2*k] + first[2*k+1];
+        if (n % 2 == 1)
+          first[half] = std::move(first[n-1]);
+        n = half + n % 2;
+      }
+      return first[0];
+    }
+
+    //! sum of f(i) over [first,last) in a fixed order, using interleaved partial sums
+    template<class T, class F>
+    T reproducibleBlockSum (std::size_t first, std::size_t last, F& f)
+    {
+      constexpr std::size_t L = reproducibleLanes;
+      T lanes[L];
+      for (std::size_t j = 0; j < L; ++j)
+        lanes[j] = T(0);
+
+      std::size_t i = first;
+      for (; i + L <= last; i += L)
+        for (std::size_t j = 0; j < L; ++j)
+          lanes[j] += f(i+j);
+      for (std::size_t j = 0; i + j < last; ++j)
+        lanes[j] += f(i+j);
+
+      return treeSum(lanes, L);
+    }
+
+    //! sum of f(i) over [0,n) in an order independent of the number of threads
+    template<class T, class F>
+    T reproducibleSum (std::size_t n, const Execution::ParallelPolicy& policy, F&& f)
+    {
+      constexpr std::size_t B = reproducibleBlockSize;
+      const std::size_t blocks = (n + B - 1) / B;
+      std::vector<T> partials(blocks);
+
+      auto body = [&] (std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; ++b)
+          partials[b] = reproducibleBlockSum<T>(b*B, std::min(n, (b+1)*B), f);
+      };
+      if (n < policy.threshold)
+        body(0, blocks);
+      else {
+        ParallelOptions options = policy;
+        options.grainSize = (policy.grainSize + B - 1) / B;
+        parallelForChunks(std::size_t(0), blocks, body, options);
+      }
+
+      return treeSum(partials.data(), blocks);
+    }
+
+    //! whether the coefficient k is zero, false for coefficients without a boolean comparison, e.g. SIMD types
+    template<class K>
+    bool isZeroCoefficient (const K& k)
+    {
+      if constexpr (std::is_convertible<decltype(k == K(0)), bool>::value)
+        return k == K(0);
+      else
+        return false;
+    }
+
+    //! z += a x for scalar and vector entries
+    template<class Z, class K, class X>
+    void axpyEntry (Z& z, const K& a, const X& x)
+    {
+      if constexpr (IsNumber<Z>::value)
+        z += a*x;
+      else
+        z.axpy(a, x);
+    }
+
+    /** \brief z[i] = f(z[i], x[i]...) for i in [first,last) of contiguous arithmetic entries
+     *
+     * The results of a cache line are computed before the first one is
+     * stored, so that the compiler may vectorize the loops without
+     * checking for aliasing.  The functor is taken by value, so that its
+     * captures stay in registers.
+     */
+    template<class K, class F, class... X>
+    void fusedScalars (std::size_t first, std::size_t last, F f, K* z, const X*... x)
+    {
+      constexpr std::size_t L = cacheLineEntries<K>();
+      std::size_t i = first;
+      for (; i + L <= last; i += L) {
+        K zs[L];
+        for (std::size_t l = 0; l < L; ++l)
+          zs[l] = f(z[i+l], x[i+l]...);
+        for (std::size_t l = 0; l < L; ++l)
+          z[i+l] = zs[l];
+      }
+      for (; i < last; ++i)
+        z[i] = f(z[i], x[i]...);
+    }
+
+    //! z[i] = f(z[i], x[i]...) for i in [first,last)
+    template<class F, class V, class... W>
+    void fusedTransform (std::size_t first, std::size_t last, F f,
+                         DenseVector<V>& z, const DenseVector<W>&... x)
+    {
+      typedef typename DenseVector<V>::value_type K;
+      if constexpr (std::is_arithmetic<K>::value && IsContiguousDenseVector<V, K>::value
+                    && (IsContiguousDenseVector<const W, const K>::value && ...))
+        fusedScalars(first, last, f, static_cast<V&>(z).data(), static_cast<const W&>(x).data()...);
+      else
+        for (std::size_t i = first; i < last; ++i)
+          z[i] = f(z[i], x[i]...);
+    }
+
+    //! z[i] = f(z[i], x[i]...) for all entries, sequential version
+    template<class F, class V, class... W>
+    void fusedTransform (const Execution::SequencedPolicy&, F f,
+                         DenseVector<V>& z, const DenseVector<W>&... x)
+    {
+      DUNE_ASSERT_BOUNDS(((x.size() == z.size()) && ...));
+      fusedTransform(0, z.size(), f, z, x...);
+    }
+
+    //! z[i] = f(z[i], x[i]...) for all entries, parallel version
+    template<class F, class V, class... W>
+    void fusedTransform (const Execution::ParallelPolicy& policy, F f,
+                         DenseVector<V>& z, const DenseVector<W>&... x)
+    {
+      DUNE_ASSERT_BOUNDS(((x.size() == z.size()) && ...));
+      if (z.size() < policy.threshold)
+        return fusedTransform(0, z.size(), f, z, x...);
+
+      forCacheLineChunks<typename DenseVector<V>::value_type>(z.size(), policy,
+        [&] (std::size_t first, std::size_t last) {
+          fusedTransform(first, last, f, z, x...);
+        });
+    }
+
+  } // end namespace Impl
+
+  //! vector space axpy operation ( y += a x ), sequential version
+  template<class V, class W>
+  V& axpy (const Execution::SequencedPolicy&, DenseVector<V>& y,
+           const typename DenseVector<V>::field_type& a, const DenseVector<W>& x)
+  {
+    return y.axpy(a, x);
+  }
+
+  //! vector space axpy operation ( y += a x ), parallel version
+  template<class V, class W>
+  V& axpy (const Execution::ParallelPolicy& policy, DenseVector<V>& y,
+           const typename DenseVector<V>::field_type& a, const DenseVector<W>& x)
+  {
+    DUNE_ASSERT_BOUNDS(x.size() == y.size());
+    if (y.size() < policy.threshold)
+      return y.axpy(a, x);
+
+    Impl::forCacheLineChunks<typename DenseVector<V>::value_type>(y.size(), policy,
+      [&] (std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+          y[i] += a*x[i];
+      });
+    return static_cast<V&>(y);
+  }
+
+  /** \brief fused vector space operation ( y = a x + b y )
+   *
+   * As in BLAS, y is not read if b is zero, so NaNs and infinities in an
+   * uninitialized y do not propagate into the result.
+   */
+  template<class Policy, class V, class W>
+  V& axpby (const Policy& policy, DenseVector<V>& y,
+            const typename DenseVector<V>::field_type& a, const DenseVector<W>& x,
+            const typename DenseVector<V>::field_type& b)
+  {
+    if (Impl::isZeroCoefficient(b)) {
+      Impl::fusedTransform(policy, [a] (const auto& yi, const auto& xi) {
+          std::decay_t<decltype(yi)> t(xi);
+          t *= a;
+          return t;
+        }, y, x);
+      return static_cast<V&>(y);
+    }
+    Impl::fusedTransform(policy, [a, b] (const auto& yi, const auto& xi) {
+        std::decay_t<decltype(yi)> t(yi);
+        t *= b;
+        Impl::axpyEntry(t, a, xi);
+        return t;
+      }, y, x);
+    return static_cast<V&>(y);
+  }
+
+  /** \brief fused vector space operation ( y = x + a y ), e.g. the update of the search direction of cg
+   *
+   * As for axpby, y is not read if a is zero.
+   */
+  template<class Policy, class V, class W>
+  V& xpay (const Policy& policy, DenseVector<V>& y,
+           const DenseVector<W>& x, const typename DenseVector<V>::field_type& a)
+  {
+    if (Impl::isZeroCoefficient(a)) {
+      Impl::fusedTransform(policy, [] (const auto& yi, const auto& xi) {
+          return std::decay_t<decltype(yi)>(xi);
+        }, y, x);
+      return static_cast<V&>(y);
+    }
+    Impl::fusedTransform(policy, [a] (const auto& yi, const auto& xi) {
+        std::decay_t<decltype(yi)> t(yi);
+        t *= a;
+        t += xi;
+        return t;
+      }, y, x);
+    return static_cast<V&>(y);
+  }
+
+  /** \brief fused multiple axpy operation ( y += a[0] x_0 + a[1] x_1 + ... )
+   *
+   * \code
+   * Dune::multiAxpy(Dune::Execution::par, y, { a, b, c }, x, v, w);
+   * \endcode
+   */
+  template<class Policy, class V, class... W>
+  V& multiAxpy (const Policy& policy, DenseVector<V>& y,
+                const std::array<typename DenseVector<V>::field_type, sizeof...(W)>& a,
+                const DenseVector<W>&... x)
+  {
+    Impl::fusedTransform(policy, [a] (const auto& yi, const auto&... xi) {
+        std::decay_t<decltype(yi)> t(yi);
+        std::size_t k = 0;
+        (Impl::axpyEntry(t, a[k++], xi), ...);
+        return t;
+      }, y, x...);
+    return static_cast<V&>(y);
+  }
+
+  /** \brief fused linear combination ( z = a[0] x_0 + a[1] x_1 + ... )
+   *
+   * The previous entries of z are not read.
+   * \code
+   * Dune::linearCombination(Dune::Execution::par, z, { a, b, c }, x, y, w);
+   * \endcode
+   */
+  template<class Policy, class V, class W0, class... W>
+  V& linearCombination (const Policy& policy, DenseVector<V>& z,
+                        const std::array<typename DenseVector<V>::field_type, sizeof...(W)+1>& a,
+                        const DenseVector<W0>& x0, const DenseVector<W>&... x)
+  {
+    Impl::fusedTransform(policy, [a] (const auto& zi, const auto& x0i, const auto&... xi) {
+        std::decay_t<decltype(zi)> t(x0i);
+        t *= a[0];
+        std::size_t k = 1;
+        (Impl::axpyEntry(t, a[k++], xi), ...);
+        return t;
+      }, z, x0, x...);
+    return static_cast<V&>(z);
+  }
+
+  //! vector dot product \f$\left (x^H \cdot y \right)\f$, sequential version
+  template<class V, class W>
+  auto dot (const Execution::SequencedPolicy&, const DenseVector<V>& x, const DenseVector<W>& y)
+  {
+    return x.dot(y);
+  }
+
+  /** \brief vector dot product \f$\left (x^H \cdot y \right)\f$, parallel version
+   *
+   * \note Unless the policy requests reproducible reductions, the summation
+   *       order depends on the number of threads and on the scheduling,
+   *       hence the rounding errors may change between runs.
+   */
+  template<class V, class W>
+  auto dot (const Execution::ParallelPolicy& policy, const DenseVector<V>& x, const DenseVector<W>& y)
+  {
+    typedef typename PromotionTraits<typename DenseVector<V>::field_type,
+                                     typename DenseVector<W>::field_type>::PromotedType PromotedType;
+    assert(x.size() == y.size());
+    if (policy.reproducible)
+      return Impl::reproducibleSum<PromotedType>(x.size(), policy,
+        [&] (std::size_t i) { return PromotedType(Dune::dot(x[i], y[i])); });
+    if (x.size() < policy.threshold)
+      return PromotedType(x.dot(y));
+
+    return Impl::reduceCacheLineChunks<typename DenseVector<V>::value_type>(x.size(), policy, PromotedType(0),
+      [&] (std::size_t first, std::size_t last, PromotedType result) {
+        for (std::size_t i = first; i < last; ++i)
+          result += Dune::dot(x[i], y[i]);
+        return result;
+      }, std::plus<PromotedType>());
+  }
+
+  //! square of two norm (sum over squared values of entries), sequential version
+  template<class V>
+  auto two_norm2 (const Execution::SequencedPolicy&, const DenseVector<V>& x)
+  {
+    return x.two_norm2();
+  }
+
+  //! square of two norm (sum over squared values of entries), parallel version
+  template<class V>
+  auto two_norm2 (const Execution::ParallelPolicy& policy, const DenseVector<V>& x)
+  {
+    typedef typename DenseVector<V>::value_type value_type;
+    typedef typename FieldTraits<value_type>::real_type real_type;
+    if (policy.reproducible)
+      return Impl::reproducibleSum<real_type>(x.size(), policy,
+        [&] (std::size_t i) { return real_type(fvmeta::abs2(x[i])); });
+    if (x.size() < policy.threshold)
+      return x.two_norm2();
+
+    return Impl::reduceCacheLineChunks<value_type>(x.size(), policy, real_type(0),
+      [&] (std::size_t first, std::size_t last, real_type result) {
+        for (std::size_t i = first; i < last; ++i)
+          result += fvmeta::abs2(x[i]);
+        return result;
+      }, std::plus<real_type>());
+  }
+
+  //! two norm sqrt(sum over squared values of entries)
+  template<class Policy, class V>
+  auto two_norm (const Policy& policy, const DenseVector<V>& x)
+  {
+    return fvmeta::sqrt(two_norm2(policy, x));
+  }
+
+  //! one norm (sum over absolute values of entries), sequential version
+  template<class V>
+  auto one_norm (const Execution::SequencedPolicy&, const DenseVector<V>& x)
+  {
+    return x.one_norm();
+  }
+
+  //! one norm (sum over absolute values of entries), parallel version
+  template<class V>
+  auto one_norm (const Execution::ParallelPolicy& policy, const DenseVector<V>& x)
+  {
+    typedef typename DenseVector<V>::value_type value_type;
+    typedef typename FieldTraits<value_type>::real_type real_type;
+    if (policy.reproducible)
+      return Impl::reproducibleSum<real_type>(x.size(), policy,
+        [&] (std::size_t i) { using std::abs; return real_type(abs(x[i])); });
+    if (x.size() < policy.threshold)
+      return x.one_norm();
+
+    return Impl::reduceCacheLineChunks<value_type>(x.size(), policy, real_type(0),
+      [&] (std::size_t first, std::size_t last, real_type result) {
+        using std::abs;
+        for (std::size_t i = first; i < last; ++i)
+          result += abs(x[i]);
+        return result;
+      }, std::plus<real_type>());
+  }
+
+  //! infinity norm (maximum of absolute values of entries), sequential version
+  template<class V>
+  auto infinity_norm (const Execution::SequencedPolicy&, const DenseVector<V>& x)
+  {
+    return x.infinity_norm();
+  }
+
+  /** \brief infinity norm (maximum of absolute values of entries), parallel version
+   *
+   * As the sequential version, the result is NaN if any entry is NaN.
+   */
+  template<class V>
+  auto infinity_norm (const Execution::ParallelPolicy& policy, const DenseVector<V>& x)
+  {
+    typedef typename DenseVector<V>::value_type value_type;
+    typedef typename FieldTraits<value_type>::real_type real_type;
+    if (x.size() < policy.threshold)
+      return x.infinity_norm();
+
+    // pairs of the maximum and the sum of all absolute values, the latter
+    // is used to propagate NaN for types having NaN
+    typedef std::pair<real_type, real_type> Partial;
+    const Partial partial = Impl::reduceCacheLineChunks<value_type>(x.size(), policy, Partial(0, 0),
+      [&] (std::size_t first, std::size_t last, Partial result) {
+        using std::abs;
+        using std::max;
+        for (std::size_t i = first; i < last; ++i) {
+          real_type const a = abs(x[i]);
+          result.first = max(a, result.first);
+          result.second += a;
+        }
+        return result;
+      },
+      [] (const Partial& a, const Partial& b) {
+        using std::max;
+        return Partial(max(a.first, b.first), a.second + b.second);
+      });
+
+    if (!HasNaN<value_type>::value)
+      return partial.first;
+    const real_type isNaN = partial.second + real_type(1);
+    return partial.first * (isNaN / isNaN);
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_PARALLELDENSEVECTOR_HH
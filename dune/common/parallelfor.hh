@@ -0,0 +1,399 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_PARALLELFOR_HH
+#define DUNE_COMMON_PARALLELFOR_HH
+
+/** \file
+ * \brief Parallel loops and reductions over index and iterator ranges
+ *
+ * The algorithms in this file use Intel's Threading Building Blocks if
+ * HAVE_TBB is set and the built-in work-stealing Dune::ThreadPool
+ * otherwise.  Overloads taking a ThreadPool explicitly always use the
+ * given pool.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dune/common/threadpool.hh>
+
+#if HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+#endif
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  //! Tuning parameters of the parallel algorithms
+  struct ParallelOptions
+  {
+    /** \brief Maximal number of iterations executed by a single task
+     *
+     * A value of zero selects the grain size automatically.
+     */
+    std::size_t grainSize = 0;
+
+    /** \brief Maximal number of threads working on the loop
+     *
+     * A value of zero uses all threads of the pool.
+     */
+    std::size_t numThreads = 0;
+  };
+
+  namespace Impl {
+
+    // distance between two indices or iterators
+    template<class I>
+    std::size_t rangeSize (I first, I last)
+    {
+      return (last > first) ? static_cast<std::size_t>(last - first) : 0;
+    }
+
+    template<class I, bool = std::is_integral<I>::value>
+    struct RangeDifference
+    {
+      typedef typename std::iterator_traits<I>::difference_type type;
+    };
+
+    template<class I>
+    struct RangeDifference<I, true>
+    {
+      typedef I type;
+    };
+
+    template<class I>
+    I rangeAdvance (I first, std::size_t n)
+    {
+      return first + static_cast<typename RangeDifference<I>::type>(n);
+    }
+
+    // number of threads a loop is distributed to
+    inline std::size_t effectiveThreads (const ParallelOptions& options, std::size_t concurrency)
+    {
+      return (options.numThreads == 0) ? concurrency : std::min(options.numThreads, concurrency);
+    }
+
+    // the grain size is chosen to give every thread about eight tasks
+    inline std::size_t effectiveGrainSize (const ParallelOptions& options, std::size_t n, std::size_t threads)
+    {
+      if (options.grainSize > 0)
+        return options.grainSize;
+      return std::max<std::size_t>(1, n / (8*threads));
+    }
+
+    // execute f on consecutive chunks of [first,last) in the calling thread
+    template<class I, class F>
+    void runSequential (I first, I last, std::size_t grainSize, F& f)
+    {
+      while (first != last) {
+        const I chunkLast = rangeAdvance(first, std::min(grainSize, rangeSize(first, last)));
+        f(first, chunkLast);
+        first = chunkLast;
+      }
+    }
+
+    // recursively split [first,last) and spawn the right halves as tasks
+    template<class I, class F>
+    void splitAndRun (TaskGroup& group, I first, I last, std::size_t grainSize, F& f)
+    {
+      std::size_t n = rangeSize(first, last);
+      while (n > grainSize) {
+        const I mid = rangeAdvance(first, n/2);
+        group.run([&group, mid, last, grainSize, &f] { splitAndRun(group, mid, last, grainSize, f); });
+        last = mid;
+        n = rangeSize(first, last);
+      }
+      f(first, last);
+    }
+
+    // execute f on chunks of [first,last) using at most options.numThreads threads of the pool
+    template<class I, class F>
+    void forChunks (ThreadPool& pool, I first, I last, F& f, const ParallelOptions& options)
+    {
+      const std::size_t n = rangeSize(first, last);
+      if (n == 0)
+        return;
+
+      const std::size_t threads = effectiveThreads(options, pool.concurrency());
+      const std::size_t grainSize = effectiveGrainSize(options, n, threads);
+      if (threads == 1 || n <= grainSize) {
+        runSequential(first, last, grainSize, f);
+        return;
+      }
+
+      TaskGroup group(pool);
+      if (threads < pool.concurrency()) {
+        // a limited number of threads is guaranteed by creating one
+        // task per thread, each working on a contiguous block
+        for (std::size_t t = 1; t < threads; ++t) {
+          const I blockFirst = rangeAdvance(first, t*n/threads);
+          const I blockLast = rangeAdvance(first, (t+1)*n/threads);
+          group.run([blockFirst, blockLast, grainSize, &f] { runSequential(blockFirst, blockLast, grainSize, f); });
+        }
+        runSequential(first, rangeAdvance(first, n/threads), grainSize, f);
+      }
+      else
+        splitAndRun(group, first, last, grainSize, f);
+      group.wait();
+    }
+
+    // partial results of the chunks executed by one thread, keyed by the
+    // offset of the chunk, padded to avoid false sharing
+    template<class T>
+    struct alignas(64) ReductionSlot
+    {
+      std::vector<std::pair<std::size_t, T> > partials;
+    };
+
+    template<class I, class T, class F, class R>
+    T reduceChunks (ThreadPool& pool, I first, I last, const T& identity, F& f, R& reduce,
+                    const ParallelOptions& options)
+    {
+      // every thread stores the partial results of the chunks it executes
+      // in its own slot (slot 0 is shared by all threads not belonging to
+      // the pool), they are combined in the order of the range afterwards
+      std::vector<ReductionSlot<T> > slots(pool.concurrency());
+      std::mutex sharedSlotMutex;
+      auto body = [&] (I chunkFirst, I chunkLast) {
+        T partial = f(chunkFirst, chunkLast, identity);
+        const std::size_t index = pool.threadIndex();
+        std::unique_lock<std::mutex> lock(sharedSlotMutex, std::defer_lock);
+        if (index == 0)
+          lock.lock();
+        slots[index].partials.emplace_back(rangeSize(first, chunkFirst), std::move(partial));
+      };
+      forChunks(pool, first, last, body, options);
+
+      std::vector<std::pair<std::size_t, T> > partials;
+      for (auto& slot : slots)
+        std::move(slot.partials.begin(), slot.partials.end(), std::back_inserter(partials));
+      std::sort(partials.begin(), partials.end(),
+                [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+      T result = identity;
+      for (auto& partial : partials)
+        result = reduce(result, partial.second);
+      return result;
+    }
+
+#if HAVE_TBB
+    template<class Body>
+    void executeInArena (const ParallelOptions& options, Body&& body)
+    {
+      if (options.numThreads == 0)
+        body();
+      else {
+        tbb::task_arena arena(static_cast<int>(options.numThreads));
+        arena.execute(body);
+      }
+    }
+#endif
+
+    // call f for an index or for the value an iterator points to
+    template<class I, class F,
+             std::enable_if_t<std::is_integral<I>::value, int> = 0>
+    void invokeElement (I i, F& f)
+    {
+      f(i);
+    }
+
+    template<class I, class F,
+             std::enable_if_t<!std::is_integral<I>::value, int> = 0>
+    void invokeElement (I it, F& f)
+    {
+      f(*it);
+    }
+
+    template<class I, class F,
+             std::enable_if_t<std::is_integral<I>::value, int> = 0>
+    auto transformElement (I i, F& f)
+    {
+      return f(i);
+    }
+
+    template<class I, class F,
+             std::enable_if_t<!std::is_integral<I>::value, int> = 0>
+    auto transformElement (I it, F& f)
+    {
+      return f(*it);
+    }
+
+  } // end namespace Impl
+
+  /** \brief The number of threads available to the parallel algorithms */
+  inline std::size_t parallelConcurrency ()
+  {
+#if HAVE_TBB
+    return tbb::this_task_arena::max_concurrency();
+#else
+    return ThreadPool::instance().concurrency();
+#endif
+  }
+
+  /** \brief Index of the calling thread in [0, parallelConcurrency())
+   *
+   * This can be used to address thread-local data inside the functions
+   * passed to the parallel algorithms.
+   */
+  inline std::size_t parallelThreadIndex ()
+  {
+#if HAVE_TBB
+    const int index = tbb::this_task_arena::current_thread_index();
+    return (index < 0) ? 0 : index;
+#else
+    return ThreadPool::instance().threadIndex();
+#endif
+  }
+
+  /** \brief Call f(chunkFirst, chunkLast) for disjoint chunks covering [first,last) in parallel
+   *
+   * \tparam I  An integral type or a random access iterator.
+   */
+  template<class I, class F>
+  void parallelForChunks (ThreadPool& pool, I first, I last, F&& f,
+                          const ParallelOptions& options = {})
+  {
+    Impl::forChunks(pool, first, last, f, options);
+  }
+
+  /** \brief Call f(chunkFirst, chunkLast) for disjoint chunks covering [first,last) in parallel
+   *
+   * \tparam I  An integral type or a random access iterator.
+   */
+  template<class I, class F>
+  void parallelForChunks (I first, I last, F&& f, const ParallelOptions& options = {})
+  {
+#if HAVE_TBB
+    if (first >= last)
+      return;
+    Impl::executeInArena(options, [&] {
+        auto body = [&f] (const tbb::blocked_range<I>& r) { f(r.begin(), r.end()); };
+        if (options.grainSize > 0)
+          tbb::parallel_for(tbb::blocked_range<I>(first, last, options.grainSize), body,
+                            tbb::simple_partitioner());
+        else
+          tbb::parallel_for(tbb::blocked_range<I>(first, last), body);
+      });
+#else
+    parallelForChunks(ThreadPool::instance(), first, last, f, options);
+#endif
+  }
+
+  /** \brief Call f(i) for every index in [first,last), or f(*it) for every iterator, in parallel */
+  template<class I, class F>
+  void parallelFor (ThreadPool& pool, I first, I last, F&& f,
+                    const ParallelOptions& options = {})
+  {
+    parallelForChunks(pool, first, last, [&f] (I chunkFirst, I chunkLast) {
+        for (; chunkFirst != chunkLast; ++chunkFirst)
+          Impl::invokeElement(chunkFirst, f);
+      }, options);
+  }
+
+  /** \brief Call f(i) for every index in [first,last), or f(*it) for every iterator, in parallel */
+  template<class I, class F>
+  void parallelFor (I first, I last, F&& f, const ParallelOptions& options = {})
+  {
+    parallelForChunks(first, last, [&f] (I chunkFirst, I chunkLast) {
+        for (; chunkFirst != chunkLast; ++chunkFirst)
+          Impl::invokeElement(chunkFirst, f);
+      }, options);
+  }
+
+  /** \brief Reduce disjoint chunks of [first,last) in parallel
+   *
+   * \param identity  The neutral element of the reduction.
+   * \param f         Called as f(chunkFirst, chunkLast, init) and returns
+   *                  the reduction of init and the chunk.
+   * \param reduce    Associative binary operation combining two partial results.
+   *
+   * The partial results are combined in the order of the range, so reduce
+   * need not be commutative.  Where the range is split into chunks depends
+   * on the scheduling, hence floating point results may differ between runs.
+   */
+  template<class I, class T, class F, class R>
+  T parallelReduceChunks (ThreadPool& pool, I first, I last, const T& identity, F&& f, R&& reduce,
+                          const ParallelOptions& options = {})
+  {
+    return Impl::reduceChunks(pool, first, last, identity, f, reduce, options);
+  }
+
+  /** \brief Reduce disjoint chunks of [first,last) in parallel
+   *
+   * \copydetails parallelReduceChunks(ThreadPool&,I,I,const T&,F&&,R&&,const ParallelOptions&)
+   */
+  template<class I, class T, class F, class R>
+  T parallelReduceChunks (I first, I last, const T& identity, F&& f, R&& reduce,
+                          const ParallelOptions& options = {})
+  {
+#if HAVE_TBB
+    if (first >= last)
+      return identity;
+    T result = identity;
+    Impl::executeInArena(options, [&] {
+        auto body = [&f] (const tbb::blocked_range<I>& r, T init) { return f(r.begin(), r.end(), init); };
+        if (options.grainSize > 0)
+          result = tbb::parallel_reduce(tbb::blocked_range<I>(first, last, options.grainSize), identity,
+                                        body, reduce, tbb::simple_partitioner());
+        else
+          result = tbb::parallel_reduce(tbb::blocked_range<I>(first, last), identity, body, reduce);
+      });
+    return result;
+#else
+    return parallelReduceChunks(ThreadPool::instance(), first, last, identity, f, reduce, options);
+#endif
+  }
+
+  /** \brief Reduce the values f(i) for all indices i in [first,last), or f(*it) for all iterators, in parallel
+   *
+   * \param identity  The neutral element of the reduction.
+   * \param f         Maps an index or an element to a value.
+   * \param reduce    Associative binary operation combining two values, it
+   *                  need not be commutative.
+   */
+  template<class I, class T, class F, class R>
+  T parallelReduce (ThreadPool& pool, I first, I last, const T& identity, F&& f, R&& reduce,
+                    const ParallelOptions& options = {})
+  {
+    return parallelReduceChunks(pool, first, last, identity,
+      [&f, &reduce] (I chunkFirst, I chunkLast, T acc) {
+        for (; chunkFirst != chunkLast; ++chunkFirst)
+          acc = reduce(acc, Impl::transformElement(chunkFirst, f));
+        return acc;
+      }, reduce, options);
+  }
+
+  /** \brief Reduce the values f(i) for all indices i in [first,last), or f(*it) for all iterators, in parallel
+   *
+   * \copydetails parallelReduce(ThreadPool&,I,I,const T&,F&&,R&&,const ParallelOptions&)
+   */
+  template<class I, class T, class F, class R>
+  T parallelReduce (I first, I last, const T& identity, F&& f, R&& reduce,
+                    const ParallelOptions& options = {})
+  {
+    return parallelReduceChunks(first, last, identity,
+      [&f, &reduce] (I chunkFirst, I chunkLast, T acc) {
+        for (; chunkFirst != chunkLast; ++chunkFirst)
+          acc = reduce(acc, Impl::transformElement(chunkFirst, f));
+        return acc;
+      }, reduce, options);
+  }
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_PARALLELFOR_HH
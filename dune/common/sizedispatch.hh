@@ -0,0 +1,118 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_SIZEDISPATCH_HH
+#define DUNE_COMMON_SIZEDISPATCH_HH
+
+/** \file
+ * \brief Dispatch from run-time sizes to compile-time sizes
+ *
+ * Codes knowing a dimension only at run time can still use the statically
+ * sized FieldVector kernels by dispatching once per batch of work instead
+ * of once per entry:
+ * \code
+ * Dune::dispatchFieldVector<double>(Dune::SizeRange<1,8>{}, dim,
+ *   [&] (auto meta) {
+ *     using Vector = typename decltype(meta)::type;  // FieldVector<double,dim>
+ *     for (const auto& element : elements) { Vector x; ... }
+ *   },
+ *   [&] (auto meta) {
+ *     using Vector = typename decltype(meta)::type;  // DynamicVector<double>
+ *     for (const auto& element : elements) { Vector x(dim); ... }
+ *   });
+ * \endcode
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <dune/common/dynvector.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/typetraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  //! A list of compile-time sizes for dispatchSize()
+  template<int... sizes>
+  using SizeList = std::integer_sequence<int, sizes...>;
+
+  namespace Impl {
+
+    template<int first, class Offsets>
+    struct SizeRangeHelper;
+
+    template<int first, int... offsets>
+    struct SizeRangeHelper<first, std::integer_sequence<int, offsets...> >
+    {
+      typedef SizeList<(first + offsets)...> type;
+    };
+
+    template<class F, class Fallback>
+    decltype(auto) dispatchSize (SizeList<>, std::size_t n, F&, Fallback& fallback)
+    {
+      return fallback(n);
+    }
+
+    template<int size, int... sizes, class F, class Fallback>
+    decltype(auto) dispatchSize (SizeList<size, sizes...>, std::size_t n, F& f, Fallback& fallback)
+    {
+      if (n == std::size_t(size))
+        return f(std::integral_constant<int, size>{});
+      return dispatchSize(SizeList<sizes...>{}, n, f, fallback);
+    }
+
+  } // end namespace Impl
+
+  //! The list of the consecutive sizes first, first+1, ..., last
+  template<int first, int last>
+  using SizeRange = typename Impl::SizeRangeHelper<first, std::make_integer_sequence<int, last-first+1> >::type;
+
+  /** \brief Call a function with a run-time size converted to a compile-time constant
+   *
+   * \param sizes     the list of sizes for which f is instantiated
+   * \param n         the run-time size
+   * \param f         called as f(std::integral_constant<int,n>()) if n is in sizes
+   * \param fallback  called as fallback(n) otherwise
+   *
+   * All calls must return the same type, which is the return type of
+   * dispatchSize.  The sizes are compared in a chain which compilers
+   * translate into a single switch.
+   */
+  template<int... sizes, class F, class Fallback>
+  decltype(auto) dispatchSize (SizeList<sizes...> sizeList, std::size_t n, F&& f, Fallback&& fallback)
+  {
+    return Impl::dispatchSize(sizeList, n, f, fallback);
+  }
+
+  /** \brief Call a function with the FieldVector type of a run-time size
+   *
+   * \tparam K        the field type of the vectors
+   * \param sizes     the list of sizes for which f is instantiated
+   * \param n         the run-time size
+   * \param f         called as f(MetaType<FieldVector<K,n>>()) if n is in sizes
+   * \param fallback  called as fallback(MetaType<DynamicVector<K>>()) otherwise
+   *
+   * All calls must return the same type, which is the return type of
+   * dispatchFieldVector.
+   */
+  template<class K, int... sizes, class F, class Fallback>
+  decltype(auto) dispatchFieldVector (SizeList<sizes...> sizeList, std::size_t n, F&& f, Fallback&& fallback)
+  {
+    auto staticCase = [&f] (auto size) -> decltype(auto) {
+      return f(MetaType<FieldVector<K, decltype(size)::value> >{});
+    };
+    auto dynamicCase = [&fallback] (std::size_t) -> decltype(auto) {
+      return fallback(MetaType<DynamicVector<K> >{});
+    };
+    return Impl::dispatchSize(sizeList, n, staticCase, dynamicCase);
+  }
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_SIZEDISPATCH_HH
@@ -0,0 +1,310 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_SMALLVECTOR_HH
+#define DUNE_COMMON_SMALLVECTOR_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <istream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "boundschecking.hh"
+#include "densevector.hh"
+#include "ftraits.hh"
+#include "typetraits.hh"
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  /*! \file
+   * \brief A dense vector with a dynamic size and inline storage for small sizes.
+   */
+
+  template< class K, int N > class SmallVector;
+  template< class K, int N >
+  struct DenseMatVecTraits< SmallVector< K, N > >
+  {
+    typedef SmallVector< K, N > derived_type;
+    typedef K* container_type;
+    typedef K value_type;
+    typedef std::size_t size_type;
+  };
+
+  template< class K, int N >
+  struct FieldTraits< SmallVector< K, N > >
+  {
+    typedef typename FieldTraits< K >::field_type field_type;
+    typedef typename FieldTraits< K >::real_type real_type;
+  };
+
+  //! A SmallVector can be relocated by memcpy if its entries can
+  template< class K, int N >
+  struct IsTriviallyRelocatable< SmallVector< K, N > >
+    : public IsTriviallyRelocatable< K > {};
+
+  /** \brief A vector with a run-time size storing up to N entries inline
+   *
+   * Vectors of at most N entries live inside the object and need no heap
+   * allocation, larger vectors switch to heap memory.  This is meant for
+   * element-local data whose size is only known at run time but small in
+   * almost all cases, e.g. the number of local basis functions.
+   *
+   * The object does not contain a pointer to its own inline storage, so it
+   * can be relocated by copying its bytes whenever its entries can, see
+   * IsTriviallyRelocatable.
+   *
+   * \tparam K the field type (use float, double, complex, etc)
+   * \tparam N number of entries stored inline
+   */
+  template< class K, int N >
+  class SmallVector : public DenseVector< SmallVector< K, N > >
+  {
+    static_assert(N > 0, "SmallVector needs an inline capacity of at least one entry");
+
+    typedef DenseVector< SmallVector< K, N > > Base;
+  public:
+    typedef typename Base::size_type size_type;
+    typedef typename Base::value_type value_type;
+
+    //! number of entries stored without heap allocation
+    static constexpr size_type inlineCapacity = N;
+
+    //! Constructor making an empty vector
+    SmallVector () noexcept
+    {}
+
+    //! Constructor making a value-initialized vector of size n
+    explicit SmallVector (size_type n)
+    {
+      reserve(n);
+      std::uninitialized_value_construct_n(data(), n);
+      size_ = n;
+    }
+
+    //! Constructor making vector with identical coordinates
+    SmallVector (size_type n, const value_type& c)
+    {
+      reserve(n);
+      std::uninitialized_fill_n(data(), n, c);
+      size_ = n;
+    }
+
+    /** \brief Construct from a std::initializer_list */
+    SmallVector (std::initializer_list<K> const &l)
+    {
+      reserve(l.size());
+      std::uninitialized_copy(l.begin(), l.end(), data());
+      size_ = l.size();
+    }
+
+    //! Copy constructor
+    SmallVector (const SmallVector& x)
+      : Base()
+    {
+      reserve(x.size_);
+      std::uninitialized_copy_n(x.data(), x.size_, data());
+      size_ = x.size_;
+    }
+
+    //! Move constructor, steals the heap memory of x
+    SmallVector (SmallVector&& x) noexcept(std::is_nothrow_move_constructible<K>::value)
+    {
+      if (x.onHeap()) {
+        storage_.heap = x.storage_.heap;
+        capacity_ = x.capacity_;
+        size_ = x.size_;
+        x.capacity_ = N;
+        x.size_ = 0;
+      }
+      else {
+        std::uninitialized_move_n(x.data(), x.size_, data());
+        size_ = x.size_;
+        x.clear();
+      }
+    }
+
+    //! Copy constructor from another DenseVector
+    template< class X >
+    SmallVector (const DenseVector< X >& x)
+    {
+      const size_type n = x.size();
+      reserve(n);
+      for (size_type i = 0; i < n; ++i, ++size_)
+        ::new (static_cast<void*>(data() + i)) K(x[i]);
+    }
+
+    ~SmallVector ()
+    {
+      clear();
+      deallocate();
+    }
+
+    using Base::operator=;
+
+    //! Copy assignment operator
+    SmallVector& operator= (const SmallVector& other)
+    {
+      if (this != &other)
+        assign(other.data(), other.size_);
+      return *this;
+    }
+
+    //! Move assignment operator
+    SmallVector& operator= (SmallVector&& other) noexcept(std::is_nothrow_move_constructible<K>::value)
+    {
+      if (this != &other) {
+        clear();
+        if (other.onHeap()) {
+          deallocate();
+          storage_.heap = other.storage_.heap;
+          capacity_ = other.capacity_;
+          size_ = other.size_;
+          other.capacity_ = N;
+          other.size_ = 0;
+        }
+        else {
+          // the entries of other fit into any storage of this vector
+          std::uninitialized_move_n(other.data(), other.size_, data());
+          size_ = other.size_;
+          other.clear();
+        }
+      }
+      return *this;
+    }
+
+    //! Number of entries which fit into the current storage
+    size_type capacity () const noexcept
+    {
+      return capacity_;
+    }
+
+    //! Whether the entries live on the heap instead of inside the object
+    bool onHeap () const noexcept
+    {
+      return capacity_ > size_type(N);
+    }
+
+    //! Ensure storage for n entries, switching to heap memory for n > N
+    void reserve (size_type n)
+    {
+      if (n <= capacity_)
+        return;
+
+      K* memory = std::allocator<K>().allocate(n);
+      std::uninitialized_move_n(data(), size_, memory);
+      std::destroy_n(data(), size_);
+      deallocate();
+      storage_.heap = memory;
+      capacity_ = n;
+    }
+
+    //! Change the size, new entries are initialized to c
+    void resize (size_type n, const value_type& c = value_type())
+    {
+      if (n > capacity_)
+        reserve(std::max(n, 2*capacity_));
+      if (n > size_)
+        std::uninitialized_fill(data() + size_, data() + n, c);
+      else
+        std::destroy(data() + n, data() + size_);
+      size_ = n;
+    }
+
+    //! Remove all entries, keeping the storage
+    void clear () noexcept
+    {
+      std::destroy_n(data(), size_);
+      size_ = 0;
+    }
+
+    //==== make this thing a vector
+    size_type size () const noexcept { return size_; }
+    K & operator[](size_type i) {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return data()[i];
+    }
+    const K & operator[](size_type i) const {
+      DUNE_ASSERT_BOUNDS(i < size());
+      return data()[i];
+    }
+
+    //! return pointer to underlying array
+    K* data() noexcept
+    {
+      return onHeap() ? storage_.heap : storage_.values;
+    }
+
+    //! return pointer to underlying array
+    const K* data() const noexcept
+    {
+      return onHeap() ? storage_.heap : storage_.values;
+    }
+
+  private:
+    // replace the entries by copies of [values, values+n)
+    void assign (const K* values, size_type n)
+    {
+      clear();
+      reserve(n);
+      std::uninitialized_copy_n(values, n, data());
+      size_ = n;
+    }
+
+    // free the heap memory, if any, and return to the inline storage
+    void deallocate () noexcept
+    {
+      if (onHeap())
+        std::allocator<K>().deallocate(storage_.heap, capacity_);
+      capacity_ = N;
+    }
+
+    // inline entries or pointer to the heap memory, distinguished by capacity_
+    union Storage
+    {
+      Storage () noexcept {}
+      ~Storage () {}
+
+      K values[N];
+      K* heap;
+    };
+
+    size_type size_ = 0;
+    size_type capacity_ = N;
+    Storage storage_;
+  };
+
+  /** \brief Read a SmallVector from an input stream
+   *  \relates SmallVector
+   *
+   *  \note This operator is STL compliant, i.e., the content of v is only
+   *        changed if the read operation is successful.
+   *
+   *  \param[in]  in  std :: istream to read from
+   *  \param[out] v   SmallVector to be read
+   *
+   *  \returns the input stream (in)
+   */
+  template< class K, int N >
+  inline std::istream &operator>> ( std::istream &in,
+                                    SmallVector< K, N > &v )
+  {
+    SmallVector< K, N > w(v);
+    for( typename SmallVector< K, N >::size_type i = 0; i < w.size(); ++i )
+      in >> w[ i ];
+    if(in)
+      v = std::move(w);
+    return in;
+  }
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif // DUNE_COMMON_SMALLVECTOR_HH
@@ -0,0 +1,299 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_SUMMATION_HH
+#define DUNE_COMMON_SUMMATION_HH
+
+/** \file
+ * \brief Summation methods for the reductions of DenseVector
+ *
+ * The summation method is selected by a tag type passed as template
+ * argument, e.g.
+ * \code
+ * auto d = x.dot<Dune::Summation::Compensated>(y);
+ * auto n = x.two_norm2<Dune::Summation::Compensated>();
+ * \endcode
+ */
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <dune/common/dotproduct.hh>
+#include <dune/common/ftraits.hh>
+
+namespace Dune {
+
+  /** @addtogroup DenseMatVec
+      @{
+   */
+
+  //! Tags selecting the summation method of reductions
+  namespace Summation {
+
+    /** \brief Recursive summation, as done by the plain reductions
+     *
+     * The sums run in index order, except for complex entries, whose
+     * kernels keep several interleaved partial sums, see complexkernels.hh.
+     */
+    struct Naive {};
+
+    /** \brief Compensated summation of products (Dot2 of Ogita, Rump and Oishi)
+     *
+     * Every product and every addition is computed by an error-free
+     * transformation, and the rounding errors are accumulated separately.
+     * The result is as accurate as if computed in twice the working
+     * precision and then rounded to working precision.  Four interleaved
+     * accumulators keep independent dependency chains, so the additional
+     * floating point operations mostly hide in the latency of the plain
+     * loop.
+     *
+     * The method applies to real and complex floating point entries.  For
+     * all other types the naive summation is used.
+     */
+    struct Compensated {};
+
+  } // end namespace Summation
+
+  //! Whether T is one of the tags in namespace Summation
+  template<class T>
+  struct IsSummationMethod : std::false_type {};
+
+  template<>
+  struct IsSummationMethod<Summation::Naive> : std::true_type {};
+
+  template<>
+  struct IsSummationMethod<Summation::Compensated> : std::true_type {};
+
+  /** \brief Error-free transformation of a sum
+   *
+   * \returns the pair (s,e) with s = fl(a+b) and s + e = a + b exactly (Knuth's TwoSum)
+   */
+  template<class K>
+  std::pair<K,K> twoSum (const K& a, const K& b)
+  {
+    const K s = a + b;
+    const K z = s - a;
+    return { s, (a - (s - z)) + (b - z) };
+  }
+
+  /** \brief Error-free transformation of a product
+   *
+   * \returns the pair (p,e) with p = fl(a*b) and p + e = a * b exactly
+   *
+   * The error is computed by a fused multiply-add if the target has a fast
+   * one, and by Dekker's splitting otherwise.
+   */
+  template<class K>
+  std::pair<K,K> twoProduct (const K& a, const K& b)
+  {
+    static_assert(std::is_floating_point<K>::value, "twoProduct requires a floating point type");
+    const K p = a * b;
+#if defined(FP_FAST_FMA) || defined(__FMA__)
+    using std::fma;
+    return { p, fma(a, b, -p) };
+#else
+    // Veltkamp's splitting of a and b into halves of the mantissa
+    const K factor = std::ldexp(K(1), (std::numeric_limits<K>::digits + 1) / 2) + K(1);
+    const K ca = factor * a;
+    const K ah = ca - (ca - a);
+    const K al = a - ah;
+    const K cb = factor * b;
+    const K bh = cb - (cb - b);
+    const K bl = b - bh;
+    return { p, al*bl - (((p - ah*bh) - al*bh) - ah*bl) };
+#endif
+  }
+
+  namespace Impl {
+
+    // whether the compensated reductions support entries of type K
+    template<class K>
+    struct IsCompensable : std::is_floating_point<K> {};
+
+    template<class K>
+    struct IsCompensable<std::complex<K> > : std::is_floating_point<K> {};
+
+    //! A floating point sum together with the accumulated rounding error
+    template<class K>
+    struct CompensatedAccumulator
+    {
+      K sum = K(0);
+      K error = K(0);
+
+      void addProduct (const K& a, const K& b)
+      {
+        const auto p = twoProduct(a, b);
+        const auto s = twoSum(sum, p.first);
+        sum = s.first;
+        error += s.second + p.second;
+      }
+
+      void merge (const CompensatedAccumulator& other)
+      {
+        const auto s = twoSum(sum, other.sum);
+        sum = s.first;
+        error += s.second + other.error;
+      }
+
+      K value () const
+      {
+        return sum + error;
+      }
+    };
+
+    // accumulate the real and imaginary part of conj(a)*b
+    template<class K>
+    void accumulateDot (CompensatedAccumulator<K>& re, CompensatedAccumulator<K>&, const K& a, const K& b)
+    {
+      re.addProduct(a, b);
+    }
+
+    template<class K>
+    void accumulateDot (CompensatedAccumulator<K>& re, CompensatedAccumulator<K>& im,
+                        const std::complex<K>& a, const std::complex<K>& b)
+    {
+      re.addProduct(a.real(), b.real());
+      re.addProduct(a.imag(), b.imag());
+      im.addProduct(a.real(), b.imag());
+      im.addProduct(-a.imag(), b.real());
+    }
+
+    template<class K>
+    void accumulateDot (CompensatedAccumulator<K>& re, CompensatedAccumulator<K>& im,
+                        const K& a, const std::complex<K>& b)
+    {
+      re.addProduct(a, b.real());
+      im.addProduct(a, b.imag());
+    }
+
+    template<class K>
+    void accumulateDot (CompensatedAccumulator<K>& re, CompensatedAccumulator<K>& im,
+                        const std::complex<K>& a, const K& b)
+    {
+      re.addProduct(a.real(), b);
+      im.addProduct(-a.imag(), b);
+    }
+
+    // accumulate |a|^2
+    template<class K>
+    void accumulateAbs2 (CompensatedAccumulator<K>& acc, const K& a)
+    {
+      acc.addProduct(a, a);
+    }
+
+    template<class K>
+    void accumulateAbs2 (CompensatedAccumulator<K>& acc, const std::complex<K>& a)
+    {
+      acc.addProduct(a.real(), a.real());
+      acc.addProduct(a.imag(), a.imag());
+    }
+
+    template<class T, class K,
+             std::enable_if_t<std::is_same<T, typename FieldTraits<T>::real_type>::value, int> = 0>
+    T compensatedResult (const CompensatedAccumulator<K>& re, const CompensatedAccumulator<K>&)
+    {
+      return T(re.value());
+    }
+
+    template<class T, class K,
+             std::enable_if_t<!std::is_same<T, typename FieldTraits<T>::real_type>::value, int> = 0>
+    T compensatedResult (const CompensatedAccumulator<K>& re, const CompensatedAccumulator<K>& im)
+    {
+      return T(re.value(), im.value());
+    }
+
+    //! number of interleaved accumulators of the compensated reductions
+    constexpr std::size_t compensatedLanes = 4;
+
+    //! the dot product of x and y, with result type T, using summation method M
+    template<class T, class M, class X, class Y,
+             class Kx = std::decay_t<decltype(std::declval<const X&>()[0])>,
+             class Ky = std::decay_t<decltype(std::declval<const Y&>()[0])>,
+             bool compensated = std::is_same<M, Summation::Compensated>::value
+               && IsCompensable<Kx>::value && IsCompensable<Ky>::value
+               && std::is_same<typename FieldTraits<Kx>::real_type, typename FieldTraits<Ky>::real_type>::value>
+    struct SummedDot
+    {
+      static T apply (const X& x, const Y& y)
+      {
+        T result(0);
+        for (std::size_t i = 0; i < x.size(); ++i)
+          result += Dune::dot(x[i], y[i]);
+        return result;
+      }
+    };
+
+    template<class T, class M, class X, class Y, class Kx, class Ky>
+    struct SummedDot<T, M, X, Y, Kx, Ky, true>
+    {
+      static T apply (const X& x, const Y& y)
+      {
+        typedef typename FieldTraits<Kx>::real_type real_type;
+        constexpr std::size_t L = compensatedLanes;
+        CompensatedAccumulator<real_type> re[L], im[L];
+
+        const std::size_t n = x.size();
+        std::size_t i = 0;
+        for (; i + L <= n; i += L)
+          for (std::size_t l = 0; l < L; ++l)
+            accumulateDot(re[l], im[l], x[i+l], y[i+l]);
+        for (std::size_t l = 0; i + l < n; ++l)
+          accumulateDot(re[l], im[l], x[i+l], y[i+l]);
+
+        for (std::size_t l = 1; l < L; ++l) {
+          re[0].merge(re[l]);
+          im[0].merge(im[l]);
+        }
+        return compensatedResult<T>(re[0], im[0]);
+      }
+    };
+
+    //! the sum of the squared absolute values of the entries of x, using summation method M
+    template<class T, class M, class X,
+             class K = std::decay_t<decltype(std::declval<const X&>()[0])>,
+             bool compensated = std::is_same<M, Summation::Compensated>::value && IsCompensable<K>::value>
+    struct SummedAbs2
+    {
+      template<class Abs2>
+      static T apply (const X& x, Abs2&& abs2)
+      {
+        T result(0);
+        for (std::size_t i = 0; i < x.size(); ++i)
+          result += abs2(x[i]);
+        return result;
+      }
+    };
+
+    template<class T, class M, class X, class K>
+    struct SummedAbs2<T, M, X, K, true>
+    {
+      template<class Abs2>
+      static T apply (const X& x, Abs2&&)
+      {
+        constexpr std::size_t L = compensatedLanes;
+        CompensatedAccumulator<T> acc[L];
+
+        const std::size_t n = x.size();
+        std::size_t i = 0;
+        for (; i + L <= n; i += L)
+          for (std::size_t l = 0; l < L; ++l)
+            accumulateAbs2(acc[l], x[i+l]);
+        for (std::size_t l = 0; i + l < n; ++l)
+          accumulateAbs2(acc[l], x[i+l]);
+
+        for (std::size_t l = 1; l < L; ++l)
+          acc[0].merge(acc[l]);
+        return acc[0].value();
+      }
+    };
+
+  } // end namespace Impl
+
+  /** @} end documentation */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_SUMMATION_HH
@@ -0,0 +1,112 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include <dune/common/arena.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+
+struct ArenaTestException : Dune::Exception {};
+
+#define ARENATEST_ASSERT(EXPR)                              \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(ArenaTestException,                          \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+bool isAligned (const void* p, std::size_t alignment)
+{
+  return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+void testAllocation ()
+{
+  Dune::ArenaResource arena(256);
+  ARENATEST_ASSERT(arena.capacity() == 0);
+
+  void* a = arena.allocate(10, 1);
+  void* b = arena.allocate(8, 8);
+  ARENATEST_ASSERT(isAligned(b, 8));
+  ARENATEST_ASSERT(static_cast<char*>(b) >= static_cast<char*>(a) + 10);
+  ARENATEST_ASSERT(arena.capacity() == 256);
+
+  // over-aligned and oversized requests
+  ARENATEST_ASSERT(isAligned(arena.allocate(100, 128), 128));
+  ARENATEST_ASSERT(isAligned(arena.allocate(4096, 256), 256));
+  ARENATEST_ASSERT(arena.capacity() >= 256 + 4096);
+
+  // after a reset the same memory is handed out again
+  arena.reset();
+  ARENATEST_ASSERT(arena.allocate(10, 1) == a);
+  ARENATEST_ASSERT(arena.allocate(8, 8) == b);
+
+  arena.release();
+  ARENATEST_ASSERT(arena.capacity() == 0);
+  ARENATEST_ASSERT(arena.allocate(10, 1) != nullptr);
+  ARENATEST_ASSERT(arena.capacity() > 0);
+
+  ARENATEST_ASSERT(arena.is_equal(arena));
+  ARENATEST_ASSERT(!arena.is_equal(*std::pmr::new_delete_resource()));
+}
+
+void testScopes ()
+{
+  Dune::ArenaResource arena(1024);
+  const void* first = nullptr;
+  for (int iteration = 0; iteration < 10; ++iteration) {
+    Dune::ArenaScope scope(arena);
+    Dune::pmr::DynamicVector<double> x(20, 1.0, scope.allocator<double>());
+    ARENATEST_ASSERT(x.get_allocator().resource() == &arena);
+    if (iteration == 0)
+      first = x.data();
+    ARENATEST_ASSERT(x.data() == first);
+
+    {
+      Dune::ArenaScope inner(arena);
+      Dune::pmr::DynamicVector<double> y(x, inner.allocator<double>());
+      y *= 2.0;
+      x += y;
+      // growing beyond the first chunk
+      Dune::pmr::DynamicVector<double> z(500, &arena);
+      ARENATEST_ASSERT(z.two_norm2() == 0.0);
+    }
+    ARENATEST_ASSERT(x[19] == 3.0);
+
+    // copies follow the std::pmr rules and use the default resource
+    Dune::pmr::DynamicVector<double> c(x);
+    ARENATEST_ASSERT(c.get_allocator().resource() == std::pmr::get_default_resource());
+  }
+  ARENATEST_ASSERT(arena.mark().chunk == 0 && arena.mark().offset == 0);
+}
+
+void testThreadLocal ()
+{
+  Dune::ArenaResource* main = &Dune::ArenaResource::threadLocal();
+  ARENATEST_ASSERT(main == &Dune::ArenaResource::threadLocal());
+
+  Dune::ArenaResource* other = nullptr;
+  std::thread t([&] {
+      Dune::ArenaScope scope;
+      Dune::pmr::DynamicVector<int> v(100, 1, scope.allocator<int>());
+      other = &scope.resource();
+    });
+  t.join();
+  ARENATEST_ASSERT(other != main);
+}
+
+int main()
+{
+  testAllocation();
+  testScopes();
+  testThreadLocal();
+  return 0;
+}
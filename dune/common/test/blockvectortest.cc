@@ -0,0 +1,204 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include <dune/common/blockvector.hh>
+#include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+
+struct BlockVectorTestException : Dune::Exception {};
+
+#define BLOCKVECTORTEST_ASSERT(EXPR)                        \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(BlockVectorTestException,                    \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::BlockVector;
+using Dune::DynamicVector;
+using Dune::FieldVector;
+
+static_assert(BlockVector<double>::blocklevel == 1, "");
+static_assert(BlockVector<FieldVector<double,3> >::blocklevel == 2, "");
+static_assert(BlockVector<BlockVector<FieldVector<double,3> > >::blocklevel == 3, "");
+static_assert(Dune::Impl::IsFlatBlock<FieldVector<double,3> >::value, "");
+static_assert(Dune::Impl::IsFlatBlock<FieldVector<float,1> >::value, "");
+static_assert(!Dune::Impl::IsFlatBlock<FieldVector<std::complex<double>,2> >::value, "");
+static_assert(!Dune::Impl::IsFlatBlock<DynamicVector<double> >::value, "");
+
+template<class K>
+bool close (K a, K b)
+{
+  using std::abs;
+  using std::max;
+  typedef typename Dune::FieldTraits<K>::real_type real_type;
+  return abs(a - b) <= 64 * std::numeric_limits<real_type>::epsilon() * max(abs(a), abs(b));
+}
+
+// entries with many different magnitudes, so that rounding matters
+template<class K>
+K makeEntry (int i, int seed)
+{
+  return K(std::sin(0.37*i + seed)) * K(1 + (i % 13));
+}
+
+// the flattened kernels of BlockVector<FieldVector<K,k> > agree with the
+// recursive ones of BlockVector<DynamicVector<K> >
+template<class K, int k>
+void testFlatKernels (int n)
+{
+  typedef BlockVector<FieldVector<K,k> > Vector;
+  typedef BlockVector<DynamicVector<K> > Reference;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  Vector x(n), y(n);
+  Reference xr(n, DynamicVector<K>(k)), yr(n, DynamicVector<K>(k));
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < k; ++j) {
+      xr[i][j] = x[i][j] = makeEntry<K>(i*k + j, 1);
+      yr[i][j] = y[i][j] = makeEntry<K>(i*k + j, 2);
+    }
+
+  BLOCKVECTORTEST_ASSERT(x.size() == std::size_t(n) && x.N() == std::size_t(n));
+  BLOCKVECTORTEST_ASSERT(x.dim() == std::size_t(n*k) && xr.dim() == x.dim());
+
+  // reductions, up to rounding
+  BLOCKVECTORTEST_ASSERT(close(x.dot(y), xr.dot(yr)));
+  BLOCKVECTORTEST_ASSERT(close(x * y, xr * yr));
+  BLOCKVECTORTEST_ASSERT(close(x.one_norm(), xr.one_norm()));
+  BLOCKVECTORTEST_ASSERT(close(x.one_norm_real(), xr.one_norm_real()));
+  BLOCKVECTORTEST_ASSERT(close(x.two_norm2(), xr.two_norm2()));
+  BLOCKVECTORTEST_ASSERT(close(x.two_norm(), xr.two_norm()));
+
+  // maxima and element-wise operations, exactly
+  BLOCKVECTORTEST_ASSERT(x.infinity_norm() == xr.infinity_norm());
+  BLOCKVECTORTEST_ASSERT(x.infinity_norm_real() == xr.infinity_norm_real());
+
+  const K a = K(0.75);
+  x.axpy(a, y);
+  xr.axpy(a, yr);
+  x += y;
+  xr += yr;
+  x *= K(3);
+  xr *= K(3);
+  x -= y;
+  xr -= yr;
+  x /= K(7);
+  xr /= K(7);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < k; ++j)
+      BLOCKVECTORTEST_ASSERT(x[i][j] == xr[i][j]);
+
+  x = K(2);
+  BLOCKVECTORTEST_ASSERT(x.two_norm2() == K(4*n*k) && x.one_norm() == K(2*n*k));
+  BLOCKVECTORTEST_ASSERT(x == Vector(n, FieldVector<K,k>(2)) && (n == 0 || x != y));
+
+  // NaN entries propagate to the maximum norm
+  if (n > 0) {
+    x[n/2][k-1] = std::numeric_limits<K>::quiet_NaN();
+    BLOCKVECTORTEST_ASSERT(std::isnan(x.infinity_norm()));
+    BLOCKVECTORTEST_ASSERT(std::isnan(x.infinity_norm_real()));
+  }
+}
+
+// integer blocks have exact reductions on both paths
+void testIntegerBlocks ()
+{
+  typedef BlockVector<FieldVector<int,2> > Vector;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  Vector x = {{ 1, -2 }, { 3, 4 }, { -5, 6 }};
+  const Vector y(3, FieldVector<int,2>(1));
+  BLOCKVECTORTEST_ASSERT(x.dot(y) == 7 && x * y == 7);
+  BLOCKVECTORTEST_ASSERT(x.one_norm() == 21 && x.two_norm2() == 91);
+  BLOCKVECTORTEST_ASSERT(x.infinity_norm() == 6);
+  x.axpy(2, y);
+  BLOCKVECTORTEST_ASSERT((x == Vector{{ 3, 0 }, { 5, 6 }, { -3, 8 }}));
+}
+
+// complex blocks recurse through Dune::dot, which conjugates the first argument
+void testComplexBlocks ()
+{
+  typedef std::complex<double> C;
+  typedef BlockVector<FieldVector<C,2> > Vector;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  const Vector x = {{ C(1,1), C(0,2) }, { C(3,0), C(0,-1) }};
+  const Vector y = {{ C(1,0), C(1,0) }, { C(0,1), C(2,0) }};
+  BLOCKVECTORTEST_ASSERT(x.dot(y) == C(1,-3) + C(0,3) + C(0,2));
+  BLOCKVECTORTEST_ASSERT(x * y == C(1,1) + C(0,2) + C(0,3) + C(0,-2));
+  BLOCKVECTORTEST_ASSERT(x.two_norm2() == 16.0);
+  BLOCKVECTORTEST_ASSERT(x.infinity_norm() == 3.0);
+  BLOCKVECTORTEST_ASSERT(x.one_norm_real() == 8.0);
+}
+
+// scalar blocks use the absolute values of the entries
+void testScalarBlocks ()
+{
+  typedef BlockVector<double> Vector;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  Vector x = { 1.0, -2.0, 3.0 };
+  const Vector y(3, 1.0);
+  BLOCKVECTORTEST_ASSERT(x.dim() == 3 && x.dot(y) == 2.0 && x * y == 2.0);
+  BLOCKVECTORTEST_ASSERT(x.one_norm() == 6.0 && x.one_norm_real() == 6.0);
+  BLOCKVECTORTEST_ASSERT(x.two_norm2() == 14.0);
+  BLOCKVECTORTEST_ASSERT(x.infinity_norm() == 3.0 && x.infinity_norm_real() == 3.0);
+  x.axpy(2.0, y);
+  BLOCKVECTORTEST_ASSERT((x == Vector{ 3.0, 0.0, 5.0 }));
+
+  typedef std::complex<double> C;
+  const BlockVector<C> z = { C(3,-4), C(0,1) };
+  BLOCKVECTORTEST_ASSERT(z.one_norm() == 6.0 && z.one_norm_real() == 8.0);
+  BLOCKVECTORTEST_ASSERT(z.two_norm2() == 26.0);
+  BLOCKVECTORTEST_ASSERT(z.infinity_norm() == 5.0 && z.infinity_norm_real() == 7.0);
+}
+
+// blocks of blocks recurse twice
+void testNestedBlocks ()
+{
+  typedef BlockVector<BlockVector<FieldVector<double,2> > > Vector;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  Vector x(3);
+  for (std::size_t i = 0; i < x.size(); ++i)
+    x[i].resize(i+1);
+  x = 1.0;
+  BLOCKVECTORTEST_ASSERT(x.dim() == 12 && x.two_norm2() == 12.0 && x.one_norm() == 12.0);
+  Vector y = x;
+  y[2][1][0] = -4.0;
+  BLOCKVECTORTEST_ASSERT(y.infinity_norm() == 4.0 && x.dot(y) == 7.0);
+  x.axpy(2.0, y);
+  BLOCKVECTORTEST_ASSERT(x[2][1][0] == -7.0 && x[0][0][1] == 3.0);
+
+  std::ostringstream s;
+  s << x[0];
+  BLOCKVECTORTEST_ASSERT(!s.str().empty());
+}
+
+int main()
+{
+  testFlatKernels<double,1>(17);
+  testFlatKernels<double,3>(1000);
+  testFlatKernels<double,4>(5);
+  testFlatKernels<float,3>(333);
+  testFlatKernels<double,3>(0);
+
+  testIntegerBlocks();
+  testComplexBlocks();
+  testScalarBlocks();
+  testNestedBlocks();
+
+  return 0;
+}
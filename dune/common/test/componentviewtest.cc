@@ -0,0 +1,216 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/blockvector.hh>
+#include <dune/common/classname.hh>
+#include <dune/common/componentview.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/summation.hh>
+
+struct ComponentViewTestException : Dune::Exception {};
+
+#define COMPONENTVIEWTEST_ASSERT(EXPR)                      \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(ComponentViewTestException,                  \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::ComponentView;
+using Dune::DynamicVector;
+using Dune::FieldVector;
+
+static_assert(std::is_same<std::iterator_traits<Dune::StridedIterator<double,3> >::iterator_category,
+                           std::random_access_iterator_tag>::value, "");
+static_assert(std::is_convertible<Dune::StridedIterator<double,3>, Dune::StridedIterator<const double,3> >::value, "");
+static_assert(!std::is_convertible<Dune::StridedIterator<const double,3>, Dune::StridedIterator<double,3> >::value, "");
+static_assert(std::is_same<decltype(Dune::component(std::declval<const std::vector<FieldVector<float,2> >&>(), 0)),
+                           ComponentView<const float,2> >::value, "");
+
+template<class K>
+bool close (K a, K b)
+{
+  using std::abs;
+  using std::max;
+  typedef typename Dune::FieldTraits<K>::real_type real_type;
+  return abs(a - b) <= 64 * std::numeric_limits<real_type>::epsilon() * max(abs(a), abs(b));
+}
+
+template<class K, int n>
+std::vector<FieldVector<K,n> > makeBlocks (std::size_t size)
+{
+  std::vector<FieldVector<K,n> > v(size);
+  for (std::size_t i = 0; i < size; ++i)
+    for (int j = 0; j < n; ++j)
+      v[i][j] = K(std::sin(0.37*(n*i + j) + 1) * (1 + (i + j) % 13));
+  return v;
+}
+
+// the views agree with DynamicVectors holding a copy of the component
+template<class K, int n>
+void testComponents (std::size_t size)
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << ", " << n << " )" << std::endl;
+
+  auto v = makeBlocks<K,n>(size);
+  for (int j = 0; j < n; ++j) {
+    auto x = Dune::component(v, j);
+    auto y = Dune::component(v, n-1-j);
+    DynamicVector<K> u(size), w(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      u[i] = v[i][j];
+      w[i] = v[i][n-1-j];
+    }
+
+    COMPONENTVIEWTEST_ASSERT(x.size() == size && x.component() == std::size_t(j));
+    COMPONENTVIEWTEST_ASSERT(x == u);
+    COMPONENTVIEWTEST_ASSERT(close(x.two_norm2(), u.two_norm2()));
+    COMPONENTVIEWTEST_ASSERT(close(x.two_norm(), u.two_norm()));
+    COMPONENTVIEWTEST_ASSERT(close(x.one_norm(), u.one_norm()));
+    COMPONENTVIEWTEST_ASSERT(close(x.one_norm_real(), u.one_norm_real()));
+    COMPONENTVIEWTEST_ASSERT(x.infinity_norm() == u.infinity_norm());
+    COMPONENTVIEWTEST_ASSERT(x.infinity_norm_real() == u.infinity_norm_real());
+    COMPONENTVIEWTEST_ASSERT(close(x * y, u * w));
+    COMPONENTVIEWTEST_ASSERT(close(x.dot(y), u.dot(w)));
+    COMPONENTVIEWTEST_ASSERT(close(x.dot(w), u.dot(w)));
+
+    // the summation methods of DenseVector are not hidden
+    COMPONENTVIEWTEST_ASSERT(x.template two_norm2<Dune::Summation::Compensated>()
+                             == u.template two_norm2<Dune::Summation::Compensated>());
+    COMPONENTVIEWTEST_ASSERT(x.template two_norm<Dune::Summation::Compensated>()
+                             == u.template two_norm<Dune::Summation::Compensated>());
+    COMPONENTVIEWTEST_ASSERT(x.template dot<Dune::Summation::Compensated>(y)
+                             == u.template dot<Dune::Summation::Compensated>(w));
+
+    // standard algorithms on the iterators
+    COMPONENTVIEWTEST_ASSERT(std::distance(x.begin(), x.end()) == std::ptrdiff_t(size));
+    COMPONENTVIEWTEST_ASSERT(std::equal(x.begin(), x.end(), u.begin()));
+    if (size > 0) {
+      auto minmax = std::minmax_element(x.begin(), x.end());
+      COMPONENTVIEWTEST_ASSERT(*minmax.first == *std::min_element(u.begin(), u.end()));
+      COMPONENTVIEWTEST_ASSERT(*minmax.second == *std::max_element(u.begin(), u.end()));
+      COMPONENTVIEWTEST_ASSERT(&*minmax.second == &v[minmax.second - x.begin()][j]);
+      COMPONENTVIEWTEST_ASSERT(x.begin()[size-1] == u[size-1]);
+      COMPONENTVIEWTEST_ASSERT(*(x.end() - 1) == u[size-1]);
+    }
+
+    // the binary arithmetic returns owning vectors
+    auto sum = x + y;
+    static_assert(std::is_same<decltype(sum), DynamicVector<K> >::value, "");
+    COMPONENTVIEWTEST_ASSERT(sum == u + w);
+    COMPONENTVIEWTEST_ASSERT(-x == -u);
+    COMPONENTVIEWTEST_ASSERT(x == u);
+  }
+
+  // transforms write to the blocks and leave the other components alone
+  const auto v0 = v;
+  auto x = Dune::component(v, n-1);
+  std::transform(x.begin(), x.end(), x.begin(), [](K xi) { return 2*xi; });
+  x *= K(3);
+  for (std::size_t i = 0; i < size; ++i) {
+    COMPONENTVIEWTEST_ASSERT(v[i][n-1] == K(3)*(K(2)*v0[i][n-1]));
+    for (int j = 0; j + 1 < n; ++j)
+      COMPONENTVIEWTEST_ASSERT(v[i][j] == v0[i][j]);
+  }
+
+  std::sort(x.begin(), x.end());
+  COMPONENTVIEWTEST_ASSERT(std::is_sorted(x.begin(), x.end()));
+  std::reverse(x.begin(), x.end());
+  COMPONENTVIEWTEST_ASSERT(std::is_sorted(x.begin(), x.end(), std::greater<K>()));
+}
+
+// assignments between the components of the same array
+void testAssignment ()
+{
+  std::cout << __func__ << std::endl;
+
+  auto v = makeBlocks<double,3>(10);
+  const auto v0 = v;
+  Dune::component(v, 0) = Dune::component(v, 2);
+  Dune::component(v, 2) = Dune::component(v, 1);
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    COMPONENTVIEWTEST_ASSERT(v[i][0] == v0[i][2]);
+    COMPONENTVIEWTEST_ASSERT(v[i][2] == v0[i][1]);
+  }
+
+  // views of overlapping blocks are assigned as if through a copy
+  std::vector<double> a(30);
+  std::iota(a.begin(), a.end(), 0.0);
+  ComponentView<double,3> front(a.data(), 9, 0), back(a.data() + 3, 9, 0);
+  back = front;
+  COMPONENTVIEWTEST_ASSERT(a[3] == 0 && a[6] == 3 && a[27] == 24);
+  std::iota(a.begin(), a.end(), 0.0);
+  front = back;
+  COMPONENTVIEWTEST_ASSERT(a[0] == 3 && a[3] == 6 && a[24] == 27);
+
+  Dune::component(v, 1) = 0.5;
+  for (const auto& vi : v)
+    COMPONENTVIEWTEST_ASSERT(vi[1] == 0.5);
+}
+
+// views of BlockVectors, of const arrays and of complex entries
+void testOtherArrays ()
+{
+  std::cout << __func__ << std::endl;
+
+  Dune::BlockVector<FieldVector<double,2> > b = { { 1, -7 }, { 3, 4 }, { -5, 0 } };
+  auto y = Dune::component(b, 1);
+  COMPONENTVIEWTEST_ASSERT(y.infinity_norm() == 7 && y.one_norm() == 11);
+  y.axpy(2.0, Dune::component(b, 0));
+  COMPONENTVIEWTEST_ASSERT(b[0][1] == -5 && b[1][1] == 10 && b[2][1] == -10);
+
+  const auto& cb = b;
+  ComponentView<const double,2> x = Dune::component(cb, 0);
+  COMPONENTVIEWTEST_ASSERT(x.two_norm2() == 35);
+  ComponentView<const double,2> z = y;
+  COMPONENTVIEWTEST_ASSERT(z[2] == -10);
+  double sum = 0;
+  for (const auto& zi : z)
+    sum += zi;
+  COMPONENTVIEWTEST_ASSERT(sum == -5);
+
+  // infinity_norm propagates NaNs
+  b[1][0] = std::numeric_limits<double>::quiet_NaN();
+  COMPONENTVIEWTEST_ASSERT(std::isnan(x.infinity_norm()));
+
+  std::vector<FieldVector<std::complex<double>,2> > c(3, { { 1, 1 }, { 0, 2 } });
+  auto cx = Dune::component(c, 1);
+  COMPONENTVIEWTEST_ASSERT(cx.two_norm2() == 12);
+  COMPONENTVIEWTEST_ASSERT(cx.dot(cx) == 12.0);
+  COMPONENTVIEWTEST_ASSERT(cx.one_norm<Dune::ComplexAbs::Fast>() == 6);
+  COMPONENTVIEWTEST_ASSERT(cx.two_norm2<Dune::Summation::Compensated>() == 12);
+
+  // empty views
+  std::vector<FieldVector<float,3> > e;
+  auto ex = Dune::component(e, 2);
+  COMPONENTVIEWTEST_ASSERT(ex.size() == 0 && ex.two_norm() == 0 && ex.begin() == ex.end());
+}
+
+int main()
+{
+  testComponents<double,3>(1000);
+  testComponents<double,1>(17);
+  testComponents<float,4>(333);
+  testComponents<double,2>(0);
+  testComponents<int,3>(50);
+
+  testAssignment();
+  testOtherArrays();
+
+  return 0;
+}
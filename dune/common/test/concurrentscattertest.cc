@@ -0,0 +1,181 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <dune/common/classname.hh>
+#include <dune/common/concurrentscatter.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/gatherscatter.hh>
+#include <dune/common/parallelfor.hh>
+
+struct ConcurrentScatterTestException : Dune::Exception {};
+
+#define CONCURRENTSCATTERTEST_ASSERT(EXPR)                  \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(ConcurrentScatterTestException,              \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::FieldVector;
+
+// the quadrilaterals of a structured nx x ny mesh with their four vertices
+struct Mesh
+{
+  Mesh (std::size_t nx, std::size_t ny)
+    : vertices((nx+1)*(ny+1))
+  {
+    for (std::size_t j = 0; j < ny; ++j)
+      for (std::size_t i = 0; i < nx; ++i) {
+        const int v = int(j*(nx+1) + i);
+        elements.push_back({ v, v+1, v+int(nx)+1, v+int(nx)+2 });
+      }
+  }
+
+  std::size_t vertices;
+  std::vector<std::array<int,4> > elements;
+};
+
+// contributions with integer values, whose sums are exact in any order
+template<class B>
+FieldVector<B,4> contribution (std::size_t e)
+{
+  FieldVector<B,4> local;
+  for (int k = 0; k < 4; ++k)
+    local[k] = B(int((e*7 + k) % 11) - 5);
+  return local;
+}
+
+template<class B, class Strategy>
+void testStrategy (const Strategy& strategy, const Mesh& mesh, const Dune::ParallelOptions& options)
+{
+  std::cout << __func__ << "\t ( " << Dune::className<Strategy>() << ", "
+            << Dune::className<B>() << " )" << std::endl;
+
+  auto indices = [&] (std::size_t e) -> const std::array<int,4>& { return mesh.elements[e]; };
+  auto local = [] (std::size_t e) { return contribution<B>(e); };
+
+  std::vector<B> expected(mesh.vertices, B(1));
+  for (std::size_t e = 0; e < mesh.elements.size(); ++e)
+    Dune::scatterAdd(expected, indices(e), local(e));
+
+  // twice, to add to the values of the first assembly
+  std::vector<B> global(mesh.vertices, B(1));
+  Dune::parallelScatterAdd(strategy, global, mesh.elements.size(), indices, local, options);
+  Dune::parallelScatterAdd(strategy, global, mesh.elements.size(), indices, local, options);
+  for (std::size_t i = 0; i < mesh.vertices; ++i)
+    CONCURRENTSCATTERTEST_ASSERT(global[i] + B(1) == expected[i] + expected[i]);
+}
+
+// the coloring partitions the elements into colors without common indices
+void testColoring (const Mesh& mesh)
+{
+  std::cout << __func__ << std::endl;
+
+  auto indices = [&] (std::size_t e) -> const std::array<int,4>& { return mesh.elements[e]; };
+  Dune::ElementColoring coloring(mesh.elements.size(), mesh.vertices, indices);
+
+  // a structured quadrilateral mesh needs four colors
+  CONCURRENTSCATTERTEST_ASSERT(coloring.colors() == 4);
+
+  std::vector<int> colored(mesh.elements.size(), 0);
+  for (std::size_t c = 0; c < coloring.colors(); ++c) {
+    std::vector<int> touched(mesh.vertices, 0);
+    for (auto it = coloring.colorBegin(c); it != coloring.colorEnd(c); ++it) {
+      CONCURRENTSCATTERTEST_ASSERT(it == coloring.colorBegin(c) || *(it-1) < *it);
+      ++colored[*it];
+      for (int v : mesh.elements[*it])
+        CONCURRENTSCATTERTEST_ASSERT(++touched[v] == 1);
+    }
+  }
+  for (int n : colored)
+    CONCURRENTSCATTERTEST_ASSERT(n == 1);
+
+  // elements sharing one index need as many colors, beyond the 64 of one pass
+  const std::size_t n = 150;
+  std::vector<std::array<int,2> > star(n);
+  for (std::size_t e = 0; e < n; ++e)
+    star[e] = { 0, int(e+1) };
+  Dune::ElementColoring starColoring(n, n+1, [&] (std::size_t e) -> const std::array<int,2>& { return star[e]; });
+  CONCURRENTSCATTERTEST_ASSERT(starColoring.colors() == n);
+  for (std::size_t c = 0; c < n; ++c)
+    CONCURRENTSCATTERTEST_ASSERT(starColoring.colorEnd(c) - starColoring.colorBegin(c) == 1
+                                 && *starColoring.colorBegin(c) == c);
+
+  Dune::ElementColoring empty(0, 10, indices);
+  CONCURRENTSCATTERTEST_ASSERT(empty.colors() == 0);
+}
+
+// atomic adds of the entry types
+void testAtomicAdd ()
+{
+  std::cout << __func__ << std::endl;
+
+  const std::size_t n = 100000;
+  double x = 0;
+  long i = 0;
+  std::complex<float> z = 0;
+  FieldVector<double,3> v(0);
+  Dune::parallelFor(std::size_t(0), n, [&] (std::size_t) {
+      Dune::atomicAdd(x, 0.5);
+      Dune::atomicAdd(i, 2l);
+      Dune::atomicAdd(z, std::complex<float>(1, -1));
+      Dune::atomicAdd(v, FieldVector<double,3>{ 1, 2, 3 });
+    });
+  CONCURRENTSCATTERTEST_ASSERT(x == 0.5*n && i == 2*long(n));
+  CONCURRENTSCATTERTEST_ASSERT(z == std::complex<float>(n, -float(n)));
+  CONCURRENTSCATTERTEST_ASSERT((v == FieldVector<double,3>{ 1.0*n, 2.0*n, 3.0*n }));
+}
+
+// the buffers are zeroed by the reduction and can be reused
+void testScatterBuffers ()
+{
+  std::cout << __func__ << std::endl;
+
+  Dune::ScatterBuffers<FieldVector<double,2> > buffers(5);
+  CONCURRENTSCATTERTEST_ASSERT(buffers.size() == 5);
+
+  std::vector<FieldVector<double,2> > global(5, FieldVector<double,2>(0));
+  buffers.reduceInto(global);
+  CONCURRENTSCATTERTEST_ASSERT(global[0].two_norm() == 0);
+
+  const std::array<int,2> indices = { 4, 1 };
+  const std::array<FieldVector<double,2>,2> local = {{ { 1, 2 }, { 3, 4 } }};
+  Dune::parallelFor(0, 1000, [&] (int) { buffers.scatterAdd(indices, local); });
+  buffers.reduceInto(global);
+  buffers.reduceInto(global);
+  CONCURRENTSCATTERTEST_ASSERT((global[4] == FieldVector<double,2>{ 1000, 2000 }));
+  CONCURRENTSCATTERTEST_ASSERT((global[1] == FieldVector<double,2>{ 3000, 4000 }));
+  CONCURRENTSCATTERTEST_ASSERT(global[0].two_norm() == 0 && global[2].two_norm() == 0 && global[3].two_norm() == 0);
+}
+
+int main()
+{
+  const Mesh mesh(60, 40);
+  const Dune::ElementColoring coloring(mesh.elements.size(), mesh.vertices,
+                                       [&] (std::size_t e) -> const std::array<int,4>& { return mesh.elements[e]; });
+  for (auto options : { Dune::ParallelOptions{}, Dune::ParallelOptions{ 1, 4 } }) {
+    testStrategy<double>(Dune::ConcurrentScatter::Atomic{}, mesh, options);
+    testStrategy<double>(Dune::ConcurrentScatter::PrivateBuffers{}, mesh, options);
+    testStrategy<double>(coloring, mesh, options);
+    testStrategy<FieldVector<double,3> >(Dune::ConcurrentScatter::Atomic{}, mesh, options);
+    testStrategy<FieldVector<float,2> >(Dune::ConcurrentScatter::PrivateBuffers{}, mesh, options);
+    testStrategy<FieldVector<double,3> >(coloring, mesh, options);
+    testStrategy<int>(Dune::ConcurrentScatter::Atomic{}, mesh, options);
+  }
+
+  testColoring(mesh);
+  testAtomicAdd();
+  testScatterBuffers();
+
+  return 0;
+}
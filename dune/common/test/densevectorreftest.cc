@@ -0,0 +1,196 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <complex>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/classname.hh>
+#include <dune/common/densevectorref.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/fvectorref.hh>
+
+struct DenseVectorRefTestException : Dune::Exception {};
+
+#define DENSEVECTORREFTEST_ASSERT(EXPR)                     \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(DenseVectorRefTestException,                 \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::DenseVectorRef;
+using Dune::DynamicVector;
+using Dune::FieldVector;
+
+static_assert(std::is_same<Dune::DenseMatVecTraits<DenseVectorRef<const float> >::value_type,
+                           const float>::value, "");
+static_assert(std::is_same<Dune::FieldTraits<DenseVectorRef<std::complex<double> > >::real_type,
+                           double>::value, "");
+static_assert(std::is_convertible<FieldVector<double,3>&, DenseVectorRef<double> >::value, "");
+static_assert(std::is_convertible<const DynamicVector<double>&, DenseVectorRef<const double> >::value, "");
+static_assert(std::is_convertible<Dune::FieldVectorRef<double,3>, DenseVectorRef<double> >::value, "");
+static_assert(!std::is_convertible<const DynamicVector<double>&, DenseVectorRef<double> >::value, "");
+static_assert(!std::is_convertible<DenseVectorRef<const double>, DenseVectorRef<double> >::value, "");
+static_assert(!std::is_constructible<DenseVectorRef<double>, std::vector<double>&>::value, "");
+
+template<class K>
+std::vector<K> makeBuffer (std::size_t n)
+{
+  std::vector<K> buffer(n);
+  for (std::size_t i = 0; i < n; ++i)
+    buffer[i] = K(i + 1);
+  return buffer;
+}
+
+// views of contiguous memory behave like the DynamicVectors owning a copy of it
+template<class K>
+void testContiguous (std::size_t n)
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << " )" << std::endl;
+
+  auto buffer = makeBuffer<K>(2*n);
+  DenseVectorRef<K> x(buffer.data(), n);
+  DenseVectorRef<K> y(buffer.data() + n, n);
+  DynamicVector<K> u(x), v(y);
+
+  DENSEVECTORREFTEST_ASSERT(x.size() == n && x.stride() == 1);
+  DENSEVECTORREFTEST_ASSERT(x == u && y == v);
+  DENSEVECTORREFTEST_ASSERT(x.dot(y) == u.dot(v));
+  DENSEVECTORREFTEST_ASSERT(x * y == u * v);
+  DENSEVECTORREFTEST_ASSERT(x.one_norm() == u.one_norm());
+  DENSEVECTORREFTEST_ASSERT(x.two_norm() == u.two_norm());
+  DENSEVECTORREFTEST_ASSERT(x.infinity_norm() == u.infinity_norm());
+
+  auto sum = x + y;
+  auto diff = x - v;
+  auto neg = -x;
+  static_assert(std::is_same<decltype(sum), DynamicVector<K> >::value, "");
+  DENSEVECTORREFTEST_ASSERT(sum == u + v);
+  DENSEVECTORREFTEST_ASSERT(diff == u - v);
+  DENSEVECTORREFTEST_ASSERT(neg == -u);
+  DENSEVECTORREFTEST_ASSERT(x == u);
+
+  // writes go to the buffer
+  x.axpy(K(2), y);
+  u.axpy(K(2), v);
+  x *= K(3);
+  u *= K(3);
+  x -= K(1);
+  u -= K(1);
+  for (std::size_t i = 0; i < n; ++i)
+    DENSEVECTORREFTEST_ASSERT(buffer[i] == u[i]);
+  DENSEVECTORREFTEST_ASSERT(y == v);
+
+  // assignment copies values into the buffer
+  x = y;
+  DENSEVECTORREFTEST_ASSERT(x == v && x.data() == buffer.data());
+  x = K(0);
+  DENSEVECTORREFTEST_ASSERT(x.two_norm2() == 0 && y == v);
+
+  int i = 0;
+  for (auto& xi : x)
+    xi = K(++i);
+  DENSEVECTORREFTEST_ASSERT(n == 0 || buffer[n-1] == K(n));
+}
+
+// views with a stride, e.g. of a column of a row-major array
+template<class K>
+void testStrided ()
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << " )" << std::endl;
+
+  // a 4x3 row-major array
+  auto buffer = makeBuffer<K>(12);
+  DenseVectorRef<K> column(buffer.data() + 1, 4, 3);
+  DenseVectorRef<const K> row(buffer.data() + 3, 3);
+  const DynamicVector<K> c = { 2, 5, 8, 11 };
+
+  DENSEVECTORREFTEST_ASSERT(column == c);
+  DENSEVECTORREFTEST_ASSERT(column.two_norm2() == c.two_norm2());
+  DENSEVECTORREFTEST_ASSERT(column.stride() == 3);
+
+  column *= K(2);
+  DENSEVECTORREFTEST_ASSERT(buffer[1] == K(4) && buffer[10] == K(22));
+  DENSEVECTORREFTEST_ASSERT(buffer[0] == K(1) && buffer[11] == K(12));
+  DENSEVECTORREFTEST_ASSERT(row[1] == K(10));
+
+  // the first and last column overlap with no entry of each other
+  DenseVectorRef<K> first(buffer.data(), 4, 3), last(buffer.data() + 2, 4, 3);
+  last = first;
+  DENSEVECTORREFTEST_ASSERT(buffer[2] == K(1) && buffer[11] == K(10));
+
+  // overlapping views are assigned as if through a copy
+  for (std::size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = K(i + 1);
+  DenseVectorRef<K> front(buffer.data(), 5, 2), back(buffer.data() + 2, 5, 2);
+  back = front;
+  DENSEVECTORREFTEST_ASSERT(buffer[2] == K(1) && buffer[4] == K(3) && buffer[10] == K(9));
+
+  // also if the source is a read-only view
+  for (std::size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = K(i + 1);
+  DenseVectorRef<const K> constFront(front);
+  back = constFront;
+  DENSEVECTORREFTEST_ASSERT(buffer[2] == K(1) && buffer[4] == K(3) && buffer[10] == K(9));
+
+  // read-only views of mutable ones keep the stride
+  DenseVectorRef<const K> view(column);
+  DENSEVECTORREFTEST_ASSERT(view.stride() == 3 && view[3] == buffer[10]);
+
+  K sum = 0;
+  for (const auto& ci : view)
+    sum += ci;
+  DENSEVECTORREFTEST_ASSERT(sum == buffer[1] + buffer[4] + buffer[7] + buffer[10]);
+}
+
+// views of the entries of vectors
+void testVectorViews ()
+{
+  std::cout << __func__ << std::endl;
+
+  FieldVector<double,4> x = { 1, 2, 3, 4 };
+  DenseVectorRef<double> vx(x);
+  vx[3] = 5;
+  DENSEVECTORREFTEST_ASSERT(x[3] == 5 && vx.size() == 4);
+
+  const DynamicVector<double> y = { 1, 1, 1, 1 };
+  DenseVectorRef<const double> vy(y);
+  vx += vy;
+  DENSEVECTORREFTEST_ASSERT((x == FieldVector<double,4>{ 2, 3, 4, 6 }));
+
+  DenseVectorRef<double> tail(Dune::tail<2>(x));
+  tail = 0.0;
+  DENSEVECTORREFTEST_ASSERT((x == FieldVector<double,4>{ 2, 3, 0, 0 }));
+
+  // an empty view
+  DenseVectorRef<double> empty;
+  DENSEVECTORREFTEST_ASSERT(empty.size() == 0 && empty.two_norm() == 0);
+
+  // compile-time sized views of external memory
+  double buffer[] = { 3, 4 };
+  Dune::FieldVectorRef<double,2> fixed(buffer);
+  DENSEVECTORREFTEST_ASSERT(fixed.two_norm() == 5);
+}
+
+int main()
+{
+  testContiguous<double>(17);
+  testContiguous<float>(100);
+  testContiguous<int>(5);
+  testContiguous<std::complex<double> >(9);
+  testContiguous<double>(0);
+
+  testStrided<double>();
+  testStrided<int>();
+
+  testVectorViews();
+
+  return 0;
+}
@@ -0,0 +1,211 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <dune/common/classname.hh>
+#include <dune/common/doubledouble.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/math.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+struct DoubleDoubleTestException : Dune::Exception {};
+
+#define DOUBLEDOUBLETEST_ASSERT(EXPR)                       \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(DoubleDoubleTestException,                   \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::DoubleDouble;
+
+static_assert(Dune::IsNumber<DoubleDouble>::value, "");
+static_assert(Dune::HasNaN<DoubleDouble>::value, "");
+static_assert(std::is_same<Dune::FieldTraits<DoubleDouble>::real_type, DoubleDouble>::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<DoubleDouble, double>::PromotedType, DoubleDouble>::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<int, DoubleDouble>::PromotedType, DoubleDouble>::value, "");
+static_assert(std::numeric_limits<DoubleDouble>::digits == 106, "");
+
+// whether x agrees with y up to a relative error of k*epsilon
+bool close (const DoubleDouble& x, const DoubleDouble& y, double k = 4)
+{
+  const DoubleDouble eps = std::numeric_limits<DoubleDouble>::epsilon();
+  return abs(x - y) <= k * eps * abs(y);
+}
+
+void testArithmetic ()
+{
+  std::cout << __func__ << std::endl;
+
+  // the sum keeps the bits below the precision of double
+  const double tiny = std::ldexp(1.0, -80);
+  DoubleDouble x = DoubleDouble(1.0) + tiny;
+  DOUBLEDOUBLETEST_ASSERT(x.hi() == 1.0 && x.lo() == tiny);
+  DOUBLEDOUBLETEST_ASSERT(x - 1.0 == DoubleDouble(tiny));
+  DOUBLEDOUBLETEST_ASSERT(x > DoubleDouble(1.0) && 1.0 < x && x != 1.0);
+  DOUBLEDOUBLETEST_ASSERT(-x < -1.0 && x >= x && x <= x);
+
+  // exact products of doubles
+  const double a = 1.0 + std::ldexp(1.0, -30);
+  DoubleDouble p = DoubleDouble(a) * a;
+  DOUBLEDOUBLETEST_ASSERT(p.hi() == 1.0 + std::ldexp(1.0, -29) && p.lo() == std::ldexp(1.0, -60));
+
+  // division and multiplication are inverse up to rounding
+  const DoubleDouble third = DoubleDouble(1.0) / 3.0;
+  DOUBLEDOUBLETEST_ASSERT(close(third * 3.0, 1.0));
+  DOUBLEDOUBLETEST_ASSERT(close(third, DoubleDouble(1) / DoubleDouble(3)));
+  DOUBLEDOUBLETEST_ASSERT(close(7.0 / DoubleDouble(7.0), 1.0));
+
+  DoubleDouble y = 2;
+  y += third;
+  y -= 2.0;
+  y *= DoubleDouble(3.0);
+  y /= 2;
+  DOUBLEDOUBLETEST_ASSERT(close(y, 0.5));
+
+  // integers beyond the range of exact doubles
+  const long long big = (1LL << 60) + 1;
+  DOUBLEDOUBLETEST_ASSERT(DoubleDouble(big) - double(1LL << 60) == 1.0);
+}
+
+void testMath ()
+{
+  std::cout << __func__ << std::endl;
+
+  const DoubleDouble two = 2.0;
+  const DoubleDouble r = sqrt(two);
+  DOUBLEDOUBLETEST_ASSERT(close(r*r, two));
+  DOUBLEDOUBLETEST_ASSERT(sqrt(DoubleDouble(169.0)) == 13.0);
+  DOUBLEDOUBLETEST_ASSERT(sqrt(DoubleDouble(0.0)) == 0.0);
+  DOUBLEDOUBLETEST_ASSERT(isnan(sqrt(DoubleDouble(-1.0))));
+  DOUBLEDOUBLETEST_ASSERT(abs(-r) == r && abs(r) == r);
+
+  const DoubleDouble inf = std::numeric_limits<DoubleDouble>::infinity();
+  DOUBLEDOUBLETEST_ASSERT(isinf(inf) && !isfinite(inf) && isinf(sqrt(inf)));
+  DOUBLEDOUBLETEST_ASSERT(isnan(std::numeric_limits<DoubleDouble>::quiet_NaN()));
+  DOUBLEDOUBLETEST_ASSERT(isfinite(std::numeric_limits<DoubleDouble>::max()));
+  DOUBLEDOUBLETEST_ASSERT(std::numeric_limits<DoubleDouble>::lowest() == -std::numeric_limits<DoubleDouble>::max());
+
+  const DoubleDouble eps = std::numeric_limits<DoubleDouble>::epsilon();
+  DOUBLEDOUBLETEST_ASSERT(DoubleDouble(1.0) + eps > 1.0);
+  DOUBLEDOUBLETEST_ASSERT(eps == std::numeric_limits<double>::epsilon() * std::numeric_limits<double>::epsilon());
+
+  // the constants are more accurate than those of double
+  const DoubleDouble pi = Dune::MathematicalConstants<DoubleDouble>::pi();
+  DOUBLEDOUBLETEST_ASSERT(pi.hi() == M_PI && pi.lo() != 0.0);
+  DOUBLEDOUBLETEST_ASSERT(close(Dune::power(two, 100), std::ldexp(1.0, 100), 0));
+}
+
+// the output agrees with that of double for values which are exact doubles,
+// as long as at most 33 significant digits are printed
+void testOutput ()
+{
+  std::cout << __func__ << std::endl;
+
+  const double values[] = { 1.0, 1.0/3.0, -0.1, 2e5/3.0, 7e-7, 6.02214076e23, 1e300/3.0,
+                            100000.0, 999999.7, -123.456, 0.000123 };
+  for (double v : values)
+    for (int format = 0; format < 3; ++format)
+      for (int precision = 0; precision < 13; ++precision) {
+        if (format == 1 && std::abs(v) > 1e15)
+          continue;
+        std::ostringstream ds, dds;
+        for (std::ostringstream* s : { &ds, &dds }) {
+          if (format == 1)
+            *s << std::fixed;
+          if (format == 2)
+            *s << std::scientific;
+          *s << std::setprecision(precision);
+        }
+        ds << v;
+        dds << DoubleDouble(v);
+        if (ds.str() != dds.str())
+          DUNE_THROW(DoubleDoubleTestException, "DoubleDouble printed as " << dds.str()
+                     << " instead of " << ds.str());
+      }
+
+  // all 32 significant digits
+  std::ostringstream s;
+  s << std::setprecision(32) << Dune::MathematicalConstants<DoubleDouble>::pi();
+  DOUBLEDOUBLETEST_ASSERT(s.str() == "3.1415926535897932384626433832795");
+  s.str("");
+  s << std::setprecision(32) << DoubleDouble(1.0) / 3.0;
+  DOUBLEDOUBLETEST_ASSERT(s.str() == "0.33333333333333333333333333333333");
+}
+
+void testInput ()
+{
+  std::cout << __func__ << std::endl;
+
+  DoubleDouble x;
+  std::istringstream s("0.1 -2.5e-3 3.1415926535897932384626433832795028 inf junk");
+  s >> x;
+  DOUBLEDOUBLETEST_ASSERT(close(x * 10.0, 1.0));
+  DOUBLEDOUBLETEST_ASSERT(x.lo() != 0.0);
+  s >> x;
+  DOUBLEDOUBLETEST_ASSERT(close(x * -400.0, 1.0));
+  s >> x;
+  DOUBLEDOUBLETEST_ASSERT(close(x, Dune::MathematicalConstants<DoubleDouble>::pi()));
+  s >> x;
+  DOUBLEDOUBLETEST_ASSERT(isinf(x));
+  s >> x;
+  DOUBLEDOUBLETEST_ASSERT(s.fail() && isinf(x));
+
+  // round trip with 33 digits
+  const DoubleDouble y = DoubleDouble(2.0) / 3e-20;
+  std::stringstream t;
+  t << std::setprecision(33) << y;
+  DoubleDouble z;
+  t >> z;
+  DOUBLEDOUBLETEST_ASSERT(close(z, y));
+}
+
+template<class Vector>
+void testVector (Vector x)
+{
+  std::cout << __func__ << "\t ( " << Dune::className(x) << " )" << std::endl;
+
+  // the plain reductions cancel exactly in double-double
+  x[0] = 1e16;
+  x[1] = 1.0;
+  x[2] = -1e16;
+  Vector y(x);
+  y = 1.0;
+  DOUBLEDOUBLETEST_ASSERT(x.dot(y) == 1.0);
+  DOUBLEDOUBLETEST_ASSERT(x.one_norm() == DoubleDouble(2e16) + 1.0);
+  DOUBLEDOUBLETEST_ASSERT(x.infinity_norm() == 1e16);
+
+  x[0] = 3.0;
+  x[1] = 4.0;
+  x[2] = 12.0;
+  DOUBLEDOUBLETEST_ASSERT(x.two_norm() == 13.0);
+  x *= DoubleDouble(1.0) / 3.0;
+  x.axpy(-1.0, y);
+  DOUBLEDOUBLETEST_ASSERT(close(x[2], 3.0));
+  DOUBLEDOUBLETEST_ASSERT(x != y && x == x);
+}
+
+int main()
+{
+  testArithmetic();
+  testMath();
+  testOutput();
+  testInput();
+  testVector(Dune::FieldVector<DoubleDouble,3>());
+  testVector(Dune::DynamicVector<DoubleDouble>(3));
+
+  return 0;
+}
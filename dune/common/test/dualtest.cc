@@ -0,0 +1,172 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+
+#include <dune/common/classname.hh>
+#include <dune/common/dual.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/math.hh>
+#include <dune/common/promotiontraits.hh>
+#include <dune/common/typetraits.hh>
+
+struct DualTestException : Dune::Exception {};
+
+#define DUALTEST_ASSERT(EXPR)                               \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(DualTestException,                           \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::Dual;
+using Dune::FieldVector;
+
+static_assert(Dune::IsNumber<Dual<double,3> >::value, "");
+static_assert(Dune::HasNaN<Dual<double,3> >::value, "");
+static_assert(std::is_same<Dune::FieldTraits<Dual<float,2> >::real_type, Dual<float,2> >::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<Dual<float,2>, double>::PromotedType, Dual<double,2> >::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<int, Dual<double,2> >::PromotedType, Dual<double,2> >::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<Dual<double,2>, Dual<double,2> >::PromotedType, Dual<double,2> >::value, "");
+// value and derivatives fill one SIMD register
+static_assert(sizeof(Dual<double,3>) == 32 && alignof(Dual<double,3>) == 32, "");
+
+template<class K, int N>
+bool close (const FieldVector<K,N>& a, const FieldVector<K,N>& b)
+{
+  return (a - b).infinity_norm() <= 8 * std::numeric_limits<K>::epsilon() * (1 + b.infinity_norm());
+}
+
+template<class K>
+bool close (const K& a, const K& b)
+{
+  using std::abs;
+  return abs(a - b) <= 8 * std::numeric_limits<K>::epsilon() * (1 + abs(b));
+}
+
+// the rules of differentiation against closed forms
+template<class K>
+void testScalarRules ()
+{
+  typedef Dual<K,2> D;
+  std::cout << __func__ << "\t ( " << Dune::className<D>() << " )" << std::endl;
+
+  const K x0 = K(0.7), y0 = K(1.3);
+  const D x = D::variable(x0, 0);
+  const D y = D::variable(y0, 1);
+
+  D f = x*y + sin(x)/y - K(2)*exp(y) + log(x) - sqrt(x*x + y*y);
+  const K r = std::sqrt(x0*x0 + y0*y0);
+  DUALTEST_ASSERT(close(f.value(), x0*y0 + std::sin(x0)/y0 - 2*std::exp(y0) + std::log(x0) - r));
+  DUALTEST_ASSERT(close(f.derivative(0), y0 + std::cos(x0)/y0 + 1/x0 - x0/r));
+  DUALTEST_ASSERT(close(f.derivative(1), x0 - std::sin(x0)/(y0*y0) - 2*std::exp(y0) - y0/r));
+
+  // mixed operations with constants
+  D g = K(1) - x;
+  g += K(3);
+  g *= y;
+  g -= K(1);
+  g /= K(2);
+  g = K(4) / g + cos(x) * K(2) + K(1) + pow(y, K(1.5));
+  const K h = ((4 - x0) * y0 - 1) / 2;
+  DUALTEST_ASSERT(close(g.value(), 4/h + 2*std::cos(x0) + 1 + std::pow(y0, K(1.5))));
+  DUALTEST_ASSERT(close(g.derivative(0), -4/(h*h) * (-y0/2) - 2*std::sin(x0)));
+  DUALTEST_ASSERT(close(g.derivative(1), -4/(h*h) * ((4 - x0)/2) + K(1.5)*std::sqrt(y0)));
+
+  // integer powers
+  D p = Dune::power(x, 3);
+  DUALTEST_ASSERT(close(p.value(), x0*x0*x0) && close(p.derivative(0), 3*x0*x0) && p.derivative(1) == 0);
+  p = Dune::power(y, -2);
+  DUALTEST_ASSERT(close(p.value(), 1/(y0*y0)) && close(p.derivative(1), -2/(y0*y0*y0)));
+  p = Dune::power(y, 0);
+  DUALTEST_ASSERT(p.value() == 1 && p.derivative(1) == 0);
+
+  // comparisons and math functions use the value
+  DUALTEST_ASSERT(x < y && y > x && x != y && x <= x && x >= x && !(x == y));
+  DUALTEST_ASSERT(abs(-x).derivative(0) == 1 && abs(-x).value() == x0);
+  DUALTEST_ASSERT(isfinite(x) && !isnan(x) && !isinf(x));
+  DUALTEST_ASSERT(Dune::conjugateComplex(x).derivative(0) == 1);
+
+  std::ostringstream s;
+  s << D::variable(K(2), 1);
+  DUALTEST_ASSERT(s.str() == "2 [0, 1]");
+}
+
+// norms and products of FieldVector and DenseVector with their gradients
+template<class Vector>
+void testVector (Vector v)
+{
+  typedef typename Vector::value_type D;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+
+  const FieldVector<double,3> x0 = { 1.0, -2.0, 2.0 };
+  const auto vars = Dune::dualVariables(x0);
+  for (int i = 0; i < 3; ++i)
+    v[i] = vars[i];
+
+  auto n2 = v.two_norm2();
+  DUALTEST_ASSERT(n2.value() == 9 && close(n2.gradient(), FieldVector<double,3>(2 * x0)));
+  auto n = v.two_norm();
+  DUALTEST_ASSERT(n.value() == 3 && close(n.gradient(), FieldVector<double,3>(x0 / 3.0)));
+  auto n1 = v.one_norm();
+  DUALTEST_ASSERT(n1.value() == 5 && close(n1.gradient(), FieldVector<double,3>({ 1.0, -1.0, 1.0 })));
+
+  Vector c(v);
+  c = 1.0;
+  c[2] = 4.0;
+  auto d = v.dot(c);
+  DUALTEST_ASSERT(d.value() == 7 && close(d.gradient(), FieldVector<double,3>({ 1.0, 1.0, 4.0 })));
+  DUALTEST_ASSERT((v * c).value() == 7);
+
+  // vector space operations with scalars and dual numbers
+  v *= 2.0;
+  v.axpy(D(-1.0), c);
+  v += c;
+  DUALTEST_ASSERT(close(v[2].value(), 4.0) && v[2].derivative(2) == 2.0);
+  DUALTEST_ASSERT(v.infinity_norm().value() == 4.0);
+}
+
+// the Jacobian of a small residual in a single evaluation
+void testJacobian ()
+{
+  std::cout << __func__ << std::endl;
+
+  auto residual = [](const auto& u) {
+    using D = std::decay_t<decltype(u[0])>;
+    FieldVector<D,2> r;
+    r[0] = u[0]*u[0]*u[1] - D(1.0);
+    r[1] = sin(u[0]) + u[1]*u[1]*u[1];
+    return r;
+  };
+
+  const FieldVector<double,2> u0 = { 0.5, 2.0 };
+  const auto r = residual(Dune::dualVariables(u0));
+  DUALTEST_ASSERT(r[0].value() == residual(u0)[0]);
+  DUALTEST_ASSERT(close(r[0].gradient(), FieldVector<double,2>({ 2*u0[0]*u0[1], u0[0]*u0[0] })));
+  DUALTEST_ASSERT(close(r[1].gradient(), FieldVector<double,2>({ std::cos(u0[0]), 3*u0[1]*u0[1] })));
+
+  // products with plain scalars promote the field type
+  auto s = r * 2.0;
+  static_assert(std::is_same<decltype(s), FieldVector<Dual<double,2>,2> >::value, "");
+  DUALTEST_ASSERT(s[1].derivative(1) == 24.0);
+}
+
+int main()
+{
+  testScalarRules<double>();
+  testScalarRules<float>();
+  testVector(FieldVector<Dual<double,3>,3>());
+  testVector(Dune::DynamicVector<Dual<double,3> >(3));
+  testJacobian();
+
+  return 0;
+}
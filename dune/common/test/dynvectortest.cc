@@ -0,0 +1,336 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/execution.hh>
+#include <dune/common/firsttouchallocator.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/paralleldensevector.hh>
+
+struct DynVectorTestException : Dune::Exception {};
+
+#define DYNVECTORTEST_ASSERT(EXPR)                          \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(DynVectorTestException,                      \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::DynamicVector;
+
+template<class ft>
+void testDynamicVector (int d)
+{
+  ft a = 1;
+  DynamicVector<ft> v(d,1);
+  DynamicVector<ft> w(d,2);
+  DynamicVector<ft> z(d,2);
+  DYNVECTORTEST_ASSERT(v.size() == std::size_t(d));
+
+  std::cout << __func__ << "\t ( " << Dune::className(v) << " )" << std::endl;
+
+  // norms
+  DYNVECTORTEST_ASSERT(std::abs(w.two_norm2() - ft(4*d)) <= 1e-12);
+  DYNVECTORTEST_ASSERT(std::abs(w.one_norm() - ft(2*d)) <= 1e-12);
+
+  // op(vec,vec)
+  z = v + w;
+  DYNVECTORTEST_ASSERT(z[d-1] == ft(3));
+  z = v - w;
+  DYNVECTORTEST_ASSERT(z[0] == ft(-1));
+  z = -v;
+  DYNVECTORTEST_ASSERT(z.size() == v.size() && z[0] == ft(-1));
+  w -= v;
+  w += v;
+
+  // op(vec,scalar)
+  w += a;
+  w -= a;
+  w *= a;
+  w /= a;
+
+  // dot and axpy
+  DYNVECTORTEST_ASSERT(std::abs(v.dot(w) - ft(2*d)) <= 1e-12);
+  z = v;
+  z.axpy(a,w);
+  DYNVECTORTEST_ASSERT(z[0] == ft(3));
+
+  // comparison
+  DYNVECTORTEST_ASSERT(v != w);
+  DYNVECTORTEST_ASSERT(v == v);
+
+  // resizing and conversions
+  DynamicVector<ft> r;
+  DYNVECTORTEST_ASSERT(r.empty());
+  r.resize(3, ft(5));
+  DYNVECTORTEST_ASSERT(r.size() == 3 && r.capacity() >= 3 && r[2] == ft(5));
+  Dune::FieldVector<ft,3> f(7);
+  DynamicVector<ft> fromField(f);
+  DYNVECTORTEST_ASSERT(fromField.size() == 3 && fromField[1] == ft(7));
+  r = f;
+  DYNVECTORTEST_ASSERT(r == fromField);
+
+  // istream
+  std::stringstream s;
+  for (int i = 0; i < d; ++i) {
+    s << i << " ";
+    v[i] = i;
+  }
+  s >> w;
+  DYNVECTORTEST_ASSERT(v == w);
+}
+
+template<class ft>
+void testParallelKernels (std::size_t n)
+{
+  DynamicVector<ft> x(n), y(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = ft(i % 7) - ft(3);
+    y[i] = ft(i % 5);
+  }
+
+  std::cout << __func__ << "\t ( " << Dune::className(x) << ", size " << n << " )" << std::endl;
+
+  // integer valued entries, hence all summation orders yield the same results
+  const auto policies = { Dune::Execution::par, Dune::Execution::par.withThreshold(0),
+                          Dune::Execution::par.withThreshold(0).withGrainSize(1),
+                          Dune::Execution::par.withThreshold(0).withThreads(2) };
+  for (const auto& policy : policies) {
+    DYNVECTORTEST_ASSERT(Dune::dot(policy, x, y) == x.dot(y));
+    DYNVECTORTEST_ASSERT(Dune::two_norm2(policy, x) == x.two_norm2());
+    DYNVECTORTEST_ASSERT(Dune::two_norm(policy, x) == x.two_norm());
+    DYNVECTORTEST_ASSERT(Dune::one_norm(policy, x) == x.one_norm());
+    DYNVECTORTEST_ASSERT(Dune::infinity_norm(policy, x) == x.infinity_norm());
+
+    DynamicVector<ft> z(y), zRef(y);
+    Dune::axpy(policy, z, ft(2), x);
+    zRef.axpy(ft(2), x);
+    DYNVECTORTEST_ASSERT(z == zRef);
+  }
+
+  DYNVECTORTEST_ASSERT(Dune::dot(Dune::Execution::seq, x, y) == x.dot(y));
+  DYNVECTORTEST_ASSERT(Dune::one_norm(Dune::Execution::seq, x) == x.one_norm());
+}
+
+// the fused kernels agree with the sequences of axpy operations they replace
+template<class ft>
+void testFusedKernels (std::size_t n)
+{
+  DynamicVector<ft> x(n), y(n), w(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = ft(i % 7) - ft(3);
+    y[i] = ft(i % 5);
+    w[i] = ft(i % 3) + ft(1);
+  }
+
+  std::cout << __func__ << "\t ( " << Dune::className(x) << ", size " << n << " )" << std::endl;
+
+  // integer valued entries and coefficients, hence all roundings are exact
+  const ft a(2), b(-3), c(4);
+  DynamicVector<ft> axpbyRef(y), xpayRef(x), multiAxpyRef(y), combinationRef(n, ft(0));
+  axpbyRef *= b;
+  axpbyRef.axpy(a, x);
+  xpayRef *= a;
+  xpayRef += y;
+  multiAxpyRef.axpy(a, x).axpy(b, w).axpy(c, y);
+  combinationRef.axpy(a, x).axpy(b, y).axpy(c, w);
+
+  auto check = [&] (const auto& policy) {
+    DynamicVector<ft> z(y);
+    Dune::axpby(policy, z, a, x, b);
+    DYNVECTORTEST_ASSERT(z == axpbyRef);
+
+    z = x;
+    Dune::xpay(policy, z, y, a);
+    DYNVECTORTEST_ASSERT(z == xpayRef);
+
+    // the result may be one of the inputs
+    z = y;
+    Dune::multiAxpy(policy, z, { a, b, c }, x, w, z);
+    DYNVECTORTEST_ASSERT(z == multiAxpyRef);
+
+    z = ft(7);
+    Dune::linearCombination(policy, z, { a, b, c }, x, y, w);
+    DYNVECTORTEST_ASSERT(z == combinationRef);
+    z = w;
+    Dune::linearCombination(policy, z, { a, b, c }, x, y, z);
+    DYNVECTORTEST_ASSERT(z == combinationRef);
+
+    DynamicVector<ft> scaled(w);
+    scaled *= c;
+    Dune::linearCombination(policy, z, { c }, w);
+    DYNVECTORTEST_ASSERT(z == scaled);
+  };
+  check(Dune::Execution::seq);
+  check(Dune::Execution::par);
+  check(Dune::Execution::par.withThreshold(0).withGrainSize(1));
+  check(Dune::Execution::par.withThreshold(0).withThreads(2));
+}
+
+// a zero coefficient of y skips reading y, as in BLAS
+template<class ft>
+void testFusedKernelsZeroCoefficient ()
+{
+  std::cout << __func__ << "\t ( " << Dune::className<ft>() << " )" << std::endl;
+
+  const std::size_t n = 1000;
+  DynamicVector<ft> x(n), expected(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = ft(i % 7);
+    expected[i] = ft(2) * x[i];
+  }
+
+  for (auto policy : { Dune::Execution::par, Dune::Execution::par.withThreshold(0) }) {
+    DynamicVector<ft> y(n, std::numeric_limits<ft>::quiet_NaN());
+    y[1] = std::numeric_limits<ft>::infinity();
+    Dune::axpby(policy, y, ft(2), x, ft(0));
+    DYNVECTORTEST_ASSERT(y == expected);
+
+    y = std::numeric_limits<ft>::quiet_NaN();
+    Dune::xpay(policy, y, x, ft(0));
+    DYNVECTORTEST_ASSERT(y == x);
+  }
+  DynamicVector<ft> y(n, std::numeric_limits<ft>::quiet_NaN());
+  Dune::axpby(Dune::Execution::seq, y, ft(2), x, ft(0));
+  DYNVECTORTEST_ASSERT(y == expected);
+}
+
+// the fused kernels on vectors of blocks
+void testFusedKernelsBlocked ()
+{
+  std::cout << __func__ << std::endl;
+
+  typedef Dune::FieldVector<double,2> Block;
+  DynamicVector<Block> x(100, Block{ 1, 2 }), y(100, Block{ 3, -1 });
+  const auto policy = Dune::Execution::par.withThreshold(0);
+  Dune::axpby(policy, y, 2.0, x, 0.5);
+  for (const auto& yi : y)
+    DYNVECTORTEST_ASSERT((yi == Block{ 3.5, 3.5 }));
+  Dune::linearCombination(policy, y, { 1.0, -1.0 }, x, y);
+  for (const auto& yi : y)
+    DYNVECTORTEST_ASSERT((yi == Block{ -2.5, -1.5 }));
+
+  Dune::FieldVector<float,3> u = { 1, 2, 3 }, v = { 1, 1, 1 };
+  Dune::xpay(Dune::Execution::seq, u, v, 2.0f);
+  DYNVECTORTEST_ASSERT((u == Dune::FieldVector<float,3>{ 3, 5, 7 }));
+}
+
+// the reproducible reductions give bitwise identical results for all thread counts
+template<class ft>
+void testReproducibleReductions (std::size_t n)
+{
+  DynamicVector<ft> x(n), y(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = std::sin(ft(i)) * std::exp(ft(i % 17));
+    y[i] = std::cos(ft(3*i)) / ft(i+1);
+  }
+
+  std::cout << __func__ << "\t ( " << Dune::className(x) << ", size " << n << " )" << std::endl;
+
+  const auto reference = Dune::Execution::par.withReproducibleReductions().withThreads(1);
+  const auto dot = Dune::dot(reference, x, y);
+  const auto norm2 = Dune::two_norm2(reference, x);
+  const auto norm1 = Dune::one_norm(reference, x);
+
+  for (std::size_t threads = 1; threads <= 8; ++threads)
+    for (std::size_t grainSize : {0, 1, 5000, 100000}) {
+      const auto policy = Dune::Execution::par.withReproducibleReductions()
+        .withThreshold(0).withThreads(threads).withGrainSize(grainSize);
+      DYNVECTORTEST_ASSERT(Dune::dot(policy, x, y) == dot);
+      DYNVECTORTEST_ASSERT(Dune::two_norm2(policy, x) == norm2);
+      DYNVECTORTEST_ASSERT(Dune::one_norm(policy, x) == norm1);
+    }
+
+  // the threshold does not change the result either
+  const auto sequential = Dune::Execution::par.withReproducibleReductions().withThreshold(n+1);
+  DYNVECTORTEST_ASSERT(Dune::dot(sequential, x, y) == dot);
+  DYNVECTORTEST_ASSERT(Dune::two_norm2(sequential, x) == norm2);
+  DYNVECTORTEST_ASSERT(Dune::one_norm(sequential, x) == norm1);
+
+  // and the result is a sensible approximation
+  using std::abs;
+  DYNVECTORTEST_ASSERT(abs(dot - x.dot(y)) <= 1e-3 * x.one_norm() * y.infinity_norm());
+  DYNVECTORTEST_ASSERT(abs(norm2 - x.two_norm2()) <= 1e-3 * norm2);
+}
+
+void testParallelInfinityNormNaN ()
+{
+  DynamicVector<double> x(100000, 1.0);
+  x[54321] = std::nan("");
+  DYNVECTORTEST_ASSERT(std::isnan(Dune::infinity_norm(Dune::Execution::par.withThreshold(0), x)));
+}
+
+void testFirstTouchAllocator (std::size_t n, Dune::HugePageMode mode)
+{
+  typedef Dune::FirstTouchAllocator<double> Allocator;
+  const auto policy = Dune::Execution::par.withThreshold(0).withThreads(2);
+  DynamicVector<double, Allocator> x(n, Allocator(policy, mode));
+
+  std::cout << __func__ << "\t ( " << Dune::className(x) << ", size " << n << " )" << std::endl;
+
+  DYNVECTORTEST_ASSERT(x.size() == n);
+  DYNVECTORTEST_ASSERT(x.get_allocator().hugePages() == mode);
+  DYNVECTORTEST_ASSERT(x.infinity_norm() == 0.0);
+
+  DynamicVector<double, Allocator> y(n, 2.0, x.get_allocator());
+  for (std::size_t i = 0; i < n; ++i)
+    x[i] = double(i % 3);
+  DYNVECTORTEST_ASSERT(Dune::dot(policy, x, y) == x.dot(y));
+
+  // shrinking and growing again value-initializes the new entries
+  x.resize(n/2);
+  x.resize(n);
+  DYNVECTORTEST_ASSERT(x[n-1] == 0.0);
+
+  DynamicVector<double, Allocator> z(y);
+  DYNVECTORTEST_ASSERT(z == y);
+  DYNVECTORTEST_ASSERT(z.get_allocator() == Allocator(Dune::Execution::par, mode));
+  DYNVECTORTEST_ASSERT(Dune::FirstTouchAllocator<float>(z.get_allocator()) == z.get_allocator());
+}
+
+int main()
+{
+  testDynamicVector<double>(5);
+  testDynamicVector<float>(3);
+  testDynamicVector<int>(4);
+  testDynamicVector<std::complex<double> >(2);
+
+  testParallelKernels<double>(10);
+  testParallelKernels<double>(100003);
+  testParallelKernels<float>(4097);
+  testParallelKernels<std::complex<double> >(50000);
+  testParallelInfinityNormNaN();
+
+  testFusedKernels<double>(0);
+  testFusedKernels<double>(13);
+  testFusedKernels<double>(100003);
+  testFusedKernels<float>(4097);
+  testFusedKernels<int>(1000);
+  testFusedKernels<std::complex<double> >(50000);
+  testFusedKernelsBlocked();
+  testFusedKernelsZeroCoefficient<double>();
+  testFusedKernelsZeroCoefficient<float>();
+
+  testReproducibleReductions<double>(1000);
+  testReproducibleReductions<double>(123457);
+  testReproducibleReductions<float>(50001);
+  testReproducibleReductions<std::complex<double> >(20000);
+
+  for (auto mode : { Dune::HugePageMode::none, Dune::HugePageMode::transparent, Dune::HugePageMode::hugetlb }) {
+    testFirstTouchAllocator(7, mode);
+    testFirstTouchAllocator(1000000, mode);
+  }
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/float16.hh>
+#include <dune/common/fvector.hh>
+
+struct Float16TestException : Dune::Exception {};
+
+#define FLOAT16TEST_ASSERT(EXPR)                            \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(Float16TestException,                        \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::BFloat16;
+using Dune::Float16;
+
+static_assert(sizeof(Float16) == 2 && sizeof(BFloat16) == 2, "");
+static_assert(std::is_same<Dune::PromotionTraits<Float16, Float16>::PromotedType, float>::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<BFloat16, double>::PromotedType, double>::value, "");
+static_assert(std::is_same<decltype(Float16() * Float16()), float>::value, "");
+
+// value of a number after conversion to T
+template<class T>
+float rounded (double d)
+{
+  return float(T(d));
+}
+
+void testFloat16Rounding ()
+{
+  const double e = std::ldexp(1.0, -11);  // half an ulp of 1
+
+  FLOAT16TEST_ASSERT(rounded<Float16>(1.0) == 1.0f);
+  FLOAT16TEST_ASSERT(rounded<Float16>(1.0 + e) == 1.0f);                       // tie to even
+  FLOAT16TEST_ASSERT(rounded<Float16>(1.0 + 3*e) == float(1.0 + 4*e));         // tie to even
+  FLOAT16TEST_ASSERT(rounded<Float16>(1.0 + e + std::ldexp(1.0, -40)) == float(1.0 + 2*e));  // no double rounding
+  FLOAT16TEST_ASSERT(rounded<Float16>(-2.5) == -2.5f);
+
+  // range
+  FLOAT16TEST_ASSERT(rounded<Float16>(65504.0) == 65504.0f);
+  FLOAT16TEST_ASSERT(rounded<Float16>(65519.0) == 65504.0f);
+  FLOAT16TEST_ASSERT(std::isinf(rounded<Float16>(65520.0)));
+  FLOAT16TEST_ASSERT(rounded<Float16>(std::ldexp(1.0, -24)) == std::ldexp(1.0f, -24));
+  FLOAT16TEST_ASSERT(rounded<Float16>(std::ldexp(1.0, -25)) == 0.0f);
+  FLOAT16TEST_ASSERT(rounded<Float16>(std::ldexp(1.5, -25)) == std::ldexp(1.0f, -24));
+  FLOAT16TEST_ASSERT(rounded<Float16>(std::ldexp(3.0, -25)) == std::ldexp(1.0f, -23));
+  FLOAT16TEST_ASSERT(Float16(-0.0f).bits() == 0x8000);
+  FLOAT16TEST_ASSERT(std::isinf(rounded<Float16>(-std::numeric_limits<double>::infinity())));
+  FLOAT16TEST_ASSERT(std::isnan(rounded<Float16>(std::numeric_limits<float>::quiet_NaN())));
+
+  // the upper payload bits of float NaNs are kept, and the NaNs are quieted
+  std::uint32_t nanBits = 0xffa46000;
+  float nan;
+  std::memcpy(&nan, &nanBits, sizeof(nan));
+  FLOAT16TEST_ASSERT(Float16(nan).bits() == 0xff23);
+
+  // every binary16 number converts to float and back unchanged
+  for (std::uint32_t bits = 0; bits < 0x10000; ++bits) {
+    const Float16 h = Float16::fromBits(std::uint16_t(bits));
+    const float f = h;
+    if (std::isnan(f)) {
+      // NaNs keep their payload and are quieted
+      FLOAT16TEST_ASSERT((bits & 0x7c00) == 0x7c00 && (bits & 0x3ff) != 0);
+      FLOAT16TEST_ASSERT(Float16(f).bits() == (bits | 0x200));
+    }
+    else {
+      FLOAT16TEST_ASSERT(Float16(f).bits() == bits);
+    }
+  }
+}
+
+void testBFloat16Rounding ()
+{
+  const double e = std::ldexp(1.0, -8);  // half an ulp of 1
+
+  FLOAT16TEST_ASSERT(rounded<BFloat16>(1.0 + e) == 1.0f);
+  FLOAT16TEST_ASSERT(rounded<BFloat16>(1.0 + 3*e) == float(1.0 + 4*e));
+  FLOAT16TEST_ASSERT(rounded<BFloat16>(1.0 + e + std::ldexp(1.0, -40)) == float(1.0 + 2*e));
+  FLOAT16TEST_ASSERT(rounded<BFloat16>(1e30) == float(BFloat16(1e30f)));
+  FLOAT16TEST_ASSERT(std::isinf(rounded<BFloat16>(std::numeric_limits<float>::max())));
+  FLOAT16TEST_ASSERT(std::isnan(rounded<BFloat16>(std::numeric_limits<float>::quiet_NaN())));
+
+  for (std::uint32_t bits = 0; bits < 0x10000; ++bits) {
+    const BFloat16 b = BFloat16::fromBits(std::uint16_t(bits));
+    const float f = b;
+    if (std::isnan(f)) {
+      FLOAT16TEST_ASSERT(std::isnan(float(BFloat16(f))));
+    }
+    else {
+      FLOAT16TEST_ASSERT(BFloat16(f).bits() == bits);
+    }
+  }
+}
+
+// the bulk conversions agree with the conversions of single numbers
+template<class T>
+void testBulkConversion ()
+{
+  const std::size_t n = 1000;
+  std::vector<float> f(n);
+  std::vector<double> d(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    d[i] = std::ldexp(std::sin(double(i)), int(i % 60) - 30);
+    f[i] = float(d[i]);
+  }
+
+  std::vector<T> fromFloat(n), fromDouble(n);
+  Dune::convertArray(f.data(), n, fromFloat.data());
+  Dune::convertArray(d.data(), n, fromDouble.data());
+  std::vector<float> backToFloat(n);
+  std::vector<double> backToDouble(n);
+  Dune::convertArray(fromFloat.data(), n, backToFloat.data());
+  Dune::convertArray(fromDouble.data(), n, backToDouble.data());
+
+  for (std::size_t i = 0; i < n; ++i) {
+    FLOAT16TEST_ASSERT(fromFloat[i].bits() == T(f[i]).bits());
+    FLOAT16TEST_ASSERT(fromDouble[i].bits() == T(d[i]).bits());
+    FLOAT16TEST_ASSERT(backToFloat[i] == float(fromFloat[i]));
+    FLOAT16TEST_ASSERT(backToDouble[i] == double(float(fromDouble[i])));
+  }
+}
+
+// vectors of 16-bit numbers compute in float
+template<class T>
+void testVectors ()
+{
+  Dune::FieldVector<T,3> x = { T(1.0f), T(-2.0f), T(0.5f) };
+  Dune::FieldVector<T,3> y(T(2.0f));
+  static_assert(std::is_same<decltype(x.dot(y)), float>::value, "");
+  static_assert(std::is_same<decltype(x.two_norm2()), float>::value, "");
+
+  FLOAT16TEST_ASSERT(x.dot(y) == -1.0f);
+  FLOAT16TEST_ASSERT(x.two_norm2() == 5.25f);
+  FLOAT16TEST_ASSERT(x.infinity_norm() == 2.0f);
+  x.axpy(0.5f, y);
+  x *= 2.0f;
+  FLOAT16TEST_ASSERT(x[1] == T(-2.0f));
+  FLOAT16TEST_ASSERT(x == x && x != y);
+
+  // the sum is not limited by the precision of T
+  Dune::DynamicVector<T> ones(1000, T(1.0f));
+  FLOAT16TEST_ASSERT(ones.one_norm() == 1000.0f);
+  FLOAT16TEST_ASSERT(ones.dot(ones) == 1000.0f);
+}
+
+int main()
+{
+  testFloat16Rounding();
+  testBFloat16Rounding();
+  testBulkConversion<Float16>();
+  testBulkConversion<BFloat16>();
+  testVectors<Float16>();
+  testVectors<BFloat16>();
+  return 0;
+}
@@ -0,0 +1,152 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <dune/common/classname.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fmatrixbatch.hh>
+#include <dune/common/fvector.hh>
+
+struct FMatrixBatchTestException : Dune::Exception {};
+
+#define FMATRIXBATCHTEST_ASSERT(EXPR)                       \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(FMatrixBatchTestException,                   \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::FieldMatrix;
+using Dune::FieldVector;
+
+// equal up to rounding, as the compiler may contract differently in both computations
+template<class K>
+bool close (const K& a, const K& b)
+{
+  using std::abs;
+  return abs(a - b) <= 64 * std::numeric_limits<K>::epsilon() * (1 + abs(b));
+}
+
+template<class K, int n>
+bool close (const FieldVector<K,n>& a, const FieldVector<K,n>& b)
+{
+  for (int i = 0; i < n; ++i)
+    if (!close(a[i], b[i]))
+      return false;
+  return true;
+}
+
+template<class K, int n>
+bool close (const FieldMatrix<K,n,n>& A, const FieldMatrix<K,n,n>& B)
+{
+  for (int i = 0; i < n; ++i)
+    if (!close(A[i], B[i]))
+      return false;
+  return true;
+}
+
+// a different well-conditioned matrix for every item, most of which need pivoting
+template<class K, int n>
+FieldMatrix<K,n,n> makeMatrix (std::size_t e)
+{
+  FieldMatrix<K,n,n> A;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      A[i][j] = K(std::sin(1.0 + 0.7*e + 1.3*i + 2.9*j));
+  for (int i = 0; i < n; ++i)
+    A[i][(i + e) % n] += K(2);
+  return A;
+}
+
+// every item gets the result of FieldMatrix
+template<class K, int n>
+void testBatch (std::size_t count)
+{
+  typedef FieldMatrix<K,n,n> Matrix;
+  std::cout << __func__ << "\t ( " << Dune::className<Matrix>() << ", " << count << " )" << std::endl;
+
+  Dune::FieldMatrixBatch<K,n,n> A(count);
+  Dune::FieldVectorBatch<K,n> b(count), x(count);
+  FMATRIXBATCHTEST_ASSERT(A.size() == count && x.size() == count);
+  for (std::size_t e = 0; e < count; ++e) {
+    A.set(e, makeMatrix<K,n>(e));
+    FieldVector<K,n> be;
+    for (int i = 0; i < n; ++i)
+      be[i] = K(i + 1) - K(e % 3);
+    b.set(e, be);
+  }
+  FMATRIXBATCHTEST_ASSERT((A.get(count-1) == makeMatrix<K,n>(count-1)));
+  FMATRIXBATCHTEST_ASSERT((A.component(0, n-1)[1] == makeMatrix<K,n>(1)[0][n-1]));
+
+  std::vector<K> det;
+  A.determinant(det);
+  FMATRIXBATCHTEST_ASSERT(det.size() == count);
+  A.solve(x, b);
+  for (std::size_t e = 0; e < count; ++e) {
+    const Matrix Ae = A.get(e);
+    FMATRIXBATCHTEST_ASSERT(close(det[e], Ae.determinant()));
+    FieldVector<K,n> xe;
+    Ae.solve(xe, b.get(e));
+    FMATRIXBATCHTEST_ASSERT(close(x.get(e), xe));
+  }
+
+  Dune::FieldMatrixBatch<K,n,n> inverse = A;
+  inverse.invert();
+  for (std::size_t e = 0; e < count; ++e) {
+    Matrix Ae = A.get(e);
+    Ae.invert();
+    FMATRIXBATCHTEST_ASSERT(close(inverse.get(e), Ae));
+  }
+
+  // a singular item is reported, the other items are processed
+  if (n > 1) {
+    Matrix S = A.get(count/2);
+    S[n-1] = K(0);
+    A.set(count/2, S);
+    A.determinant(det);
+    FMATRIXBATCHTEST_ASSERT(det[count/2] == K(0));
+    bool thrown = false;
+    inverse = A;
+    try {
+      inverse.invert();
+    }
+    catch (const Dune::FMatrixError&) {
+      thrown = true;
+    }
+    FMATRIXBATCHTEST_ASSERT(thrown);
+    Matrix Ae = A.get(count-1);
+    Ae.invert();
+    FMATRIXBATCHTEST_ASSERT(close(inverse.get(count-1), Ae));
+
+    thrown = false;
+    try {
+      A.solve(x, b);
+    }
+    catch (const Dune::FMatrixError&) {
+      thrown = true;
+    }
+    FMATRIXBATCHTEST_ASSERT(thrown);
+  }
+}
+
+int main()
+{
+  testBatch<double,1>(5);
+  testBatch<double,2>(21);
+  testBatch<double,3>(37);
+  testBatch<double,4>(64);
+  testBatch<double,4>(3);
+  testBatch<double,6>(19);
+  testBatch<float,3>(40);
+  testBatch<float,5>(33);
+
+  return 0;
+}
@@ -0,0 +1,305 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+#include <dune/common/classname.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/math.hh>
+
+struct FMatrixTestException : Dune::Exception {};
+
+#define FMATRIXTEST_ASSERT(EXPR)                            \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(FMatrixTestException,                        \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::FieldMatrix;
+using Dune::FieldVector;
+
+static_assert(std::is_trivially_copyable<FieldMatrix<double,3,4> >::value, "");
+static_assert(sizeof(FieldMatrix<double,3,4>) == 12*sizeof(double), "");
+static_assert(std::is_same<Dune::FieldTraits<FieldMatrix<std::complex<float>,2,2> >::real_type, float>::value, "");
+
+// small integers, so that all sums below are exact
+template<class K>
+struct Entries
+{
+  static K make (int i, int j, int seed)
+  {
+    return K((i*7 + j*3 + seed) % 11 - 5);
+  }
+};
+
+template<class K>
+struct Entries< std::complex<K> >
+{
+  static std::complex<K> make (int i, int j, int seed)
+  {
+    return { K((i*7 + j*3 + seed) % 11 - 5), K((i + j*5 + seed) % 7 - 3) };
+  }
+};
+
+template<class K>
+K makeEntry (int i, int j, int seed)
+{
+  return Entries<K>::make(i, j, seed);
+}
+
+// all products agree exactly with the plain loops
+template<class K, int ROWS, int COLS>
+void testProducts ()
+{
+  typedef FieldMatrix<K,ROWS,COLS> Matrix;
+  std::cout << __func__ << "\t ( " << Dune::className<Matrix>() << " )" << std::endl;
+
+  Matrix A;
+  for (int i = 0; i < ROWS; ++i)
+    for (int j = 0; j < COLS; ++j)
+      A[i][j] = makeEntry<K>(i, j, 1);
+  FieldVector<K,COLS> x;
+  FieldVector<K,ROWS> z;
+  for (int j = 0; j < COLS; ++j)
+    x[j] = makeEntry<K>(j, 0, 2);
+  for (int i = 0; i < ROWS; ++i)
+    z[i] = makeEntry<K>(i, 1, 3);
+  const K alpha = 3;
+
+  FieldVector<K,ROWS> Ax(0);
+  FieldVector<K,COLS> ATz(0), AHz(0);
+  for (int i = 0; i < ROWS; ++i)
+    for (int j = 0; j < COLS; ++j) {
+      Ax[i] += A[i][j] * x[j];
+      ATz[j] += A[i][j] * z[i];
+      AHz[j] += Dune::conjugateComplex(A[i][j]) * z[i];
+    }
+
+  FieldVector<K,ROWS> y;
+  A.mv(x, y);
+  FMATRIXTEST_ASSERT(y == Ax);
+  FMATRIXTEST_ASSERT(A * x == Ax);
+  y = z;
+  A.umv(x, y);
+  FMATRIXTEST_ASSERT(y == z + Ax);
+  y = z;
+  A.mmv(x, y);
+  FMATRIXTEST_ASSERT(y == z - Ax);
+  y = z;
+  A.usmv(alpha, x, y);
+  FMATRIXTEST_ASSERT(y == z + alpha * Ax);
+
+  FieldVector<K,COLS> w;
+  A.mtv(z, w);
+  FMATRIXTEST_ASSERT(w == ATz);
+  w = x;
+  A.umtv(z, w);
+  FMATRIXTEST_ASSERT(w == x + ATz);
+  w = x;
+  A.mmtv(z, w);
+  FMATRIXTEST_ASSERT(w == x - ATz);
+  w = x;
+  A.usmtv(alpha, z, w);
+  FMATRIXTEST_ASSERT(w == x + alpha * ATz);
+  w = x;
+  A.umhv(z, w);
+  FMATRIXTEST_ASSERT(w == x + AHz);
+  w = x;
+  A.mmhv(z, w);
+  FMATRIXTEST_ASSERT(w == x - AHz);
+  w = x;
+  A.usmhv(alpha, z, w);
+  FMATRIXTEST_ASSERT(w == x + alpha * AHz);
+
+  // products with matrices
+  FieldMatrix<K,COLS,3> B;
+  for (int i = 0; i < COLS; ++i)
+    for (int j = 0; j < 3; ++j)
+      B[i][j] = makeEntry<K>(i, j, 4);
+  FieldMatrix<K,ROWS,3> AB(0);
+  for (int i = 0; i < ROWS; ++i)
+    for (int j = 0; j < 3; ++j)
+      for (int k = 0; k < COLS; ++k)
+        AB[i][j] += A[i][k] * B[k][j];
+  FMATRIXTEST_ASSERT(A * B == AB);
+  FMATRIXTEST_ASSERT(A.rightmultiplyany(B) == AB);
+  FMATRIXTEST_ASSERT(B.leftmultiplyany(A) == AB);
+
+  const auto AT = A.transposed();
+  FMATRIXTEST_ASSERT((A.transposed() * A).transposed() == AT * A);
+  for (int i = 0; i < ROWS; ++i)
+    for (int j = 0; j < COLS; ++j)
+      FMATRIXTEST_ASSERT(AT[j][i] == A[i][j]);
+
+  FieldMatrix<K,COLS,COLS> S = AT * A;
+  const FieldMatrix<K,COLS,COLS> T = S;
+  FieldMatrix<K,COLS,COLS> ST(0), TS(0);
+  const FieldMatrix<K,COLS,COLS> R = S * K(2) - T;
+  for (int i = 0; i < COLS; ++i)
+    for (int j = 0; j < COLS; ++j)
+      for (int k = 0; k < COLS; ++k) {
+        ST[i][j] += S[i][k] * R[k][j];
+        TS[i][j] += R[i][k] * S[k][j];
+      }
+  S.rightmultiply(R);
+  FMATRIXTEST_ASSERT(S == ST);
+  S = T;
+  S.leftmultiply(R);
+  FMATRIXTEST_ASSERT(S == TS);
+
+  // vector space operations and norms
+  Matrix C = A;
+  C *= K(2);
+  C -= A;
+  FMATRIXTEST_ASSERT(C == A && !(C != A));
+  C.axpy(K(-1), A);
+  FMATRIXTEST_ASSERT(C.frobenius_norm2() == 0 && C.infinity_norm() == 0);
+  C = K(1);
+  FMATRIXTEST_ASSERT(C.frobenius_norm2() == ROWS*COLS);
+  FMATRIXTEST_ASSERT(C.infinity_norm() == COLS);
+  FMATRIXTEST_ASSERT((A + C) - C == A && (A * K(2)) / K(2) == A && K(2) * A == A + A);
+
+  int rows = 0;
+  for (const auto& row : A) {
+    FMATRIXTEST_ASSERT(row == A[rows]);
+    ++rows;
+  }
+  FMATRIXTEST_ASSERT(rows == ROWS && A.N() == ROWS && A.M() == COLS);
+}
+
+template<class K, int n>
+bool isIdentity (const FieldMatrix<K,n,n>& A, double tolerance)
+{
+  using std::abs;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      if (abs(A[i][j] - K(i == j ? 1 : 0)) > tolerance)
+        return false;
+  return true;
+}
+
+// inverses and solutions, closed formulas for n <= 3 and LU decompositions otherwise
+template<class K, int n>
+void testInverse ()
+{
+  typedef FieldMatrix<K,n,n> Matrix;
+  std::cout << __func__ << "\t ( " << Dune::className<Matrix>() << " )" << std::endl;
+  using std::abs;
+
+  const double tolerance = 64 * std::numeric_limits<typename Dune::FieldTraits<K>::real_type>::epsilon();
+
+  // small diagonal, so that the LU decompositions have to pivot
+  Matrix A;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      A[i][j] = (i == j) ? K(0.5) : K(1) / K(i + 2*j + 1);
+
+  Matrix Ainv = A;
+  Ainv.invert();
+  FMATRIXTEST_ASSERT(isIdentity(A * Ainv, tolerance));
+  FMATRIXTEST_ASSERT(isIdentity(Ainv * A, tolerance));
+
+  // the determinant is that of the triangular factors
+  const K det = A.determinant();
+  FMATRIXTEST_ASSERT(abs(det * Ainv.determinant() - K(1)) <= tolerance);
+
+  FieldVector<K,n> b, x;
+  for (int i = 0; i < n; ++i)
+    b[i] = K(i + 1);
+  A.solve(x, b);
+  FMATRIXTEST_ASSERT((A * x - b).infinity_norm() <= tolerance * b.infinity_norm());
+
+  // singular matrices
+  if (n > 1) {
+    Matrix S = A;
+    S[n-1] = S[0];
+    FMATRIXTEST_ASSERT(abs(S.determinant()) <= tolerance);
+    S[0] = K(0);
+    FMATRIXTEST_ASSERT(S.determinant() == K(0));
+    bool thrown = false;
+    try {
+      S.invert();
+    }
+    catch (const Dune::FMatrixError&) {
+      thrown = true;
+    }
+    FMATRIXTEST_ASSERT(thrown);
+    thrown = false;
+    try {
+      S.solve(x, b);
+    }
+    catch (const Dune::FMatrixError&) {
+      thrown = true;
+    }
+    FMATRIXTEST_ASSERT(thrown);
+  }
+}
+
+// the closed formulas for small matrices, with determinants that are powers of two
+void testClosedFormulas ()
+{
+  std::cout << __func__ << std::endl;
+
+  const FieldMatrix<double,2,2> A2 = {{ 3.0, 1.0 }, { 2.0, 2.0 }};
+  FMATRIXTEST_ASSERT(A2.determinant() == 4.0);
+  FieldMatrix<double,2,2> inverse2;
+  FMATRIXTEST_ASSERT(Dune::FMatrixHelp::invertMatrix(A2, inverse2) == 4.0);
+  FMATRIXTEST_ASSERT((inverse2 == FieldMatrix<double,2,2>({{ 0.5, -0.25 }, { -0.5, 0.75 }})));
+  FieldMatrix<double,2,2> inverseT2;
+  Dune::FMatrixHelp::invertMatrix_retTransposed(A2, inverseT2);
+  FMATRIXTEST_ASSERT(inverseT2 == inverse2.transposed());
+
+  const FieldMatrix<double,3,3> A3 = {{ 2.0, 0.0, 0.0 }, { 1.0, 1.0, 0.0 }, { 0.0, 2.0, 4.0 }};
+  FMATRIXTEST_ASSERT(A3.determinant() == 8.0);
+  FieldMatrix<double,3,3> inverse3;
+  FMATRIXTEST_ASSERT(Dune::FMatrixHelp::invertMatrix(A3, inverse3) == 8.0);
+  FMATRIXTEST_ASSERT(isIdentity(A3 * inverse3, 0.0));
+  FieldMatrix<double,3,3> inverseT3;
+  Dune::FMatrixHelp::invertMatrix_retTransposed(A3, inverseT3);
+  FMATRIXTEST_ASSERT(inverseT3 == inverse3.transposed());
+
+  // in-place inversion
+  FieldMatrix<double,3,3> B3 = A3;
+  B3.invert();
+  FMATRIXTEST_ASSERT(B3 == inverse3);
+
+  FieldVector<double,3> x;
+  A3.solve(x, FieldVector<double,3>({ 2.0, 2.0, 6.0 }));
+  FMATRIXTEST_ASSERT((x == FieldVector<double,3>(1.0)));
+}
+
+int main()
+{
+  testProducts<double,1,1>();
+  testProducts<double,2,3>();
+  testProducts<double,3,3>();
+  testProducts<double,4,4>();
+  testProducts<double,5,7>();
+  testProducts<double,7,5>();
+  testProducts<float,16,16>();
+  testProducts<double,17,3>();
+  testProducts<int,4,6>();
+  testProducts<std::complex<double>,3,4>();
+
+  testInverse<double,1>();
+  testInverse<double,2>();
+  testInverse<double,3>();
+  testInverse<double,4>();
+  testInverse<double,6>();
+  testInverse<float,5>();
+  testInverse<std::complex<double>,4>();
+
+  testClosedFormulas();
+
+  return 0;
+}
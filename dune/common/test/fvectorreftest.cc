@@ -0,0 +1,213 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <complex>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+
+#include <dune/common/classname.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/fvectorref.hh>
+
+struct FieldVectorRefTestException : Dune::Exception {};
+
+#define FIELDVECTORREFTEST_ASSERT(EXPR)                     \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(FieldVectorRefTestException,                 \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::FieldVector;
+using Dune::FieldVectorRef;
+
+static_assert(std::is_same<decltype(Dune::head<2>(std::declval<FieldVector<double,5>&>())),
+                           FieldVectorRef<double,2> >::value, "");
+static_assert(std::is_same<decltype(Dune::tail<2>(std::declval<const FieldVector<double,5>&>())),
+                           FieldVectorRef<const double,2> >::value, "");
+static_assert(FieldVectorRef<double,3>::size() == 3, "");
+static_assert(Dune::Impl::DenseVectorStaticSize<FieldVectorRef<float,4> >::value == 4, "");
+static_assert(std::is_same<Dune::FieldTraits<FieldVectorRef<const std::complex<float>,2> >::real_type,
+                           float>::value, "");
+static_assert(!std::is_convertible<FieldVectorRef<const double,3>, FieldVectorRef<double,3> >::value, "");
+static_assert(std::is_convertible<FieldVectorRef<double,3>, FieldVectorRef<const double,3> >::value, "");
+static_assert(!std::is_convertible<const FieldVector<double,3>&, FieldVectorRef<double,3> >::value, "");
+
+// views of temporary vectors are rejected, views of temporary views are fine
+template<class V, class = void>
+struct HasHead : std::false_type {};
+
+template<class V>
+struct HasHead<V, std::void_t<decltype(Dune::head<2>(std::declval<V>()))> > : std::true_type {};
+
+static_assert(HasHead<FieldVector<double,5>&>::value && HasHead<const FieldVector<double,5>&>::value, "");
+static_assert(!HasHead<FieldVector<double,5> >::value && !HasHead<const FieldVector<double,5> >::value, "");
+static_assert(HasHead<FieldVectorRef<double,5> >::value, "");
+
+template<class K>
+FieldVector<K,6> makeVector ()
+{
+  FieldVector<K,6> x;
+  for (int i = 0; i < 6; ++i)
+    x[i] = K(i + 1);
+  return x;
+}
+
+// the entries of the views are the entries of the parent
+template<class K>
+void testWriteThrough ()
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << " )" << std::endl;
+
+  auto x = makeVector<K>();
+  auto s = Dune::segment<1,3>(x);
+  FIELDVECTORREFTEST_ASSERT(s.data() == x.data() + 1);
+  FIELDVECTORREFTEST_ASSERT(s[0] == K(2) && s[2] == K(4));
+
+  s[1] = K(10);
+  FIELDVECTORREFTEST_ASSERT(x[2] == K(10));
+
+  Dune::head<2>(x) = K(0);
+  FIELDVECTORREFTEST_ASSERT(x[0] == K(0) && x[1] == K(0) && x[2] == K(10));
+
+  Dune::tail<2>(x) *= K(2);
+  FIELDVECTORREFTEST_ASSERT(x[4] == K(10) && x[5] == K(12));
+
+  // the views copy values when assigned to
+  x = makeVector<K>();
+  Dune::head<3>(x) = Dune::tail<3>(x);
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 4, 5, 6, 4, 5, 6 }));
+
+  // and overlapping views are assigned as if through a copy
+  x = makeVector<K>();
+  Dune::segment<1,4>(x) = Dune::head<4>(x);
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 1, 1, 2, 3, 4, 6 }));
+
+  // also if the source is a read-only view
+  x = makeVector<K>();
+  const auto& cx = x;
+  Dune::segment<1,4>(x) = Dune::head<4>(cx);
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 1, 1, 2, 3, 4, 6 }));
+  Dune::head<3>(x) = Dune::tail<3>(cx);
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 3, 4, 6, 3, 4, 6 }));
+
+  // copies of a view view the same entries
+  auto s2 = s;
+  s2[0] = K(7);
+  FIELDVECTORREFTEST_ASSERT(x[1] == K(7) && s[0] == K(7));
+
+  // a view of the whole vector, and views of views
+  FieldVectorRef<K,6> all(x);
+  Dune::tail<1>(Dune::head<3>(all)) = K(-1);
+  FIELDVECTORREFTEST_ASSERT(x[2] == K(-1));
+
+  FieldVector<K,2> y = { 8, 9 };
+  Dune::segment<2,2>(x) = y;
+  FIELDVECTORREFTEST_ASSERT(x[2] == K(8) && x[3] == K(9));
+
+  int i = 0;
+  for (auto& xi : Dune::tail<3>(x))
+    xi = K(i++);
+  FIELDVECTORREFTEST_ASSERT(x[3] == K(0) && x[5] == K(2));
+}
+
+// the DenseVector algebra works on the views
+template<class K>
+void testAlgebra ()
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << " )" << std::endl;
+
+  auto x = makeVector<K>();
+  auto y = makeVector<K>();
+  const FieldVector<K,3> u = { 1, 2, 3 };
+  const FieldVector<K,3> v = { 4, 5, 6 };
+
+  FIELDVECTORREFTEST_ASSERT(Dune::head<3>(x) == u);
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x) != u);
+  FIELDVECTORREFTEST_ASSERT(Dune::head<3>(x) * Dune::tail<3>(x) == u * v);
+  FIELDVECTORREFTEST_ASSERT(Dune::head<3>(x).dot(Dune::tail<3>(y)) == u.dot(v));
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x).one_norm() == v.one_norm());
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x).two_norm() == v.two_norm());
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x).two_norm2() == v.two_norm2());
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x).infinity_norm() == v.infinity_norm());
+  FIELDVECTORREFTEST_ASSERT(Dune::tail<3>(x).infinity_norm_real() == v.infinity_norm_real());
+
+  Dune::head<3>(x).axpy(K(2), Dune::tail<3>(y));
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 9, 12, 15, 4, 5, 6 }));
+
+  Dune::tail<3>(x) += u;
+  Dune::tail<3>(x) -= K(1);
+  FIELDVECTORREFTEST_ASSERT((x == FieldVector<K,6>{ 9, 12, 15, 4, 6, 8 }));
+
+  // results of the arithmetic are owning vectors and leave the parent alone
+  x = makeVector<K>();
+  auto sum = Dune::head<3>(x) + Dune::tail<3>(x);
+  auto diff = Dune::tail<3>(x) - u;
+  auto neg = -Dune::head<3>(x);
+  auto scaled = K(2) * Dune::head<3>(x);
+  auto scaled2 = Dune::head<3>(x) * K(2);
+  auto quot = Dune::tail<3>(x) / K(2);
+  static_assert(std::is_same<decltype(sum), FieldVector<K,3> >::value, "");
+  static_assert(std::is_same<decltype(diff), FieldVector<K,3> >::value, "");
+  static_assert(std::is_same<decltype(neg), FieldVector<K,3> >::value, "");
+  FIELDVECTORREFTEST_ASSERT(sum == u + v);
+  FIELDVECTORREFTEST_ASSERT(diff == v - u);
+  FIELDVECTORREFTEST_ASSERT(neg == -u);
+  FIELDVECTORREFTEST_ASSERT(scaled == K(2) * u);
+  FIELDVECTORREFTEST_ASSERT(scaled2 == u * K(2));
+  FIELDVECTORREFTEST_ASSERT(quot == v / K(2));
+  FIELDVECTORREFTEST_ASSERT(x == makeVector<K>());
+
+  FieldVector<K,3> w = Dune::segment<2,3>(x);
+  FIELDVECTORREFTEST_ASSERT((w == FieldVector<K,3>{ 3, 4, 5 }));
+}
+
+// read-only views of const vectors
+template<class K>
+void testConstViews ()
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << " )" << std::endl;
+
+  const auto x = makeVector<K>();
+  auto s = Dune::segment<2,2>(x);
+  static_assert(std::is_same<decltype(s[0]), const K&>::value, "");
+  FIELDVECTORREFTEST_ASSERT(s[0] == K(3) && s[1] == K(4));
+  FIELDVECTORREFTEST_ASSERT(s.two_norm2() == K(25));
+  FIELDVECTORREFTEST_ASSERT(s.data() == x.data() + 2);
+
+  auto y = makeVector<K>();
+  FieldVectorRef<const K,3> t = Dune::tail<3>(y);
+  y[5] = K(0);
+  FIELDVECTORREFTEST_ASSERT(t[2] == K(0));
+
+  K sum = 0;
+  for (const auto& ti : t)
+    sum += ti;
+  FIELDVECTORREFTEST_ASSERT(sum == K(9));
+
+  std::ostringstream out, expected;
+  out << Dune::head<2>(x);
+  expected << FieldVector<K,2>{ 1, 2 };
+  FIELDVECTORREFTEST_ASSERT(out.str() == expected.str());
+}
+
+int main()
+{
+  testWriteThrough<double>();
+  testWriteThrough<int>();
+  testWriteThrough<std::complex<float> >();
+
+  testAlgebra<double>();
+  testAlgebra<float>();
+  testAlgebra<int>();
+
+  testConstViews<double>();
+  testConstViews<std::complex<double> >();
+
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include "config.h"
 #endif
 
+#include <cmath>
 #include <complex>
 #include <iostream>
 #include <limits>
@@ -12,8 +13,10 @@
 #include <type_traits>
 
 #include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
 #include <dune/common/exceptions.hh>
 #include <dune/common/fvector.hh>
+#include <dune/common/sizedispatch.hh>
 #include <dune/common/typetraits.hh>
 
 struct FVectorTestException : Dune::Exception {};
@@ -525,6 +528,303 @@ test_initialisation()
   FVECTORTEST_ASSERT(b[1] == 2);
 }
 
+// the compensated summation is exact for these ill-conditioned sums
+void
+test_compensated_summation()
+{
+  using Dune::Summation::Compensated;
+  using Dune::Summation::Naive;
+
+  const FieldVector<double,4> x = { 1e16, 1.0, -1e16, 1e-3 };
+  const FieldVector<double,4> one(1.0);
+  FVECTORTEST_ASSERT(x.dot<Naive>(one) == x.dot(one));
+  FVECTORTEST_ASSERT(x.dot<Compensated>(one) == 1.001);
+  FVECTORTEST_ASSERT(one.dot<Compensated>(x) == 1.001);
+
+  // products with a rounding error: (1+2^-30)^2 - 1 - 2^-29 = 2^-60
+  const double a = 1.0 + std::ldexp(1.0, -30);
+  const FieldVector<double,3> u = { a, -1.0, -std::ldexp(1.0, -29) };
+  const FieldVector<double,3> v = { a, 1.0, 1.0 };
+  FVECTORTEST_ASSERT(u.dot(v) == 0.0);
+  FVECTORTEST_ASSERT(u.dot<Compensated>(v) == std::ldexp(1.0, -60));
+
+  // squared norms
+  const FieldVector<double,2> w = { a, 1e-10 };
+  FVECTORTEST_ASSERT(w.two_norm2<Compensated>() == (a*a + 1e-20) + std::ldexp(1.0, -60));
+  FVECTORTEST_ASSERT(w.two_norm2<Naive>() == w.two_norm2());
+  FVECTORTEST_ASSERT(std::abs(w.two_norm<Compensated>() - w.two_norm()) <= 1e-15);
+
+  // complex entries, with the first argument being conjugated
+  typedef std::complex<double> ct;
+  const FieldVector<ct,3> cx = { ct(1e16, 1.0), ct(1.0, -1e16), ct(-1e16, 0.0) };
+  const FieldVector<ct,3> cy = { ct(1.0, 0.0), ct(0.0, 1.0), ct(1.0, 1.0) };
+  // conj(cx)*cy = (1e16 - i) + (-1e16 + i) + (-1e16 - 1e16 i)
+  const ct expected(-1e16, -1e16);
+  FVECTORTEST_ASSERT(cx.dot<Compensated>(cy) == cx.dot(cy));
+  FVECTORTEST_ASSERT(cx.dot<Compensated>(cy) == expected);
+  const FieldVector<ct,3> cc = { ct(1e16, -1e16), ct(1.0, 1.0), ct(-1e16, 1e16) };
+  FVECTORTEST_ASSERT(cc.dot<Compensated>(FieldVector<ct,3>(ct(1.0, 0.0))) == ct(1.0, -1.0));
+  const FieldVector<ct,2> cz = { ct(1e8, 1.0), ct(1e-8, 0.0) };
+  FVECTORTEST_ASSERT(cz.two_norm2<Compensated>() == 1e16 + 1.0);
+
+  // mixed real and complex
+  FVECTORTEST_ASSERT(x.dot<Compensated>(FieldVector<ct,4>(ct(0.0, 1.0))) == ct(0.0, 1.001));
+
+  // types without compensated kernels fall back to the naive summation
+  const FieldVector<int,3> i = { 1, 2, 3 };
+  FVECTORTEST_ASSERT(i.dot<Compensated>(i) == 14);
+  FVECTORTEST_ASSERT(i.two_norm2<Compensated>() == 14);
+}
+
+// the unrolled kernels give the same results as the loops for dynamic vectors
+template<class K, int SIZE>
+void
+test_unrolled_kernels()
+{
+  static_assert(Dune::Impl::DenseVectorStaticSize<FieldVector<K,SIZE> >::value == SIZE, "");
+
+  FieldVector<K,SIZE> x, y;
+  for (int i = 0; i < SIZE; ++i) {
+    x[i] = K(std::sin(1.0 + i)) / K(3);
+    y[i] = K(std::cos(2.0 * i)) * K(7);
+  }
+  const Dune::DynamicVector<K> dx(x), dy(y);
+  const K a = K(0.3);
+
+  FVECTORTEST_ASSERT(x.dot(y) == dx.dot(dy));
+  FVECTORTEST_ASSERT(x * y == dx * dy);
+  FVECTORTEST_ASSERT(x.one_norm() == dx.one_norm());
+  FVECTORTEST_ASSERT(x.one_norm_real() == dx.one_norm_real());
+  FVECTORTEST_ASSERT(x.two_norm2() == dx.two_norm2());
+  FVECTORTEST_ASSERT(x.infinity_norm() == dx.infinity_norm());
+  FVECTORTEST_ASSERT(x.infinity_norm_real() == dx.infinity_norm_real());
+
+  FieldVector<K,SIZE> z(x);
+  Dune::DynamicVector<K> dz(dx);
+  z.axpy(a, y);   dz.axpy(a, dy);
+  z += y;         dz += dy;
+  z -= x;         dz -= dx;
+  z *= a;         dz *= a;
+  z /= K(3);      dz /= K(3);
+  z += a;         dz += a;
+  FVECTORTEST_ASSERT(z == dz);
+  FVECTORTEST_ASSERT(-z == -dz);
+  dz *= a;
+  FVECTORTEST_ASSERT(z * a == dz);
+  FVECTORTEST_ASSERT(z != x);
+  z = dx;
+  FVECTORTEST_ASSERT(z == x);
+}
+
+// the flattened kernels of nested FieldVectors give the same results as the block recursion
+template<class K, int m, int n>
+void
+test_flat_kernels()
+{
+  typedef FieldVector<K,m> Block;
+  typedef FieldVector<Block,n> Vector;
+  static_assert(Dune::Impl::DenseVectorFlatStorage<Vector>::value == (n*m <= 16), "");
+
+  Vector x, y;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < m; ++j) {
+      x[i][j] = K(std::sin(1.0 + i*m + j)) / K(3);
+      y[i][j] = K(std::cos(2.0 * (i*m + j))) * K(7);
+    }
+  const K a = K(0.3);
+
+  Vector z(x);
+  z.axpy(a, y);
+  z += y;
+  z -= x;
+  z *= a;
+  z /= K(3);
+  for (int i = 0; i < n; ++i) {
+    Block b(x[i]);
+    b.axpy(a, y[i]);
+    b += y[i];
+    b -= x[i];
+    b *= a;
+    b /= K(3);
+    FVECTORTEST_ASSERT(z[i] == b);
+  }
+
+  K dot(0), tdot(0), norm2(0);
+  for (int i = 0; i < n; ++i) {
+    dot += x[i].dot(y[i]);
+    tdot += x[i] * y[i];
+    norm2 += x[i].two_norm2();
+  }
+  FVECTORTEST_ASSERT(x.dot(y) == dot);
+  FVECTORTEST_ASSERT(x * y == tdot);
+  FVECTORTEST_ASSERT(x.two_norm2() == norm2);
+
+  z = x;
+  z.axpy(a, z);
+  z += z;
+  for (int i = 0; i < n; ++i) {
+    Block b(x[i]);
+    b.axpy(a, b);
+    b += b;
+    FVECTORTEST_ASSERT(z[i] == b);
+  }
+}
+
+void
+test_size_dispatch()
+{
+  static_assert(std::is_same<Dune::SizeRange<2,4>, Dune::SizeList<2,3,4> >::value, "");
+
+  auto size = [](auto n) { return decltype(n)::value; };
+  auto dynamic = [](std::size_t n) { return -int(n); };
+  for (std::size_t n : { 1, 2, 3, 5, 8 })
+    FVECTORTEST_ASSERT(Dune::dispatchSize(Dune::SizeRange<1,8>{}, n, size, dynamic) == int(n));
+  FVECTORTEST_ASSERT(Dune::dispatchSize(Dune::SizeRange<1,8>{}, 9, size, dynamic) == -9);
+  FVECTORTEST_ASSERT(Dune::dispatchSize(Dune::SizeList<2,7>{}, 3, size, dynamic) == -3);
+  FVECTORTEST_ASSERT(Dune::dispatchSize(Dune::SizeList<>{}, 1, size, dynamic) == -1);
+
+  // the same computation with static and dynamic vectors
+  for (std::size_t n = 1; n <= 6; ++n) {
+    bool isStatic = false;
+    const double norm = Dune::dispatchFieldVector<double>(Dune::SizeRange<1,4>{}, n,
+      [&](auto meta) {
+        using Vector = typename decltype(meta)::type;
+        static_assert(Vector::dimension >= 1 && Vector::dimension <= 4, "");
+        isStatic = true;
+        Vector x(2.0);
+        return x.two_norm2();
+      },
+      [&](auto meta) {
+        using Vector = typename decltype(meta)::type;
+        static_assert(std::is_same<Vector, Dune::DynamicVector<double> >::value, "");
+        Vector x(n, 2.0);
+        return x.two_norm2();
+      });
+    FVECTORTEST_ASSERT(norm == 4.0*n);
+    FVECTORTEST_ASSERT(isStatic == (n <= 4));
+  }
+}
+
+// the complex kernels agree with the complex arithmetic up to rounding
+template<class Vector>
+void
+test_complex_kernels(Vector x)
+{
+  typedef typename Vector::value_type C;
+  typedef typename C::value_type K;
+  const std::size_t n = x.size();
+  Vector y(x);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = C(std::sin(1.0 + i), std::cos(3.0 * i));
+    y[i] = C(0.5 - i, std::sin(2.0 * i));
+  }
+
+  C dot(0), tdot(0);
+  K abs2(0), abs(0);
+  for (std::size_t i = 0; i < n; ++i) {
+    dot += std::conj(x[i]) * y[i];
+    tdot += x[i] * y[i];
+    abs2 += std::norm(x[i]);
+    abs += std::abs(x[i]);
+  }
+  const K tol = 16 * std::numeric_limits<K>::epsilon() * (1 + n);
+  FVECTORTEST_ASSERT(std::abs(x.dot(y) - dot) <= tol * std::abs(dot) + tol);
+  FVECTORTEST_ASSERT(std::abs(x * y - tdot) <= tol * std::abs(tdot) + tol);
+  FVECTORTEST_ASSERT(std::abs(x.two_norm2() - abs2) <= tol * abs2);
+  FVECTORTEST_ASSERT(std::abs(x.two_norm() - std::sqrt(abs2)) <= tol * std::sqrt(abs2));
+  FVECTORTEST_ASSERT(x.template one_norm<Dune::ComplexAbs::Hypot>() == x.one_norm());
+  FVECTORTEST_ASSERT(std::abs(x.template one_norm<Dune::ComplexAbs::Fast>() - abs) <= tol * abs);
+
+  const C a(0.25, -2.0);
+  Vector z(y);
+  z.axpy(a, x);
+  for (std::size_t i = 0; i < n; ++i)
+    FVECTORTEST_ASSERT(std::abs(z[i] - (y[i] + a * x[i])) <= tol * std::abs(z[i]) + tol);
+
+  // the hypot-based absolute value does not overflow
+  const K huge = std::numeric_limits<K>::max() / K(4*n);
+  x = C(huge, huge);
+  FVECTORTEST_ASSERT(std::isfinite(x.template one_norm<Dune::ComplexAbs::Hypot>()));
+  FVECTORTEST_ASSERT(!std::isfinite(x.template one_norm<Dune::ComplexAbs::Fast>()));
+}
+
+// a number which counts its copies, standing in for multiprecision numbers
+struct CopyCountingNumber
+{
+  static int copies;
+
+  CopyCountingNumber (double v = 0) : value(v) {}
+  CopyCountingNumber (const CopyCountingNumber& other) : value(other.value) { ++copies; }
+  CopyCountingNumber (CopyCountingNumber&&) = default;
+  CopyCountingNumber& operator= (const CopyCountingNumber& other) { value = other.value; ++copies; return *this; }
+  CopyCountingNumber& operator= (CopyCountingNumber&&) = default;
+
+  CopyCountingNumber& operator+= (const CopyCountingNumber& other) { value += other.value; return *this; }
+  CopyCountingNumber& operator-= (const CopyCountingNumber& other) { value -= other.value; return *this; }
+  CopyCountingNumber& operator*= (const CopyCountingNumber& other) { value *= other.value; return *this; }
+  CopyCountingNumber& operator/= (const CopyCountingNumber& other) { value /= other.value; return *this; }
+
+  friend CopyCountingNumber operator+ (const CopyCountingNumber& a, const CopyCountingNumber& b) { return a.value + b.value; }
+  friend CopyCountingNumber operator- (const CopyCountingNumber& a, const CopyCountingNumber& b) { return a.value - b.value; }
+  friend CopyCountingNumber operator* (const CopyCountingNumber& a, const CopyCountingNumber& b) { return a.value * b.value; }
+  friend CopyCountingNumber operator- (const CopyCountingNumber& a) { return -a.value; }
+  friend bool operator== (const CopyCountingNumber& a, const CopyCountingNumber& b) { return a.value == b.value; }
+  friend bool operator!= (const CopyCountingNumber& a, const CopyCountingNumber& b) { return a.value != b.value; }
+
+  double value;
+};
+
+int CopyCountingNumber::copies = 0;
+
+namespace Dune {
+  template<>
+  struct IsNumber<CopyCountingNumber> : std::true_type {};
+}
+
+// arithmetic on temporary vectors reuses their entries instead of copying
+template<class Vector>
+void
+test_move_arithmetic(const Vector& a, const Vector& b)
+{
+  typedef CopyCountingNumber N;
+  std::cout << __func__ << "\t ( " << Dune::className<Vector>() << " )" << std::endl;
+  const int n = a.size();
+
+  // only sums and differences of two lvalues copy one of them
+  N::copies = 0;
+  Vector c = a + b;
+  FVECTORTEST_ASSERT(N::copies == n);
+  N::copies = 0;
+  Vector d = ((a + b) - a + (b - a)) - (a - b);
+  FVECTORTEST_ASSERT(N::copies == 3*n);
+  FVECTORTEST_ASSERT(d[0].value == 4.0);
+  N::copies = 0;
+  Vector e = a - (b + c) - (-(c - a));
+  FVECTORTEST_ASSERT(N::copies == 2*n);
+  FVECTORTEST_ASSERT(e[n-1].value == -2.0);
+
+  // moves do not copy
+  N::copies = 0;
+  Vector f(std::move(c));
+  c = std::move(f);
+  FVECTORTEST_ASSERT(N::copies == 0);
+  FVECTORTEST_ASSERT(c[0].value == 3.0);
+}
+
+template<int SIZE>
+void
+test_move_scalar_arithmetic()
+{
+  typedef CopyCountingNumber N;
+  const FieldVector<N,SIZE> a(N(1.0)), b(N(2.0));
+
+  N::copies = 0;
+  FieldVector<N,SIZE> c = N(3.0) * ((a + b) * N(2.0) / N(6.0));
+  FVECTORTEST_ASSERT(N::copies == SIZE);
+  FVECTORTEST_ASSERT(c[SIZE-1].value == 3.0);
+  FVECTORTEST_ASSERT(c == a * N(3.0));
+}
+
 void fieldvectorMathclassifiersTest() {
   double nan = std::nan("");
   double inf = std::numeric_limits<double>::infinity();
@@ -563,5 +863,28 @@ int main()
     }
     test_infinity_norms();
     test_initialisation();
+    test_compensated_summation();
+    test_size_dispatch();
+    test_unrolled_kernels<double,2>();
+    test_unrolled_kernels<double,3>();
+    test_unrolled_kernels<float,7>();
+    test_unrolled_kernels<double,16>();
+    test_unrolled_kernels<double,17>();
+    test_unrolled_kernels<std::complex<double>,4>();
+    test_flat_kernels<double,3,4>();
+    test_flat_kernels<double,8,2>();
+    test_flat_kernels<float,4,3>();
+    test_flat_kernels<int,2,3>();
+    test_flat_kernels<double,4,8>();
+    test_complex_kernels(FieldVector<std::complex<double>,1>());
+    test_complex_kernels(FieldVector<std::complex<double>,7>());
+    test_complex_kernels(FieldVector<std::complex<float>,8>());
+    for (std::size_t n : { 2, 5, 33 })
+      test_complex_kernels(Dune::DynamicVector<std::complex<double> >(n));
+    test_move_arithmetic(FieldVector<CopyCountingNumber,3>(1.0), FieldVector<CopyCountingNumber,3>(2.0));
+    test_move_arithmetic(FieldVector<CopyCountingNumber,1>(1.0), FieldVector<CopyCountingNumber,1>(2.0));
+    test_move_arithmetic(Dune::DynamicVector<CopyCountingNumber>(4, 1.0), Dune::DynamicVector<CopyCountingNumber>(4, 2.0));
+    test_move_scalar_arithmetic<3>();
+    test_move_scalar_arithmetic<20>();
   }
 }
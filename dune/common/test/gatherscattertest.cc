@@ -0,0 +1,177 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <dune/common/blockvector.hh>
+#include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/gatherscatter.hh>
+#include <dune/common/loopsimd.hh>
+
+struct GatherScatterTestException : Dune::Exception {};
+
+#define GATHERSCATTERTEST_ASSERT(EXPR)                      \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(GatherScatterTestException,                  \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::FieldVector;
+using Dune::LoopSIMD;
+
+template<class K, int b>
+std::vector<FieldVector<K,b> > makeBlocks (std::size_t size)
+{
+  std::vector<FieldVector<K,b> > v(size);
+  for (std::size_t i = 0; i < size; ++i)
+    for (int j = 0; j < b; ++j)
+      v[i][j] = K(std::sin(0.37*(b*i + j) + 1) * (1 + (i + j) % 13));
+  return v;
+}
+
+// random indices, with repetitions
+template<class I>
+std::vector<I> makeIndices (std::size_t n, std::size_t size, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<std::size_t> dist(0, size-1);
+  std::vector<I> indices(n);
+  for (auto& i : indices)
+    i = I(dist(rng));
+  return indices;
+}
+
+// gather, scatter and scatter-add of blocks agree with the loops over the indices
+template<class K, int b, class I>
+void testBlocks (std::size_t n)
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << ", " << b
+            << ", " << Dune::className<I>() << " )" << std::endl;
+
+  const std::size_t size = 97;
+  const auto global = makeBlocks<K,b>(size);
+  const auto indices = makeIndices<I>(n, size, 1);
+  const auto local = makeBlocks<K,b>(n);
+
+  std::vector<FieldVector<K,b> > gathered(n);
+  Dune::gather(global, indices, gathered);
+  for (std::size_t k = 0; k < n; ++k)
+    GATHERSCATTERTEST_ASSERT(gathered[k] == global[indices[k]]);
+
+  // the scatter leaves the last block of repeated indices
+  auto scattered = global, expected = global;
+  Dune::scatter(scattered, indices, local);
+  for (std::size_t k = 0; k < n; ++k)
+    expected[indices[k]] = local[k];
+  GATHERSCATTERTEST_ASSERT(scattered == expected);
+
+  // the scatter-add adds in the order of the indices, so the sums are exact
+  auto added = global;
+  expected = global;
+  Dune::scatterAdd(added, indices, local);
+  for (std::size_t k = 0; k < n; ++k)
+    expected[indices[k]] += local[k];
+  GATHERSCATTERTEST_ASSERT(added == expected);
+}
+
+// element-local buffers of fixed size and BlockVectors
+void testElementBuffers ()
+{
+  std::cout << __func__ << std::endl;
+
+  Dune::BlockVector<FieldVector<double,2> > u = { { 1, 2 }, { 3, 4 }, { 5, 6 }, { 7, 8 } };
+  const std::array<int,3> dofs = { 3, 0, 2 };
+  FieldVector<FieldVector<double,2>,3> uLocal;
+  Dune::gather(u, dofs, uLocal);
+  GATHERSCATTERTEST_ASSERT((uLocal[0] == FieldVector<double,2>{ 7, 8 }));
+  GATHERSCATTERTEST_ASSERT((uLocal[2] == FieldVector<double,2>{ 5, 6 }));
+
+  uLocal *= 2.0;
+  Dune::scatterAdd(u, dofs, uLocal);
+  GATHERSCATTERTEST_ASSERT((u[3] == FieldVector<double,2>{ 21, 24 }));
+  GATHERSCATTERTEST_ASSERT((u[1] == FieldVector<double,2>{ 3, 4 }));
+
+  Dune::scatter(u, std::array<unsigned int,1>{ 1 }, uLocal);
+  GATHERSCATTERTEST_ASSERT((u[1] == FieldVector<double,2>{ 14, 16 }));
+
+  // scalar entries
+  std::vector<float> g = { 0, 1, 2, 3, 4, 5 };
+  Dune::DynamicVector<float> l(3);
+  Dune::gather(g, std::vector<long>{ 5, 1, 5 }, l);
+  GATHERSCATTERTEST_ASSERT((l == Dune::DynamicVector<float>{ 5, 1, 5 }));
+  Dune::scatterAdd(g, std::vector<long>{ 0, 0, 2 }, l);
+  GATHERSCATTERTEST_ASSERT(g[0] == 6 && g[2] == 7);
+
+  // empty index lists
+  Dune::gather(g, std::vector<int>{}, l);
+  Dune::scatterAdd(g, std::vector<int>{}, l);
+  GATHERSCATTERTEST_ASSERT(g[0] == 6);
+}
+
+// transposing gathers and scatters into the lanes of LoopSIMDs
+template<class K, std::size_t W, int b, class I>
+void testLanes (std::size_t n)
+{
+  std::cout << __func__ << "\t ( " << Dune::className<K>() << ", " << W << ", " << b
+            << ", " << Dune::className<I>() << " )" << std::endl;
+
+  const std::size_t size = 1000;
+  auto global = makeBlocks<K,b>(size);
+  const auto indices = makeIndices<I>(n, size, 2);
+
+  FieldVector<LoopSIMD<K,W>,b> local(K(-1));
+  Dune::gather(global, indices, local);
+  for (std::size_t k = 0; k < W; ++k)
+    for (int j = 0; j < b; ++j)
+      GATHERSCATTERTEST_ASSERT(local[j][k] == (k < n ? global[indices[k]][j] : K(-1)));
+
+  local *= K(2);
+  const auto global0 = global;
+  Dune::scatterAdd(global, indices, local);
+  auto expected = global0;
+  for (std::size_t k = 0; k < n; ++k)
+    for (int j = 0; j < b; ++j)
+      expected[indices[k]][j] += local[j][k];
+  GATHERSCATTERTEST_ASSERT(global == expected);
+
+  Dune::scatter(global, indices, local);
+  for (std::size_t k = 0; k < n; ++k)
+    for (int j = 0; j < b; ++j)
+      expected[indices[k]][j] = local[j][k];
+  GATHERSCATTERTEST_ASSERT(global == expected);
+}
+
+int main()
+{
+  testBlocks<double,3,int>(1000);
+  testBlocks<double,3,std::size_t>(10);
+  testBlocks<float,4,unsigned int>(100);
+  testBlocks<double,1,int>(0);
+
+  testElementBuffers();
+
+  // full, partial and unaligned lanes, with and without hardware gathers
+  testLanes<double,8,3,int>(8);
+  testLanes<double,8,3,int>(5);
+  testLanes<double,16,2,std::int32_t>(16);
+  testLanes<float,16,3,int>(16);
+  testLanes<float,32,3,unsigned int>(27);
+  testLanes<double,4,3,int>(4);
+  testLanes<double,8,3,std::size_t>(8);
+  testLanes<double,3,5,int>(3);
+  testLanes<int,8,2,int>(8);
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+#include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/loopsimd.hh>
+
+struct LoopSIMDTestException : Dune::Exception {};
+
+#define LOOPSIMDTEST_ASSERT(EXPR)                           \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(LoopSIMDTestException,                       \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::LoopSIMD;
+
+static_assert(Dune::IsNumber<LoopSIMD<double,4> >::value, "");
+static_assert(Dune::HasNaN<LoopSIMD<float,8> >::value, "");
+static_assert(!Dune::HasNaN<LoopSIMD<int,8> >::value, "");
+static_assert(std::is_same<Dune::FieldTraits<LoopSIMD<double,4> >::real_type, LoopSIMD<double,4> >::value, "");
+static_assert(std::is_same<Dune::PromotionTraits<LoopSIMD<float,4>, double>::PromotedType, LoopSIMD<double,4> >::value, "");
+static_assert(alignof(LoopSIMD<double,4>) == 32, "");
+
+void testLanes ()
+{
+  typedef LoopSIMD<double,4> S;
+  S a;
+  for (std::size_t l = 0; l < S::size(); ++l)
+    a[l] = double(l) - 1.5;
+  const S b = 2.0;
+
+  S c = a*b + 1.0;
+  LOOPSIMDTEST_ASSERT(c[0] == -2.0 && c[3] == 4.0);
+  c -= b;
+  c /= S(0.5);
+  LOOPSIMDTEST_ASSERT(c[1] == -4.0);
+  LOOPSIMDTEST_ASSERT(allTrue(-(-a) == a));
+
+  // lane-wise comparisons and selection
+  const auto m = a < 0.0;
+  LOOPSIMDTEST_ASSERT(m[0] && m[1] && !m[2] && !m[3]);
+  LOOPSIMDTEST_ASSERT(anyTrue(m) && !allTrue(m));
+  LOOPSIMDTEST_ASSERT(allTrue(m || !m) && !anyTrue(m && !m));
+  LOOPSIMDTEST_ASSERT(allTrue(cond(m, -a, a) == abs(a)));
+  LOOPSIMDTEST_ASSERT(allTrue(max(a, S(0.0)) >= 0.0) && allTrue(min(a, S(0.0)) <= 0.0));
+
+  std::stringstream s;
+  s << S(1);
+  LOOPSIMDTEST_ASSERT(s.str() == "<1, 1, 1, 1>");
+}
+
+// a FieldVector of SIMD entries computes the same as one FieldVector per lane
+template<class T, std::size_t W, int N>
+void testFieldVector ()
+{
+  typedef LoopSIMD<T,W> S;
+  Dune::FieldVector<S,N> x, y;
+  Dune::FieldVector<T,N> xl[W], yl[W];
+  for (int i = 0; i < N; ++i)
+    for (std::size_t l = 0; l < W; ++l) {
+      xl[l][i] = x[i][l] = T(std::sin(1.0 + i + 3*l));
+      yl[l][i] = y[i][l] = T(std::cos(2.0 * i - l));
+    }
+
+  std::cout << __func__ << "\t ( " << Dune::className(x) << " )" << std::endl;
+
+  const S a = T(0.75);
+  Dune::FieldVector<S,N> z(x);
+  z.axpy(a, y);
+  z *= T(2);
+  z -= y;
+
+  const S dot = x.dot(y);
+  const S one = x.one_norm();
+  const S two = z.two_norm();
+  const S inf = z.infinity_norm();
+  for (std::size_t l = 0; l < W; ++l) {
+    Dune::FieldVector<T,N> zl(xl[l]);
+    zl.axpy(T(0.75), yl[l]);
+    zl *= T(2);
+    zl -= yl[l];
+    LOOPSIMDTEST_ASSERT(dot[l] == xl[l].dot(yl[l]));
+    LOOPSIMDTEST_ASSERT(one[l] == xl[l].one_norm());
+    LOOPSIMDTEST_ASSERT(two[l] == zl.two_norm());
+    LOOPSIMDTEST_ASSERT(inf[l] == zl.infinity_norm());
+    for (int i = 0; i < N; ++i)
+      LOOPSIMDTEST_ASSERT(z[i][l] == zl[i]);
+  }
+
+  // vectors are equal if they agree in all lanes
+  LOOPSIMDTEST_ASSERT(z == z && x != y);
+  Dune::FieldVector<S,N> w(x);
+  w[N-1][W-1] += T(1);
+  LOOPSIMDTEST_ASSERT(w != x);
+
+  // NaN propagates into the lane it occurs in only
+  if constexpr (std::numeric_limits<T>::has_quiet_NaN) {
+    w[0][0] = std::numeric_limits<T>::quiet_NaN();
+    const auto mask = isnan(w.infinity_norm());
+    LOOPSIMDTEST_ASSERT(mask[0]);
+    for (std::size_t l = 1; l < W; ++l)
+      LOOPSIMDTEST_ASSERT(!mask[l]);
+  }
+
+  // vectors of dynamic size work as well
+  Dune::DynamicVector<S> dx(x);
+  LOOPSIMDTEST_ASSERT(allTrue(dx.two_norm2() == x.two_norm2()));
+}
+
+int main()
+{
+  std::cout << "backend: " << (DUNE_LOOPSIMD_STD_SIMD ? "std::experimental::simd" : "loops") << std::endl;
+  testLanes();
+  testFieldVector<double,4,3>();
+  testFieldVector<double,8,5>();
+  testFieldVector<float,16,2>();
+  testFieldVector<double,3,4>();
+  testFieldVector<int,4,3>();
+  return 0;
+}
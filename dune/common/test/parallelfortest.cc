@@ -0,0 +1,184 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parallelfor.hh>
+#include <dune/common/threadpool.hh>
+
+struct ParallelForTestException : Dune::Exception {};
+
+#define PARALLELFORTEST_ASSERT(EXPR)                        \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(ParallelForTestException,                    \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+// every index is visited exactly once
+void testIndexRange (Dune::ThreadPool& pool, const Dune::ParallelOptions& options)
+{
+  const std::size_t n = 10007;
+  std::vector<std::atomic<int> > visits(n);
+  Dune::parallelFor(pool, std::size_t(0), n, [&](std::size_t i) { ++visits[i]; }, options);
+  for (auto& v : visits)
+    PARALLELFORTEST_ASSERT(v == 1);
+
+  // the default backend
+  std::vector<std::atomic<int> > defaultVisits(n);
+  Dune::parallelFor(std::size_t(0), n, [&](std::size_t i) { ++defaultVisits[i]; }, options);
+  for (auto& v : defaultVisits)
+    PARALLELFORTEST_ASSERT(v == 1);
+}
+
+void testIteratorRange (Dune::ThreadPool& pool)
+{
+  std::vector<long> values(5000);
+  std::iota(values.begin(), values.end(), 0);
+
+  Dune::parallelFor(pool, values.begin(), values.end(), [](long& v) { v *= 2; });
+  for (std::size_t i = 0; i < values.size(); ++i)
+    PARALLELFORTEST_ASSERT(values[i] == 2*long(i));
+
+  Dune::parallelFor(values.begin(), values.end(), [](long& v) { v /= 2; });
+  for (std::size_t i = 0; i < values.size(); ++i)
+    PARALLELFORTEST_ASSERT(values[i] == long(i));
+
+  auto plus = [](long a, long b) { return a+b; };
+  const long expected = long(values.size())*long(values.size()-1)/2;
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(pool, values.cbegin(), values.cend(), 0l,
+                                              [](long v) { return v; }, plus) == expected);
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(values.cbegin(), values.cend(), 0l,
+                                              [](long v) { return v; }, plus) == expected);
+}
+
+void testReduce (Dune::ThreadPool& pool, const Dune::ParallelOptions& options)
+{
+  const long n = 100000;
+  auto plus = [](long a, long b) { return a+b; };
+  auto square = [](long i) { return i*i; };
+  long expected = 0;
+  for (long i = 0; i < n; ++i)
+    expected += i*i;
+
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(pool, 0l, n, 0l, square, plus, options) == expected);
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(0l, n, 0l, square, plus, options) == expected);
+
+  // a non-trivial identity
+  auto maximum = [](long a, long b) { return std::max(a,b); };
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(pool, 0l, n, -1l, [](long i) { return i; }, maximum, options) == n-1);
+
+  // empty ranges return the identity
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(pool, n, n, 42l, square, plus, options) == 42);
+  PARALLELFORTEST_ASSERT(Dune::parallelReduce(n, n, 42l, square, plus, options) == 42);
+}
+
+// the partial results are combined in the order of the range
+void testReduceOrder (Dune::ThreadPool& pool, const Dune::ParallelOptions& options)
+{
+  const int n = 500;
+  std::string expected;
+  for (int i = 0; i < n; ++i)
+    expected += char('a' + i % 26);
+
+  auto letter = [](int i) { return std::string(1, char('a' + i % 26)); };
+  auto concat = [](const std::string& a, const std::string& b) { return a + b; };
+  for (int run = 0; run < 20; ++run) {
+    PARALLELFORTEST_ASSERT(Dune::parallelReduce(pool, 0, n, std::string(), letter, concat, options) == expected);
+    PARALLELFORTEST_ASSERT(Dune::parallelReduce(0, n, std::string(), letter, concat, options) == expected);
+  }
+}
+
+void testGrainSize (Dune::ThreadPool& pool)
+{
+  Dune::ParallelOptions options;
+  options.grainSize = 64;
+
+  std::atomic<std::size_t> maxChunk(0), covered(0);
+  Dune::parallelForChunks(pool, 0, 10000, [&](int first, int last) {
+      std::size_t size = last - first;
+      std::size_t current = maxChunk;
+      while (size > current && !maxChunk.compare_exchange_weak(current, size)) {}
+      covered += size;
+    }, options);
+  PARALLELFORTEST_ASSERT(maxChunk <= options.grainSize);
+  PARALLELFORTEST_ASSERT(covered == 10000);
+}
+
+void testThreadLimit (Dune::ThreadPool& pool)
+{
+  Dune::ParallelOptions options;
+  options.numThreads = 2;
+  options.grainSize = 1;
+
+  std::mutex mutex;
+  std::set<std::size_t> threads;
+  Dune::parallelFor(pool, 0, 1000, [&](int) {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(pool.threadIndex());
+    }, options);
+  PARALLELFORTEST_ASSERT(threads.size() <= 2);
+}
+
+void testNested (Dune::ThreadPool& pool)
+{
+  std::atomic<long> sum(0);
+  Dune::parallelFor(pool, 0, 50, [&](int i) {
+      Dune::parallelFor(pool, 0, 50, [&](int j) { sum += i*j; });
+    });
+  PARALLELFORTEST_ASSERT(sum == (49*50/2)*(49*50/2));
+}
+
+void testException (Dune::ThreadPool& pool)
+{
+  bool caught = false;
+  try {
+    Dune::parallelFor(pool, 0, 1000, [](int i) {
+        if (i == 517)
+          throw std::runtime_error("expected");
+      });
+  }
+  catch (std::runtime_error&) {
+    caught = true;
+  }
+  PARALLELFORTEST_ASSERT(caught);
+}
+
+int main()
+{
+  for (std::size_t concurrency : {1, 2, 4}) {
+    std::cout << "testing a pool of concurrency " << concurrency << std::endl;
+    Dune::ThreadPool pool(concurrency);
+    PARALLELFORTEST_ASSERT(pool.concurrency() == concurrency);
+
+    testIndexRange(pool, {});
+    testIndexRange(pool, {16, 0});
+    testIndexRange(pool, {0, 3});
+    testIteratorRange(pool);
+    testReduce(pool, {});
+    testReduce(pool, {100, 2});
+    testReduceOrder(pool, {1, 0});
+    testReduceOrder(pool, {7, 2});
+    testGrainSize(pool);
+    testThreadLimit(pool);
+    testNested(pool);
+    testException(pool);
+  }
+
+  PARALLELFORTEST_ASSERT(Dune::parallelConcurrency() >= 1);
+  PARALLELFORTEST_ASSERT(Dune::parallelThreadIndex() < Dune::parallelConcurrency());
+
+  return 0;
+}
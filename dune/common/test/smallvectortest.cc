@@ -0,0 +1,166 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <complex>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <dune/common/classname.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/smallvector.hh>
+#include <dune/common/typetraits.hh>
+
+struct SmallVectorTestException : Dune::Exception {};
+
+#define SMALLVECTORTEST_ASSERT(EXPR)                        \
+  if(!(EXPR)) {                                             \
+    DUNE_THROW(SmallVectorTestException,                    \
+               "Test assertion " << #EXPR << " failed");    \
+  }                                                         \
+  static_assert(true, "enforce terminating ;")
+
+using Dune::SmallVector;
+
+static_assert(Dune::IsTriviallyRelocatable<SmallVector<double,4> >::value, "");
+static_assert(Dune::IsTriviallyRelocatable<SmallVector<std::complex<double>,4> >::value, "");
+static_assert(!Dune::IsTriviallyRelocatable<SmallVector<std::string,4> >::value, "");
+
+template<class ft, int N>
+void testSmallVector (std::size_t d)
+{
+  typedef SmallVector<ft,N> Vector;
+  ft a = 1;
+  Vector v(d,1);
+  Vector w(d,2);
+  Vector z(d);
+  SMALLVECTORTEST_ASSERT(v.size() == d);
+  SMALLVECTORTEST_ASSERT(v.onHeap() == (d > std::size_t(N)));
+  SMALLVECTORTEST_ASSERT(z.two_norm2() == ft(0));
+
+  std::cout << __func__ << "\t ( " << Dune::className(v) << ", size " << d << " )" << std::endl;
+
+  // vector space operations of DenseVector
+  z = v + w;
+  SMALLVECTORTEST_ASSERT(z[d-1] == ft(3));
+  z = v - w;
+  SMALLVECTORTEST_ASSERT(z[0] == ft(-1));
+  z = -v;
+  SMALLVECTORTEST_ASSERT(z.size() == d && z[0] == ft(-1));
+  w *= a;
+  SMALLVECTORTEST_ASSERT(v.dot(w) == ft(2*d));
+  z = v;
+  z.axpy(a,w);
+  SMALLVECTORTEST_ASSERT(z[0] == ft(3));
+  SMALLVECTORTEST_ASSERT(v != w && v == v);
+
+  // copies and moves
+  Vector c(w);
+  SMALLVECTORTEST_ASSERT(c == w);
+  const ft* heapData = c.data();
+  Vector m(std::move(c));
+  SMALLVECTORTEST_ASSERT(m == w && c.size() == 0);
+  SMALLVECTORTEST_ASSERT(m.onHeap() == (m.data() == heapData));
+  c = std::move(m);
+  SMALLVECTORTEST_ASSERT(c == w);
+  m = v;
+  SMALLVECTORTEST_ASSERT(m == v);
+
+  // conversion from and to other dense vectors
+  Dune::DynamicVector<ft> dyn(w);
+  Vector fromDyn(dyn);
+  SMALLVECTORTEST_ASSERT(fromDyn == w);
+
+  // istream
+  std::stringstream s;
+  for (std::size_t i = 0; i < d; ++i) {
+    s << i << " ";
+    v[i] = ft(i);
+  }
+  s >> w;
+  SMALLVECTORTEST_ASSERT(v == w);
+}
+
+template<int N>
+void testResize ()
+{
+  SmallVector<double,N> v;
+  SMALLVECTORTEST_ASSERT(v.empty() && v.capacity() == std::size_t(N) && !v.onHeap());
+
+  v.resize(N, 1.0);
+  SMALLVECTORTEST_ASSERT(!v.onHeap() && v.one_norm() == N);
+
+  // overflow to the heap and back into a small vector
+  v.resize(3*N+1, 2.0);
+  SMALLVECTORTEST_ASSERT(v.onHeap() && v.size() == std::size_t(3*N+1));
+  SMALLVECTORTEST_ASSERT(v[N-1] == 1.0 && v[N] == 2.0 && v[3*N] == 2.0);
+  v.resize(1);
+  SMALLVECTORTEST_ASSERT(v.size() == 1 && v[0] == 1.0);
+
+  SmallVector<double,N> small(N, 5.0);
+  v = small;
+  SMALLVECTORTEST_ASSERT(v == small && v.onHeap());
+  small = std::move(v);
+  SMALLVECTORTEST_ASSERT(small.onHeap() && small[N-1] == 5.0);
+  SMALLVECTORTEST_ASSERT(!v.onHeap() && v.empty());
+}
+
+// entries which are not trivially copyable are constructed and destroyed properly
+void testNonTrivialEntries ()
+{
+  SmallVector<std::string,2> v(2, "inline");
+  v.resize(5, "heap");
+  SMALLVECTORTEST_ASSERT(v[1] == "inline" && v[4] == "heap");
+  SmallVector<std::string,2> w(v);
+  v.resize(1);
+  SmallVector<std::string,2> u(std::move(w));
+  SMALLVECTORTEST_ASSERT(u.size() == 5 && u[0] == "inline" && w.size() == 0);
+  w = u;
+  u = std::move(v);
+  SMALLVECTORTEST_ASSERT(u.size() == 1 && w.size() == 5);
+}
+
+// relocating the bytes of a vector gives a valid vector, both with inline and heap storage
+void testRelocation (std::size_t d)
+{
+  typedef SmallVector<double,4> Vector;
+  alignas(Vector) unsigned char buffer[sizeof(Vector)];
+  ::new (static_cast<void*>(buffer)) Vector(d, 3.0);
+
+  alignas(Vector) unsigned char relocated[sizeof(Vector)];
+  std::memcpy(relocated, buffer, sizeof(Vector));
+  Vector* v = std::launder(reinterpret_cast<Vector*>(relocated));
+
+  SMALLVECTORTEST_ASSERT(v->size() == d && v->one_norm() == 3.0*d);
+  v->resize(d+5, 1.0);
+  SMALLVECTORTEST_ASSERT(v->one_norm() == 3.0*d + 5.0);
+  v->~Vector();
+}
+
+int main()
+{
+  testSmallVector<double,4>(3);
+  testSmallVector<double,4>(4);
+  testSmallVector<double,4>(27);
+  testSmallVector<float,27>(27);
+  testSmallVector<int,1>(5);
+  testSmallVector<std::complex<double>,8>(2);
+  testSmallVector<std::complex<double>,2>(8);
+
+  testResize<1>();
+  testResize<8>();
+  testNonTrivialEntries();
+  testRelocation(2);
+  testRelocation(10);
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/threadpool.hh>
+
+namespace Dune {
+
+  thread_local const ThreadPool* ThreadPool::currentPool_ = nullptr;
+  thread_local std::size_t ThreadPool::currentIndex_ = 0;
+
+  ThreadPool::ThreadPool (std::size_t concurrency)
+    : queued_(0), stop_(false)
+  {
+    concurrency = std::max<std::size_t>(concurrency, 1);
+    for (std::size_t i = 0; i < concurrency; ++i)
+      queues_.push_back(std::make_unique<Queue>());
+    for (std::size_t i = 1; i < concurrency; ++i)
+      workers_.emplace_back([this, i] { work(i); });
+  }
+
+  ThreadPool::~ThreadPool ()
+  {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex_);
+      stop_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+
+    // without workers the remaining tasks are executed here
+    while (tryRunPendingTask()) {}
+  }
+
+  void ThreadPool::submit (Task task)
+  {
+    Queue& queue = *queues_[threadIndex()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+      ++queued_;
+    }
+    // acquire the sleep mutex to make sure that no worker is between
+    // checking for work and going to sleep
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wakeUp_.notify_one();
+  }
+
+  bool ThreadPool::popTask (std::size_t index, Task& task)
+  {
+    if (queued_ == 0)
+      return false;
+
+    // our own queue first: LIFO for workers, FIFO for the shared queue
+    {
+      Queue& queue = *queues_[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        if (index == 0) {
+          task = std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+        }
+        else {
+          task = std::move(queue.tasks.back());
+          queue.tasks.pop_back();
+        }
+        --queued_;
+        return true;
+      }
+    }
+
+    // steal the oldest task of one of the other queues
+    const std::size_t n = queues_.size();
+    for (std::size_t k = 1; k < n; ++k) {
+      Queue& queue = *queues_[(index + k) % n];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        --queued_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ThreadPool::tryRunPendingTask ()
+  {
+    Task task;
+    if (!popTask(threadIndex(), task))
+      return false;
+    task();
+    return true;
+  }
+
+  void ThreadPool::work (std::size_t index)
+  {
+    currentPool_ = this;
+    currentIndex_ = index;
+
+    while (true) {
+      if (tryRunPendingTask())
+        continue;
+
+      std::unique_lock<std::mutex> lock(sleepMutex_);
+      wakeUp_.wait(lock, [this] { return stop_ || queued_ > 0; });
+      if (stop_ && queued_ == 0)
+        return;
+    }
+  }
+
+  ThreadPool& ThreadPool::instance ()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  std::size_t ThreadPool::defaultConcurrency ()
+  {
+    if (const char* env = std::getenv("DUNE_NUM_THREADS")) {
+      try {
+        const long n = std::stol(env);
+        if (n > 0)
+          return n;
+      }
+      catch (std::exception&) {}
+      DUNE_THROW(RangeError, "DUNE_NUM_THREADS=" << env << " is not a positive number");
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+} // end namespace Dune
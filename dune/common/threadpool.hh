@@ -0,0 +1,198 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_COMMON_THREADPOOL_HH
+#define DUNE_COMMON_THREADPOOL_HH
+
+/** \file
+ * \brief A work-stealing pool of worker threads
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Dune {
+
+  /** @addtogroup Common
+   *
+   * @{
+   */
+
+  /** \brief A pool of worker threads scheduling tasks by work stealing
+   *
+   * Every worker owns a double-ended task queue.  Tasks submitted by a
+   * worker are pushed to the back of its own queue and popped from there
+   * again (depth first), idle workers steal from the front of the queues
+   * of the other workers (breadth first).  Threads which do not belong to
+   * the pool, e.g. the main thread, submit to a shared queue.
+   *
+   * A thread waiting for tasks to finish is expected to help executing
+   * pending tasks, see TaskGroup::wait().  Hence a pool of concurrency
+   * \f$p\f$ starts \f$p-1\f$ worker threads only, and a pool of
+   * concurrency one executes all tasks in the waiting thread.
+   */
+  class ThreadPool
+  {
+  public:
+    //! type of the tasks executed by the pool
+    typedef std::function<void()> Task;
+
+    /** \brief Start a pool
+     *
+     * \param concurrency  Number of threads executing tasks, including
+     *                     the thread waiting for them.
+     */
+    explicit ThreadPool (std::size_t concurrency = defaultConcurrency());
+
+    //! Finish all pending tasks and join the worker threads
+    ~ThreadPool ();
+
+    ThreadPool (const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    //! number of threads executing tasks, including the waiting thread
+    std::size_t concurrency () const
+    {
+      return workers_.size() + 1;
+    }
+
+    /** \brief Index of the calling thread within this pool
+     *
+     * Workers are numbered from 1 to concurrency()-1, all threads not
+     * belonging to the pool get index 0.
+     */
+    std::size_t threadIndex () const
+    {
+      return (currentPool_ == this) ? currentIndex_ : 0;
+    }
+
+    //! enqueue a task for execution
+    void submit (Task task);
+
+    /** \brief Execute a single pending task, if there is one
+     *
+     * \returns whether a task was executed
+     */
+    bool tryRunPendingTask ();
+
+    /** \brief The pool shared by all parallel algorithms
+     *
+     * The pool is created on first use.  Its concurrency can be set by the
+     * environment variable DUNE_NUM_THREADS.
+     */
+    static ThreadPool& instance ();
+
+    /** \brief The default concurrency of a pool
+     *
+     * This is the value of the environment variable DUNE_NUM_THREADS if it
+     * is set, std::thread::hardware_concurrency() otherwise.
+     */
+    static std::size_t defaultConcurrency ();
+
+  private:
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+
+    void work (std::size_t index);
+    bool popTask (std::size_t index, Task& task);
+
+    // queues_[0] is shared by all threads outside the pool,
+    // queues_[i] belongs to worker i
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<std::size_t> queued_;
+    std::atomic<bool> stop_;
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+
+    static thread_local const ThreadPool* currentPool_;
+    static thread_local std::size_t currentIndex_;
+  };
+
+  /** \brief A set of tasks which can be waited for
+   *
+   * Exceptions thrown by the tasks are caught and the first one is
+   * rethrown by wait().
+   */
+  class TaskGroup
+  {
+  public:
+    explicit TaskGroup (ThreadPool& pool = ThreadPool::instance())
+      : pool_(pool), pending_(0)
+    {}
+
+    TaskGroup (const TaskGroup&) = delete;
+    TaskGroup& operator= (const TaskGroup&) = delete;
+
+    //! wait for the remaining tasks before the group goes out of scope
+    ~TaskGroup ()
+    {
+      waitForTasks();
+    }
+
+    //! submit a task to the pool
+    template<class F>
+    void run (F&& f)
+    {
+      ++pending_;
+      pool_.submit([this, f = std::forward<F>(f)] () mutable {
+          try {
+            f();
+          }
+          catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            if (!error_)
+              error_ = std::current_exception();
+          }
+          --pending_;
+        });
+    }
+
+    /** \brief Execute pending tasks until all tasks of the group are finished
+     *
+     * Rethrows the first exception thrown by any of the tasks.
+     */
+    void wait ()
+    {
+      waitForTasks();
+      if (error_)
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    //! the pool executing the tasks
+    ThreadPool& pool () const
+    {
+      return pool_;
+    }
+
+  private:
+    void waitForTasks ()
+    {
+      while (pending_ > 0)
+        if (!pool_.tryRunPendingTask())
+          std::this_thread::yield();
+    }
+
+    ThreadPool& pool_;
+    std::atomic<std::size_t> pending_;
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+  };
+
+  /** @} */
+
+} // end namespace Dune
+
+#endif // DUNE_COMMON_THREADPOOL_HH
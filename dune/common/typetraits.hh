@@ -186,6 +186,27 @@ namespace Dune
       : public std::integral_constant<bool, std::is_floating_point<T>::value> {
   };
 
+#endif // DOXYGEN
+
+  //! \brief Whether objects of this type can be moved to another address by copying their bytes
+  /**
+   * This holds for all trivially copyable types by default.  Types which
+   * are not trivially copyable, but contain no pointers into themselves
+   * and need no notification when moved, may specialize this to `true`.
+   * Containers may then relocate their entries by `std::memcpy`.
+   */
+  template <typename T>
+  struct IsTriviallyRelocatable
+      : public std::integral_constant<bool, std::is_trivially_copyable<T>::value> {
+  };
+
+#ifndef DOXYGEN
+
+  template <typename T>
+  struct IsTriviallyRelocatable<std::complex<T>>
+      : public std::integral_constant<bool, IsTriviallyRelocatable<T>::value> {
+  };
+
 #endif // DOXYGEN
 
   //! \brief Whether this type has a value of NaN.
@@ -197,5 +218,18 @@ namespace Dune
   struct [[deprecated("Has been renamed to 'HasNaN'.")]] has_nan
     : HasNaN<T> {};
 
+  /**
+   * \brief A type that refers to another type.
+   *
+   * MetaType<T> is an empty literal class, even if `T` is incomplete or
+   * abstract, so it can be used to pass types to generic lambdas.  The
+   * referred-to type is available as the typedef `type`.
+   */
+  template<class T>
+  struct MetaType {
+    //! The referred-to type
+    using type = T;
+  };
+
 }
 #endif